@@ -41,6 +41,7 @@
 #include <stdio.h>
 
 #include "antelope.h"
+#include "storage.h"
 
 static db_output_function_t output = printf;
 
@@ -158,3 +159,10 @@ db_processing(db_handle_t *handle)
 {
   return handle->flags & DB_HANDLE_FLAG_PROCESSING;
 }
+
+/* Write the rows that are buffered for series relations. */
+db_result_t
+db_flush(void)
+{
+  return storage_flush();
+}
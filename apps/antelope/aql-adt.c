@@ -87,6 +87,7 @@ aql_clear(aql_adt_t *adt)
   adt->attribute_count = 0;
   adt->value_count = 0;
   adt->flags = 0;
+  adt->group_window = 0;
   memset(adt->aggregators, 0, sizeof(adt->aggregators));
 }
 
@@ -120,6 +121,34 @@ aql_add_attribute(aql_adt_t *adt, char *name, domain_t domain,
   return DB_OK;
 }
 
+db_result_t
+aql_set_group(aql_adt_t *adt, char *name, long window)
+{
+  int i;
+
+  /* Group by a projected attribute if there is one; otherwise add
+     the attribute for processing only. */
+  for(i = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
+    if(adt->aggregators[i] == AQL_NONE &&
+       strcmp(adt->attributes[i].name, name) == 0) {
+      break;
+    }
+  }
+
+  if(i == AQL_ATTRIBUTE_COUNT(adt)) {
+    if(DB_ERROR(aql_add_attribute(adt, name, DOMAIN_UNSPECIFIED, 0, 0))) {
+      return DB_LIMIT_ERROR;
+    }
+    adt->attributes[i].flags = ATTRIBUTE_FLAG_NO_STORE;
+  }
+
+  adt->group_attribute = i;
+  adt->group_window = window;
+  adt->flags |= AQL_FLAG_GROUP | AQL_FLAG_AGGREGATE;
+
+  return DB_OK;
+}
+
 db_result_t
 aql_add_value(aql_adt_t *adt, domain_t domain, void *value_ptr)
 {
@@ -112,7 +112,9 @@ aql_execute(db_handle_t *handle, aql_adt_t *adt)
     result = index_create(AQL_GET_INDEX_TYPE(adt), rel, relattr);
     break;
   case AQL_TYPE_CREATE_RELATION:
-    if(relation_create(adt->relations[0], DB_STORAGE) != NULL) {
+    if(relation_create(adt->relations[0], DB_STORAGE,
+                       AQL_GET_FLAGS(adt) & AQL_FLAG_SERIES ?
+                       RELATION_FLAG_SERIES : 0) != NULL) {
       result = DB_OK;
     }
     break;
@@ -73,6 +73,7 @@ static const struct keyword keywords[] = {
   {"IS", IS},
   {"ON", ON},
   {"IN", IN},
+  {"BY", BY},
 
   {"AND", AND},
   {"NOT", NOT},
@@ -91,6 +92,8 @@ static const struct keyword keywords[] = {
   {"WHERE", WHERE},
   {"COUNT", COUNT},
   {"INDEX", INDEX},
+  {"BTREE", BTREE},
+  {"GROUP", GROUP},
 
   {"INSERT", INSERT},
   {"SELECT", SELECT},
@@ -100,6 +103,8 @@ static const struct keyword keywords[] = {
   {"DOMAIN", DOMAIN},
   {"STRING", STRING},
   {"INLINE", INLINE},
+  {"WINDOW", WINDOW},
+  {"SERIES", SERIES},
 
   {"PROJECT", PROJECT},
   {"MAXHEAP", MAXHEAP},
@@ -111,7 +116,7 @@ static const struct keyword keywords[] = {
 };
 
 /* Provides a pointer to the first keyword of a specific length. */
-static const int8_t skip_hint[] = {0, 13, 21, 27, 33, 36, 44, 47, 48};
+static const int8_t skip_hint[] = {0, 13, 22, 28, 34, 39, 49, 52, 53};
 
 static char separators[] = "#.;,() \t\n";
 
@@ -441,11 +441,47 @@ PARSER(where)
     }
   }
 
+  if(p.error) {
+    /* The expression does not fit in the bytecode buffer. */
+    RETURN(SYNTAX_ERROR);
+  }
+
   lvm_print_code(&p);
 
   return OK;
 }
 
+PARSER(group)
+{
+  char name[sizeof(VALUE)];
+  long window;
+
+  CONSUME(BY);
+  CONSUME(IDENTIFIER);
+
+  PRINTF("Group by attribute %s\n", VALUE);
+  memcpy(name, VALUE, sizeof(name));
+
+  window = 0;
+  NEXT;
+  if(TOKEN == WINDOW) {
+    CONSUME(INTEGER_VALUE);
+    window = *(long *)lexer->value;
+    if(window <= 0) {
+      RETURN(SYNTAX_ERROR);
+    }
+    PRINTF("Time window of %ld\n", window);
+  } else {
+    REWIND;
+  }
+
+  if(DB_ERROR(aql_set_group(adt, name, window))) {
+    RETURN(SYNTAX_ERROR);
+  }
+
+  RETURN(OK);
+}
+
 PARSER(join)
 {
   AQL_SET_TYPE(adt, AQL_TYPE_JOIN);
@@ -494,6 +530,11 @@ PARSER(select)
   }
 
   NEXT;
+  if(TOKEN != WHERE && TOKEN != GROUP) {
+    REWIND;
+    RETURN(OK);
+  }
+
   if(TOKEN == WHERE) {
     lvm_reset(&p, vmcode, sizeof(vmcode));
 
@@ -502,12 +543,19 @@ PARSER(select)
     }
 
     AQL_SET_CONDITION(adt, &p);
-  } else {
-    REWIND;
-    RETURN(OK);
+    NEXT;
   }
 
-  CONSUME(END);
+  if(TOKEN == GROUP) {
+    if(!PARSE(group)) {
+      RETURN(SYNTAX_ERROR);
+    }
+    NEXT;
+  }
+
+  if(TOKEN != END) {
+    RETURN(SYNTAX_ERROR);
+  }
 
   return OK;
 }
@@ -645,6 +693,9 @@ PARSER_TOKEN(index_type)
   case MEMHASH:
     type = INDEX_MEMHASH;
     break;
+  case BTREE:
+    type = INDEX_BTREE;
+    break;
   default:
     return NONE;
   };
@@ -682,6 +733,14 @@ PARSER(create_relation)
   AQL_SET_TYPE(adt, AQL_TYPE_CREATE_RELATION);
   AQL_ADD_RELATION(adt, VALUE);
 
+  NEXT;
+  if(TOKEN == TYPE) {
+    CONSUME(SERIES);
+    adt->flags |= AQL_FLAG_SERIES;
+  } else {
+    REWIND;
+  }
+
   RETURN(OK);
 }
 
@@ -76,34 +76,39 @@ enum token {
   IS = 18,
   ON = 19,
   IN = 20,
-  AND = 21,
-  NOT = 22,
-  SUM = 23,
-  MAX = 24,
-  MIN = 25,
-  INT = 26,
-  INTO = 27,
-  FROM = 28,
-  MEAN = 29,
-  JOIN = 30,
-  LONG = 31,
-  TYPE = 32,
-  WHERE = 33,
-  COUNT = 34,
-  INDEX = 35,
-  INSERT = 36,
-  SELECT = 37,
-  REMOVE = 38,
-  CREATE = 39,
-  MEDIAN = 40,
-  DOMAIN = 41,
-  STRING = 42,
-  INLINE = 43,
-  PROJECT = 44,
-  MAXHEAP = 45,
-  MEMHASH = 46,
-  RELATION = 47,
-  ATTRIBUTE = 48,
+  BY = 21,
+  AND = 22,
+  NOT = 23,
+  SUM = 24,
+  MAX = 25,
+  MIN = 26,
+  INT = 27,
+  INTO = 28,
+  FROM = 29,
+  MEAN = 30,
+  JOIN = 31,
+  LONG = 32,
+  TYPE = 33,
+  WHERE = 34,
+  COUNT = 35,
+  INDEX = 36,
+  BTREE = 37,
+  GROUP = 38,
+  INSERT = 39,
+  SELECT = 40,
+  REMOVE = 41,
+  CREATE = 42,
+  MEDIAN = 43,
+  DOMAIN = 44,
+  STRING = 45,
+  INLINE = 46,
+  WINDOW = 47,
+  SERIES = 48,
+  PROJECT = 49,
+  MAXHEAP = 50,
+  MEMHASH = 51,
+  RELATION = 52,
+  ATTRIBUTE = 53,
 
   INTEGER_VALUE = 251,
   FLOAT_VALUE = 252,
@@ -151,6 +156,8 @@ struct aql_adt {
   aql_aggregator_t aggregators[AQL_ATTRIBUTE_LIMIT];
   attribute_value_t values[AQL_ATTRIBUTE_LIMIT];
   index_type_t index_type;
+  long group_window;
+  uint8_t group_attribute;
   uint8_t relation_count;
   uint8_t attribute_count;
   uint8_t value_count;
@@ -179,6 +186,8 @@ typedef struct aql_adt aql_adt_t;
 #define AQL_FLAG_AGGREGATE		1
 #define AQL_FLAG_ASSIGN			2
 #define AQL_FLAG_INVERSE_LOGIC		4
+#define AQL_FLAG_GROUP			8
+#define AQL_FLAG_SERIES			16
 
 #define AQL_CLEAR(adt)			aql_clear(adt)
 #define AQL_SET_TYPE(adt, type)	(((adt))->optype = (type))
@@ -215,6 +224,7 @@ db_result_t aql_add_attribute(aql_adt_t *adt, char *name,
                                domain_t domain, unsigned element_size,
                                int processed_only);
 db_result_t aql_add_value(aql_adt_t *adt, domain_t domain, void *value);
+db_result_t aql_set_group(aql_adt_t *adt, char *name, long window);
 db_result_t db_query(db_handle_t *handle, const char *format, ...);
 db_result_t db_process(db_handle_t *handle);
 
@@ -64,6 +64,11 @@
 #define DB_FEATURE_COFFEE		1
 #endif /* DB_FEATURE_COFFEE */
 
+/* Support relations stored as compressed time series. */
+#ifndef DB_FEATURE_SERIES
+#define DB_FEATURE_SERIES		1
+#endif /* DB_FEATURE_SERIES */
+
 /* Enable basic data integrity checks. */
 #ifndef DB_FEATURE_INTEGRITY
 #define DB_FEATURE_INTEGRITY		0
@@ -104,6 +109,78 @@
 #endif /* DB_MAX_ELEMENT_SIZE */
 
 
+/* The size of the buffer used for reading the rows of a relation
+   in blocks during a scan. Joins use a second buffer of the same size. */
+#ifndef DB_SCAN_BLOCK_SIZE
+#define DB_SCAN_BLOCK_SIZE		512
+#endif /* DB_SCAN_BLOCK_SIZE */
+
+/* The number of attribute values that are decoded at a time when the
+   predicate of a full scan is evaluated over the rows of a block. */
+#ifndef DB_PREDICATE_BATCH_SIZE
+#define DB_PREDICATE_BATCH_SIZE		32
+#endif /* DB_PREDICATE_BATCH_SIZE */
+
+/* The size of the blocks in which series relations store their rows.
+   Each block holds the columns of a run of rows in compressed form,
+   and the minimum and maximum values of each numeric column. */
+#ifndef DB_SERIES_BLOCK_SIZE
+#define DB_SERIES_BLOCK_SIZE		256
+#endif /* DB_SERIES_BLOCK_SIZE */
+
+/* The size of the buffers in which rows inserted into a series relation
+   are collected until they are written as a block. At most 255 rows
+   are written in a block. */
+#ifndef DB_SERIES_BUFFER_SIZE
+#define DB_SERIES_BUFFER_SIZE		512
+#endif /* DB_SERIES_BUFFER_SIZE */
+
+/* The number of series relations that can be inserted into at the same
+   time without writing partially filled blocks. Each one takes a buffer
+   of DB_SERIES_BUFFER_SIZE bytes; when all are in use, the least
+   recently used buffer is written out. */
+#ifndef DB_SERIES_BUFFERS
+#define DB_SERIES_BUFFERS		2
+#endif /* DB_SERIES_BUFFERS */
+
+/* The number of keys in the in-memory table of a hash join. The table
+   is built over the smaller relation; larger relations are split into
+   partitions that are spilled to storage. */
+#ifndef DB_JOIN_TABLE_SIZE
+#define DB_JOIN_TABLE_SIZE		64
+#endif /* DB_JOIN_TABLE_SIZE */
+
+/* The number of hash buckets in the join table. */
+#ifndef DB_JOIN_BUCKETS
+#define DB_JOIN_BUCKETS			16
+#endif /* DB_JOIN_BUCKETS */
+
+/* The maximum number of partitions of a hash join. Partitions that
+   still do not fit in the table are joined in several rounds. This
+   must not exceed DB_JOIN_TABLE_SIZE. */
+#ifndef DB_JOIN_PARTITIONS
+#define DB_JOIN_PARTITIONS		8
+#endif /* DB_JOIN_PARTITIONS */
+
+/* An index nested-loop join is chosen over a hash join when the right
+   relation is indexed and has at least this many times more rows than
+   the left relation. */
+#ifndef DB_JOIN_INDEX_RATIO
+#define DB_JOIN_INDEX_RATIO		16
+#endif /* DB_JOIN_INDEX_RATIO */
+
+/* The number of groups that an aggregation keeps in RAM. Queries with
+   more groups make additional passes over the relation, unless the
+   relation is sorted on the grouping attribute. */
+#ifndef DB_GROUP_LIMIT
+#define DB_GROUP_LIMIT			16
+#endif /* DB_GROUP_LIMIT */
+
+/* The number of hash buckets used for finding groups. */
+#ifndef DB_GROUP_BUCKETS
+#define DB_GROUP_BUCKETS		8
+#endif /* DB_GROUP_BUCKETS */
+
 /* The maximum size of the LVM bytecode compiled from a
    single database query. */
 #ifndef DB_VM_BYTECODE_SIZE
@@ -206,6 +283,38 @@
 #define DB_HEAP_CACHE_LIMIT		1
 #endif /* DB_HEAP_CACHE_LIMIT */
 
+/* The maximum number of B+-tree indexes. */
+#ifndef DB_BTREE_INDEX_LIMIT
+#define DB_BTREE_INDEX_LIMIT		1
+#endif /* DB_BTREE_INDEX_LIMIT */
+
+/* The size of a B+-tree page in bytes. */
+#ifndef DB_BTREE_PAGE_SIZE
+#define DB_BTREE_PAGE_SIZE		128
+#endif /* DB_BTREE_PAGE_SIZE */
+
+/* The number of B+-tree pages cached in RAM. */
+#ifndef DB_BTREE_CACHE_SIZE
+#define DB_BTREE_CACHE_SIZE		4
+#endif /* DB_BTREE_CACHE_SIZE */
+
+/* The number of pages reserved for a new B+-tree file, in addition to
+   the pages that the rows of the relation need at that point. The file
+   grows when more pages are needed. Each leaf page holds
+   (DB_BTREE_PAGE_SIZE - 4) / 8 keys. */
+#ifndef DB_BTREE_RESERVE_PAGES
+#define DB_BTREE_RESERVE_PAGES		64
+#endif /* DB_BTREE_RESERVE_PAGES */
+
+/* The maximum number of pages in a B+-tree file. Page ids are 16 bits,
+   so this is at most 65534. With the default page size, a full tree
+   holds about 930000 keys that are inserted in order, or about 630000
+   keys that are inserted in random order. An insert into a relation
+   with a full B+-tree index fails with DB_INDEX_ERROR. */
+#ifndef DB_BTREE_MAX_PAGES
+#define DB_BTREE_MAX_PAGES		65534
+#endif /* DB_BTREE_MAX_PAGES */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
@@ -0,0 +1,821 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *     BTree - A persistent B+-tree index for flash memory.
+ *
+ *     The tree is stored in a single file of fixed-size pages. Page 0
+ *     holds the tree metadata, and the other pages are either leaves,
+ *     which store sorted (key, tuple id) pairs and are linked to their
+ *     right sibling, or branches, which store separator keys and the
+ *     ids of their child pages. Range queries descend to the leaf of
+ *     the lowest key and then follow the leaf links. The file is
+ *     created large enough for the rows that the relation has at that
+ *     point, and it grows when more pages are allocated.
+ *
+ *     Pages are accessed through a small write-back cache, so that a
+ *     page modified several times during an operation is written to
+ *     flash only once. When a key is appended at the right edge of the
+ *     tree, which is the normal case for timestamps and sequence
+ *     numbers, a full page is not split in half. Instead the new key
+ *     starts a new page, so that pages are filled completely and are
+ *     not rewritten after they have been left behind.
+ *
+ *     Existing relations are bulk loaded by reading the rows in
+ *     blocks, sorting the keys of each block, and inserting them while
+ *     deferring the page writes to cache evictions.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "cfs/cfs.h"
+#include "lib/memb.h"
+
+#include "db-options.h"
+#include "index.h"
+#include "result.h"
+#include "storage.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#if DB_BTREE_CACHE_SIZE < 2
+#error "The B+-tree page cache must hold at least two pages."
+#endif
+
+typedef int32_t btree_key_t;
+typedef uint16_t btree_page_id_t;
+
+/* The sizes of the page header, a key, a tuple id, and a page id. */
+#define PAGE_HEADER_SIZE	4
+#define KEY_SIZE		4
+#define TUPLE_ID_SIZE		4
+#define PAGE_ID_SIZE		2
+
+#define LEAF_CAPACITY		((DB_BTREE_PAGE_SIZE - PAGE_HEADER_SIZE) / \
+                                 (KEY_SIZE + TUPLE_ID_SIZE))
+#define BRANCH_CAPACITY		((DB_BTREE_PAGE_SIZE - PAGE_HEADER_SIZE - \
+                                  PAGE_ID_SIZE) / (KEY_SIZE + PAGE_ID_SIZE))
+
+#if LEAF_CAPACITY < 3 || BRANCH_CAPACITY < 3
+#error "DB_BTREE_PAGE_SIZE is too small."
+#endif
+
+#if LEAF_CAPACITY > 255 || BRANCH_CAPACITY > 255
+#error "DB_BTREE_PAGE_SIZE is too large."
+#endif
+
+#if DB_BTREE_MAX_PAGES > 65534
+#error "DB_BTREE_MAX_PAGES is larger than the 16-bit page ids allow."
+#endif
+
+/* The maximum height of the tree. */
+#define MAX_HEIGHT		8
+
+/* The bulk load scan block holds at least one row of the largest
+   size that a relation can have. */
+#define MAX_ROW_LENGTH		(DB_MAX_ATTRIBUTES_PER_RELATION * \
+                                 DB_MAX_ELEMENT_SIZE)
+#if MAX_ROW_LENGTH > DB_BTREE_PAGE_SIZE
+#define LOAD_BLOCK_SIZE		MAX_ROW_LENGTH
+#else
+#define LOAD_BLOCK_SIZE		DB_BTREE_PAGE_SIZE
+#endif
+
+#define PAGE_LEAF		0x01
+
+#define NO_PAGE			0
+
+struct btree_page {
+  uint8_t flags;
+  uint8_t count;
+  btree_page_id_t next;
+  union {
+    struct {
+      btree_key_t keys[LEAF_CAPACITY];
+      tuple_id_t values[LEAF_CAPACITY];
+    } leaf;
+    struct {
+      btree_key_t keys[BRANCH_CAPACITY];
+      btree_page_id_t children[BRANCH_CAPACITY + 1];
+    } branch;
+  } u;
+};
+
+struct btree_meta {
+  btree_page_id_t root;
+  btree_page_id_t page_count;
+  uint8_t height;
+};
+
+struct btree {
+  db_storage_id_t fd;
+  struct btree_meta meta;
+  uint8_t meta_dirty;
+  /* The next tuple to insert when bulk loading. */
+  tuple_id_t load_next;
+};
+typedef struct btree btree_t;
+
+struct page_cache {
+  btree_t *tree;
+  btree_page_id_t id;
+  uint8_t dirty;
+  uint16_t last_use;
+  struct btree_page page;
+};
+
+#define CACHE_ENTRY(p) \
+  ((struct page_cache *)((char *)(p) - offsetof(struct page_cache, page)))
+
+/* Keep a cache of pages read from storage. */
+static struct page_cache page_cache[DB_BTREE_CACHE_SIZE];
+static uint16_t cache_clock;
+MEMB(btrees, btree_t, DB_BTREE_INDEX_LIMIT);
+
+static db_result_t create(index_t *);
+static db_result_t destroy(index_t *);
+static db_result_t load(index_t *);
+static db_result_t release(index_t *);
+static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t delete(index_t *, attribute_value_t *);
+static tuple_id_t get_next(index_iterator_t *);
+static db_result_t bulk_load(index_t *);
+
+index_api_t index_btree = {
+  INDEX_BTREE,
+  INDEX_API_EXTERNAL | INDEX_API_RANGE_QUERIES,
+  create,
+  destroy,
+  load,
+  release,
+  insert,
+  delete,
+  get_next,
+  bulk_load
+};
+
+static db_result_t
+page_write(struct page_cache *entry)
+{
+  if(DB_ERROR(storage_write(entry->tree->fd, &entry->page,
+                            (unsigned long)entry->id * sizeof(entry->page),
+                            sizeof(entry->page)))) {
+    PRINTF("DB: Failed to write B+-tree page %u\n", (unsigned)entry->id);
+    return DB_STORAGE_ERROR;
+  }
+  entry->dirty = 0;
+  return DB_OK;
+}
+
+/*
+ * Get a page through the cache. The least recently used page is
+ * evicted if the page is not cached. A new page is not read from
+ * storage but cleared. Because the page that was accessed last is
+ * never evicted, a caller may use two pages at a time.
+ */
+static struct btree_page *
+page_get(btree_t *tree, btree_page_id_t id, int new_page)
+{
+  struct page_cache *entry;
+  struct page_cache *victim;
+  int i;
+
+  victim = NULL;
+  for(i = 0; i < DB_BTREE_CACHE_SIZE; i++) {
+    entry = &page_cache[i];
+    if(entry->tree == tree && entry->id == id) {
+      entry->last_use = ++cache_clock;
+      return &entry->page;
+    }
+    if(victim == NULL ||
+       (victim->tree != NULL &&
+        (entry->tree == NULL ||
+         (uint16_t)(cache_clock - entry->last_use) >
+         (uint16_t)(cache_clock - victim->last_use)))) {
+      victim = entry;
+    }
+  }
+
+  if(victim->tree != NULL && victim->dirty &&
+     DB_ERROR(page_write(victim))) {
+    return NULL;
+  }
+
+  victim->tree = NULL;
+  if(new_page) {
+    memset(&victim->page, 0, sizeof(victim->page));
+  } else if(DB_ERROR(storage_read(tree->fd, &victim->page,
+                                  (unsigned long)id * sizeof(victim->page),
+                                  sizeof(victim->page)))) {
+    PRINTF("DB: Failed to read B+-tree page %u\n", (unsigned)id);
+    return NULL;
+  }
+
+  victim->tree = tree;
+  victim->id = id;
+  victim->dirty = new_page;
+  victim->last_use = ++cache_clock;
+
+  return &victim->page;
+}
+
+static void
+page_set_dirty(struct btree_page *page)
+{
+  CACHE_ENTRY(page)->dirty = 1;
+}
+
+static struct btree_page *
+page_allocate(btree_t *tree, btree_page_id_t *id)
+{
+  if((unsigned long)tree->meta.page_count >= DB_BTREE_MAX_PAGES + 1UL) {
+    PRINTF("DB: The B+-tree has reached its maximum size\n");
+    return NULL;
+  }
+
+  *id = tree->meta.page_count++;
+  tree->meta_dirty = 1;
+  return page_get(tree, *id, 1);
+}
+
+static db_result_t
+flush(btree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BTREE_CACHE_SIZE; i++) {
+    if(page_cache[i].tree == tree && page_cache[i].dirty &&
+       DB_ERROR(page_write(&page_cache[i]))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  if(tree->meta_dirty) {
+    if(DB_ERROR(storage_write(tree->fd, &tree->meta, 0,
+                              sizeof(tree->meta)))) {
+      return DB_STORAGE_ERROR;
+    }
+    tree->meta_dirty = 0;
+  }
+
+  return DB_OK;
+}
+
+static void
+invalidate_cache(btree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BTREE_CACHE_SIZE; i++) {
+    if(page_cache[i].tree == tree) {
+      page_cache[i].tree = NULL;
+    }
+  }
+}
+
+/* The number of keys that are smaller than the key, or also
+   equal to it if "inclusive" is set. */
+static unsigned
+search(const btree_key_t *keys, unsigned count, long key, int inclusive)
+{
+  unsigned low;
+  unsigned high;
+  unsigned mid;
+
+  low = 0;
+  high = count;
+  while(low < high) {
+    mid = low + (high - low) / 2;
+    if(keys[mid] < key || (inclusive && keys[mid] == key)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+static void
+leaf_insert(struct btree_page *page, unsigned pos,
+            btree_key_t key, tuple_id_t value)
+{
+  unsigned n;
+
+  n = page->count - pos;
+  memmove(&page->u.leaf.keys[pos + 1], &page->u.leaf.keys[pos],
+          n * sizeof(btree_key_t));
+  memmove(&page->u.leaf.values[pos + 1], &page->u.leaf.values[pos],
+          n * sizeof(tuple_id_t));
+  page->u.leaf.keys[pos] = key;
+  page->u.leaf.values[pos] = value;
+  page->count++;
+}
+
+static void
+branch_insert(struct btree_page *page, unsigned pos,
+              btree_key_t key, btree_page_id_t child)
+{
+  unsigned n;
+
+  n = page->count - pos;
+  memmove(&page->u.branch.keys[pos + 1], &page->u.branch.keys[pos],
+          n * sizeof(btree_key_t));
+  memmove(&page->u.branch.children[pos + 2], &page->u.branch.children[pos + 1],
+          n * sizeof(btree_page_id_t));
+  page->u.branch.keys[pos] = key;
+  page->u.branch.children[pos + 1] = child;
+  page->count++;
+}
+
+static db_result_t
+tree_insert(btree_t *tree, btree_key_t key, tuple_id_t value)
+{
+  btree_page_id_t path[MAX_HEIGHT];
+  uint8_t slots[MAX_HEIGHT];
+  struct btree_page *page;
+  struct btree_page *right;
+  btree_page_id_t id;
+  btree_page_id_t right_id;
+  btree_key_t separator;
+  btree_key_t up;
+  unsigned pos;
+  unsigned mid;
+  int level;
+  int rightmost;
+
+  /* Descend to the leaf, remembering the path. Equal keys are placed
+     after the existing ones. */
+  rightmost = 1;
+  id = tree->meta.root;
+  for(level = 0; level < tree->meta.height - 1; level++) {
+    page = page_get(tree, id, 0);
+    if(page == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+    pos = search(page->u.branch.keys, page->count, key, 1);
+    if(pos < page->count) {
+      rightmost = 0;
+    }
+    path[level] = id;
+    slots[level] = pos;
+    id = page->u.branch.children[pos];
+  }
+
+  page = page_get(tree, id, 0);
+  if(page == NULL) {
+    return DB_STORAGE_ERROR;
+  }
+  pos = search(page->u.leaf.keys, page->count, key, 1);
+  if(page->count < LEAF_CAPACITY) {
+    leaf_insert(page, pos, key, value);
+    page_set_dirty(page);
+    return DB_OK;
+  }
+
+  right = page_allocate(tree, &right_id);
+  if(right == NULL) {
+    return DB_INDEX_ERROR;
+  }
+  right->flags = PAGE_LEAF;
+
+  if(rightmost && pos == page->count) {
+    /* Appending: keep the full page and start a new one. */
+    leaf_insert(right, 0, key, value);
+  } else {
+    mid = page->count / 2;
+    right->count = page->count - mid;
+    memcpy(right->u.leaf.keys, &page->u.leaf.keys[mid],
+           right->count * sizeof(btree_key_t));
+    memcpy(right->u.leaf.values, &page->u.leaf.values[mid],
+           right->count * sizeof(tuple_id_t));
+    page->count = mid;
+    if(pos <= mid) {
+      leaf_insert(page, pos, key, value);
+    } else {
+      leaf_insert(right, pos - mid, key, value);
+    }
+  }
+  right->next = page->next;
+  page->next = right_id;
+  page_set_dirty(page);
+  separator = right->u.leaf.keys[0];
+
+  /* Insert the separator of the new page into the parent, and split
+     the parent as well if it is full. */
+  for(level = tree->meta.height - 2; level >= 0; level--) {
+    page = page_get(tree, path[level], 0);
+    if(page == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+    pos = slots[level];
+    page_set_dirty(page);
+    if(page->count < BRANCH_CAPACITY) {
+      branch_insert(page, pos, separator, right_id);
+      return DB_OK;
+    }
+
+    id = right_id;
+    right = page_allocate(tree, &right_id);
+    if(right == NULL) {
+      return DB_INDEX_ERROR;
+    }
+
+    if(rightmost && pos == page->count) {
+      right->u.branch.children[0] = id;
+    } else {
+      /* The middle key moves up to the parent. */
+      mid = page->count / 2;
+      up = page->u.branch.keys[mid];
+      right->count = page->count - mid - 1;
+      memcpy(right->u.branch.keys, &page->u.branch.keys[mid + 1],
+             right->count * sizeof(btree_key_t));
+      memcpy(right->u.branch.children, &page->u.branch.children[mid + 1],
+             (right->count + 1) * sizeof(btree_page_id_t));
+      page->count = mid;
+      if(pos <= mid) {
+        branch_insert(page, pos, separator, id);
+      } else {
+        branch_insert(right, pos - mid - 1, separator, id);
+      }
+      separator = up;
+    }
+  }
+
+  /* The root was split; grow the tree by one level. */
+  if(tree->meta.height >= MAX_HEIGHT) {
+    return DB_INDEX_ERROR;
+  }
+  id = right_id;
+  page = page_allocate(tree, &right_id);
+  if(page == NULL) {
+    return DB_INDEX_ERROR;
+  }
+  page->count = 1;
+  page->u.branch.keys[0] = separator;
+  page->u.branch.children[0] = tree->meta.root;
+  page->u.branch.children[1] = id;
+  tree->meta.root = right_id;
+  tree->meta.height++;
+
+  return DB_OK;
+}
+
+static db_result_t
+create(index_t *index)
+{
+  char *filename;
+  btree_t *tree;
+  struct btree_page *page;
+  tuple_id_t cardinality;
+  unsigned long pages;
+
+  /* Reserve room for the keys of the existing rows in half-full leaves.
+     The file grows if the tree needs more pages later. */
+  pages = DB_BTREE_RESERVE_PAGES;
+  cardinality = relation_cardinality(index->rel);
+  if(cardinality != INVALID_TUPLE) {
+    pages += 2 * (unsigned long)cardinality / LEAF_CAPACITY;
+  }
+  if(pages > DB_BTREE_MAX_PAGES) {
+    pages = DB_BTREE_MAX_PAGES;
+  }
+
+  filename = storage_generate_file("btree",
+                                   (pages + 1) * sizeof(struct btree_page));
+  if(filename == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return DB_INDEX_ERROR;
+  }
+
+  memcpy(index->descriptor_file, filename,
+         sizeof(index->descriptor_file));
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    cfs_remove(index->descriptor_file);
+    index->descriptor_file[0] = '\0';
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->fd = storage_open(index->descriptor_file);
+  if(tree->fd < 0) {
+    goto error;
+  }
+
+  /* The tree starts as a single empty leaf. */
+  tree->meta.root = 1;
+  tree->meta.page_count = 1;
+  tree->meta.height = 1;
+  tree->meta_dirty = 1;
+  tree->load_next = 0;
+
+  page = page_allocate(tree, &tree->meta.root);
+  if(page == NULL) {
+    goto error;
+  }
+  page->flags = PAGE_LEAF;
+
+  if(DB_ERROR(flush(tree))) {
+    goto error;
+  }
+
+  PRINTF("DB: Created a B+-tree index in %s with %u keys per leaf\n",
+         index->descriptor_file, (unsigned)LEAF_CAPACITY);
+  return DB_OK;
+
+error:
+  invalidate_cache(tree);
+  storage_close(tree->fd);
+  memb_free(&btrees, tree);
+  cfs_remove(index->descriptor_file);
+  index->descriptor_file[0] = '\0';
+  return DB_STORAGE_ERROR;
+}
+
+static db_result_t
+destroy(index_t *index)
+{
+  /* The index has been released at this point. */
+  cfs_remove(index->descriptor_file);
+  return DB_OK;
+}
+
+static db_result_t
+load(index_t *index)
+{
+  btree_t *tree;
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->fd = storage_open(index->descriptor_file);
+  if(tree->fd < 0 ||
+     DB_ERROR(storage_read(tree->fd, &tree->meta, 0, sizeof(tree->meta))) ||
+     tree->meta.height == 0 || tree->meta.height > MAX_HEIGHT) {
+    storage_close(tree->fd);
+    memb_free(&btrees, tree);
+    return DB_STORAGE_ERROR;
+  }
+  tree->meta_dirty = 0;
+  tree->load_next = 0;
+
+  PRINTF("DB: Loaded B+-tree index from file %s, height %u, %u pages\n",
+         index->descriptor_file, (unsigned)tree->meta.height,
+         (unsigned)tree->meta.page_count);
+
+  return DB_OK;
+}
+
+static db_result_t
+release(index_t *index)
+{
+  btree_t *tree;
+  db_result_t result;
+
+  tree = index->opaque_data;
+
+  result = flush(tree);
+  invalidate_cache(tree);
+  storage_close(tree->fd);
+  memb_free(&btrees, tree);
+  return result;
+}
+
+static db_result_t
+insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+{
+  btree_t *tree;
+  db_result_t result;
+
+  tree = index->opaque_data;
+
+  result = tree_insert(tree, (btree_key_t)db_value_to_long(key), value);
+  if(DB_ERROR(result)) {
+    PRINTF("DB: Failed to insert key %ld into a B+-tree index\n",
+           db_value_to_long(key));
+    return result;
+  }
+
+  return flush(tree);
+}
+
+/* Remove all entries with the key. Emptied leaves are left in the
+   tree instead of being merged, to avoid rewriting their neighbors. */
+static db_result_t
+delete(index_t *index, attribute_value_t *value)
+{
+  btree_t *tree;
+  struct btree_page *page;
+  btree_page_id_t id;
+  long key;
+  unsigned pos;
+  unsigned end;
+  int level;
+  int found;
+
+  tree = index->opaque_data;
+  key = db_value_to_long(value);
+
+  id = tree->meta.root;
+  for(level = 0; level < tree->meta.height - 1; level++) {
+    page = page_get(tree, id, 0);
+    if(page == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+    id = page->u.branch.children[search(page->u.branch.keys, page->count,
+                                        key, 0)];
+  }
+
+  for(found = 0; id != NO_PAGE; id = page->next) {
+    page = page_get(tree, id, 0);
+    if(page == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+    pos = search(page->u.leaf.keys, page->count, key, 0);
+    end = search(page->u.leaf.keys, page->count, key, 1);
+    if(end > pos) {
+      memmove(&page->u.leaf.keys[pos], &page->u.leaf.keys[end],
+              (page->count - end) * sizeof(btree_key_t));
+      memmove(&page->u.leaf.values[pos], &page->u.leaf.values[end],
+              (page->count - end) * sizeof(tuple_id_t));
+      page->count -= end - pos;
+      page_set_dirty(page);
+      found = 1;
+    }
+    if(end < page->count) {
+      break;
+    }
+  }
+
+  if(!found) {
+    return DB_INDEX_ERROR;
+  }
+  return flush(tree);
+}
+
+static tuple_id_t
+get_next(index_iterator_t *iterator)
+{
+  static struct {
+    index_iterator_t *index_iterator;
+    btree_page_id_t page_id;
+    uint8_t slot;
+  } cursor;
+  btree_t *tree;
+  struct btree_page *page;
+  btree_page_id_t id;
+  long min;
+  long max;
+  int level;
+
+  tree = iterator->index->opaque_data;
+  min = db_value_to_long(&iterator->min_value);
+  max = db_value_to_long(&iterator->max_value);
+
+  if(cursor.index_iterator != iterator || iterator->next_item_no == 0) {
+    /* Find the first leaf that can contain the lowest key. */
+    id = tree->meta.root;
+    for(level = 0; level < tree->meta.height - 1; level++) {
+      page = page_get(tree, id, 0);
+      if(page == NULL) {
+        return INVALID_TUPLE;
+      }
+      id = page->u.branch.children[search(page->u.branch.keys, page->count,
+                                          min, 0)];
+    }
+    page = page_get(tree, id, 0);
+    if(page == NULL) {
+      return INVALID_TUPLE;
+    }
+    cursor.index_iterator = iterator;
+    cursor.page_id = id;
+    cursor.slot = search(page->u.leaf.keys, page->count, min, 0);
+  }
+
+  for(;;) {
+    page = page_get(tree, cursor.page_id, 0);
+    if(page == NULL) {
+      return INVALID_TUPLE;
+    }
+    if(cursor.slot < page->count) {
+      break;
+    }
+    if(page->next == NO_PAGE) {
+      return INVALID_TUPLE;
+    }
+    cursor.page_id = page->next;
+    cursor.slot = 0;
+  }
+
+  if(page->u.leaf.keys[cursor.slot] > max) {
+    return INVALID_TUPLE;
+  }
+
+  iterator->next_item_no++;
+  return page->u.leaf.values[cursor.slot++];
+}
+
+/*
+ * Insert the keys of the next batch of rows. The keys are sorted
+ * first, so that keys that belong in the same leaf are inserted
+ * together. Pages are written when they are evicted from the
+ * cache, and the remaining ones when the load is finished.
+ */
+static db_result_t
+bulk_load(index_t *index)
+{
+  static unsigned char block[LOAD_BLOCK_SIZE];
+  static storage_scan_t scan;
+  static btree_key_t keys[LEAF_CAPACITY];
+  static tuple_id_t ids[LEAF_CAPACITY];
+  storage_row_t row;
+  attribute_value_t value;
+  btree_t *tree;
+  db_result_t result;
+  btree_key_t key;
+  tuple_id_t id;
+  unsigned count;
+  unsigned i;
+  unsigned j;
+
+  tree = index->opaque_data;
+
+  if(tree->load_next == 0) {
+    storage_scan_init(&scan, index->rel, block, sizeof(block));
+  }
+
+  for(count = 0; count < LEAF_CAPACITY; count++) {
+    result = storage_scan_get_row(&scan, tree->load_next, &row);
+    if(result == DB_FINISHED) {
+      break;
+    }
+    if(DB_ERROR(result) ||
+       DB_ERROR(relation_get_value(index->rel, index->attr, row, &value))) {
+      return DB_STORAGE_ERROR;
+    }
+    keys[count] = db_value_to_long(&value);
+    ids[count] = tree->load_next++;
+  }
+
+  /* Insertion sort, which is fast for already sorted keys. */
+  for(i = 1; i < count; i++) {
+    key = keys[i];
+    id = ids[i];
+    for(j = i; j > 0 && keys[j - 1] > key; j--) {
+      keys[j] = keys[j - 1];
+      ids[j] = ids[j - 1];
+    }
+    keys[j] = key;
+    ids[j] = id;
+  }
+
+  for(i = 0; i < count; i++) {
+    result = tree_insert(tree, keys[i], ids[i]);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+  }
+
+  if(count == 0) {
+    PRINTF("DB: Bulk loaded %lu keys into the B+-tree, height %u, %u pages\n",
+           (unsigned long)tree->load_next, (unsigned)tree->meta.height,
+           (unsigned)tree->meta.page_count);
+    result = flush(tree);
+    return DB_ERROR(result) ? result : DB_FINISHED;
+  }
+
+  return DB_OK;
+}
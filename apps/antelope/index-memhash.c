@@ -61,7 +61,8 @@ index_api_t index_memhash = {
   release,
   insert,
   delete,
-  get_next
+  get_next,
+  NULL
 };
 
 struct hash_item {
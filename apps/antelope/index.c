@@ -49,7 +49,7 @@
 #include "storage.h"
 
 static index_api_t *index_components[] = {&index_inline,
-	&index_maxheap};
+	&index_maxheap, &index_btree};
 
 LIST(indices);
 MEMB(index_memb, index_t, DB_INDEX_POOL_SIZE);
@@ -359,6 +359,7 @@ get_next_index_to_load(void)
 PROCESS_THREAD(db_indexer, ev, data)
 {
   static index_t *index;
+  static relation_t *rel;
   static db_handle_t handle;
   static tuple_id_t row;
   db_result_t result;
@@ -380,6 +381,28 @@ PROCESS_THREAD(db_indexer, ev, data)
     PRINTF("DB: Loading the index for %s.%s...\n",
 	index->rel->name, index->attr->name);
 
+    if(index->api->bulk_load != NULL) {
+      /* The index reads the relation itself, which is kept
+         loaded until the index has been filled. */
+      rel = relation_load(index->rel->name);
+      result = rel == NULL ? DB_STORAGE_ERROR : DB_OK;
+      while(result == DB_OK) {
+        PROCESS_PAUSE();
+        result = index->api->bulk_load(index);
+      }
+      if(rel != NULL) {
+        relation_release(rel);
+      }
+
+      if(DB_ERROR(result)) {
+        PRINTF("DB: Failed to bulk load the index for %s.%s\n",
+               index->rel->name, index->attr->name);
+        index->flags |= INDEX_LOAD_ERROR;
+      }
+      index->flags &= ~INDEX_LOAD_NEEDED;
+      continue;
+    }
+
     /* Project the values of the indexed attribute from all tuples in 
        the relation, and insert them into the index again. */
     if(DB_ERROR(db_query(&handle, "SELECT %s FROM %s;", index->attr->name, index->rel->name))) {
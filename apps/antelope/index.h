@@ -43,7 +43,8 @@ typedef enum {
   INDEX_NONE = 0,
   INDEX_INLINE = 1,
   INDEX_MEMHASH = 2,
-  INDEX_MAXHEAP = 3
+  INDEX_MAXHEAP = 3,
+  INDEX_BTREE = 4
 } index_type_t;
 
 #define INDEX_READY		0x00
@@ -90,6 +91,9 @@ struct index_api {
   db_result_t (*insert)(index_t *, attribute_value_t *, tuple_id_t);
   db_result_t (*delete)(index_t *, attribute_value_t *);
   tuple_id_t (*get_next)(index_iterator_t *);
+  /* Optional: load the keys of the existing tuples in steps. Returns
+     DB_OK after each step and DB_FINISHED when all tuples are loaded. */
+  db_result_t (*bulk_load)(index_t *);
 };
 
 typedef struct index_api index_api_t;
@@ -97,6 +101,7 @@ typedef struct index_api index_api_t;
 extern index_api_t index_inline;
 extern index_api_t index_maxheap;
 extern index_api_t index_memhash;
+extern index_api_t index_btree;
 
 void index_init(void);
 db_result_t index_create(index_type_t, relation_t *, attribute_t *);
@@ -49,6 +49,12 @@
  * The logic engine determines whether a logical  predicate is true for 
  * each tuple in a relation. It uses a stack-based execution model of
  * operations that are arranged in prefix (Polish) notation.
+ *
+ * For scans over many tuples, lvm_compile() flattens the prefix code
+ * into a postfix program in which variables are referenced by slot
+ * number, so that each evaluation is a single pass over a short
+ * instruction array. lvm_execute_batch() runs that program over a
+ * block of tuples at a time.
  */
 
 /* Default option values. */
@@ -56,10 +62,6 @@
 #define LVM_MAX_NAME_LENGTH		16
 #endif
 
-#ifndef LVM_MAX_VARIABLE_ID
-#define LVM_MAX_VARIABLE_ID		8
-#endif
-
 #ifndef LVM_USE_FLOATS
 #define LVM_USE_FLOATS			0
 #endif
@@ -80,12 +82,28 @@ struct derivation {
 };
 typedef struct derivation derivation_t;
 
+/* An instruction of a compiled predicate. The opcode is either an
+   operator or one of the push instructions below. */
+struct insn {
+  long value;
+  uint8_t op;
+};
+
+#define INSN_PUSH_LONG		LVM_OPERAND
+#define INSN_PUSH_VARIABLE	(LVM_OPERAND | 1)
+
 /* Registered variables for a LVM expression. Their values may be 
    changed between executions of the expression. */
-static variable_t variables[LVM_MAX_VARIABLE_ID - 1];
+static variable_t variables[LVM_MAX_VARIABLE_ID];
 
 /* Range derivations of variables that are used for index searches. */
-static derivation_t derivations[LVM_MAX_VARIABLE_ID - 1];
+static derivation_t derivations[LVM_MAX_VARIABLE_ID];
+
+/* The compiled form of the predicate, and the stack depth that
+   it needs. */
+static struct insn program[LVM_MAX_INSNS];
+static unsigned char program_depth;
+static unsigned char max_program_depth;
 
 #if DEBUG
 static void
@@ -107,7 +125,7 @@ lookup(char *name)
 {
   variable_t *var;
 
-  for(var = variables; var <= &variables[LVM_MAX_VARIABLE_ID - 1] && var->name[0] != '\0'; var++) {
+  for(var = variables; var < &variables[LVM_MAX_VARIABLE_ID] && var->name[0] != '\0'; var++) {
     if(strcmp(var->name, name) == 0) {
       break;
     }
@@ -297,6 +315,166 @@ eval_logic(lvm_instance_t *p, operator_t *op)
   return EXECUTION_ERROR;
 }
 
+static lvm_status_t
+emit(lvm_instance_t *p, uint8_t op, long value)
+{
+  struct insn *insn;
+
+  if(p->program_length >= LVM_MAX_INSNS) {
+    return STACK_OVERFLOW;
+  }
+
+  insn = &program[p->program_length++];
+  insn->op = op;
+  insn->value = value;
+
+  if(op == INSN_PUSH_LONG || op == INSN_PUSH_VARIABLE) {
+    if(++program_depth > max_program_depth) {
+      max_program_depth = program_depth;
+    }
+  } else if(op != LVM_NOT) {
+    program_depth--;
+  }
+
+  return TRUE;
+}
+
+static lvm_status_t
+compile_operand(lvm_instance_t *p)
+{
+  operand_t operand;
+
+  get_operand(p, &operand);
+  if(operand.type == LVM_VARIABLE) {
+    if(operand.value.id >= LVM_MAX_VARIABLE_ID) {
+      return INVALID_IDENTIFIER;
+    }
+    return emit(p, INSN_PUSH_VARIABLE, operand.value.id);
+  }
+  return emit(p, INSN_PUSH_LONG, operand_to_long(&operand));
+}
+
+static lvm_status_t
+compile_expr(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  lvm_status_t r;
+
+  for(i = 0; i < 2; i++) {
+    switch(get_type(p)) {
+    case LVM_ARITH_OP:
+      r = compile_expr(p, *get_operator(p));
+      break;
+    case LVM_OPERAND:
+      r = compile_operand(p);
+      break;
+    default:
+      return SEMANTIC_ERROR;
+    }
+    if(LVM_ERROR(r)) {
+      return r;
+    }
+  }
+
+  return emit(p, op, 0);
+}
+
+static lvm_status_t
+compile_logic(lvm_instance_t *p, operator_t op)
+{
+  int i;
+  unsigned arguments;
+  lvm_status_t r;
+
+  if(IS_CONNECTIVE(op)) {
+    arguments = op == LVM_NOT ? 1 : 2;
+    for(i = 0; i < arguments; i++) {
+      if(get_type(p) != LVM_CMP_OP) {
+	return SEMANTIC_ERROR;
+      }
+      r = compile_logic(p, *get_operator(p));
+      if(LVM_ERROR(r)) {
+	return r;
+      }
+    }
+    return emit(p, op, 0);
+  }
+
+  return compile_expr(p, op);
+}
+
+static lvm_status_t
+run_program(lvm_instance_t *p, const long *values)
+{
+  long stack[LVM_STACK_SIZE];
+  long *top;
+  const struct insn *insn;
+  const struct insn *end;
+
+  top = stack - 1;
+  end = &program[p->program_length];
+  for(insn = program; insn < end; insn++) {
+    switch(insn->op) {
+    case INSN_PUSH_LONG:
+      *++top = insn->value;
+      continue;
+    case INSN_PUSH_VARIABLE:
+      *++top = values[insn->value];
+      continue;
+    case LVM_NOT:
+      *top = !*top;
+      continue;
+    }
+
+    top--;
+    switch(insn->op) {
+    case LVM_ADD:
+      top[0] += top[1];
+      break;
+    case LVM_SUB:
+      top[0] -= top[1];
+      break;
+    case LVM_MUL:
+      top[0] *= top[1];
+      break;
+    case LVM_DIV:
+      if(top[1] == 0) {
+	return MATH_ERROR;
+      }
+      top[0] /= top[1];
+      break;
+    case LVM_EQ:
+      top[0] = top[0] == top[1];
+      break;
+    case LVM_NEQ:
+      top[0] = top[0] != top[1];
+      break;
+    case LVM_GE:
+      top[0] = top[0] > top[1];
+      break;
+    case LVM_GEQ:
+      top[0] = top[0] >= top[1];
+      break;
+    case LVM_LE:
+      top[0] = top[0] < top[1];
+      break;
+    case LVM_LEQ:
+      top[0] = top[0] <= top[1];
+      break;
+    case LVM_AND:
+      top[0] = top[0] && top[1];
+      break;
+    case LVM_OR:
+      top[0] = top[0] || top[1];
+      break;
+    default:
+      return EXECUTION_ERROR;
+    }
+  }
+
+  return stack[0] ? TRUE : FALSE;
+}
+
 void
 lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 {
@@ -306,6 +484,7 @@ lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
   p->end = 0;
   p->ip = 0;
   p->error = 0;
+  p->program_length = 0;
 
   memset(variables, 0, sizeof(variables));
   memset(derivations, 0, sizeof(derivations));
@@ -372,6 +551,11 @@ lvm_set_end(lvm_instance_t *p, lvm_ip_t end)
 void
 lvm_set_type(lvm_instance_t *p, node_type_t type)
 {
+  p->program_length = 0;
+  if(p->end + sizeof(type) > p->size) {
+    p->error = __LINE__;
+    return;
+  }
   *(node_type_t *)(p->code + p->end) = type;
   p->end += sizeof(type);
 }
@@ -382,6 +566,15 @@ lvm_execute(lvm_instance_t *p)
   node_type_t type;
   operator_t *operator;
   lvm_status_t status;
+  long values[LVM_MAX_VARIABLE_ID];
+  int i;
+
+  if(p->program_length > 0) {
+    for(i = 0; i < LVM_MAX_VARIABLE_ID; i++) {
+      values[i] = variables[i].value.l;
+    }
+    return run_program(p, values);
+  }
 
   p->ip = 0;
   status = EXECUTION_ERROR;
@@ -407,6 +600,10 @@ void
 lvm_set_op(lvm_instance_t *p, operator_t op)
 {
   lvm_set_type(p, LVM_ARITH_OP);
+  if(p->end + sizeof(op) > p->size) {
+    p->error = __LINE__;
+    return;
+  }
   memcpy(&p->code[p->end], &op, sizeof(op));
   p->end += sizeof(op);
 }
@@ -415,6 +612,10 @@ void
 lvm_set_relation(lvm_instance_t *p, operator_t op)
 {
   lvm_set_type(p, LVM_CMP_OP);
+  if(p->end + sizeof(op) > p->size) {
+    p->error = __LINE__;
+    return;
+  }
   memcpy(&p->code[p->end], &op, sizeof(op));
   p->end += sizeof(op);
 }
@@ -423,6 +624,10 @@ void
 lvm_set_operand(lvm_instance_t *p, operand_t *op)
 {
   lvm_set_type(p, LVM_OPERAND);
+  if(p->end + sizeof(*op) > p->size) {
+    p->error = __LINE__;
+    return;
+  }
   memcpy(&p->code[p->end], op, sizeof(*op));
   p->end += sizeof(*op);
 }
@@ -472,6 +677,87 @@ lvm_set_variable_value(char *name, operand_value_t value)
   return TRUE;
 }
 
+variable_id_t
+lvm_get_variable_id(char *name)
+{
+  variable_id_t id;
+
+  id = lookup(name);
+  if(id < LVM_MAX_VARIABLE_ID && variables[id].name[0] == '\0') {
+    return LVM_MAX_VARIABLE_ID;
+  }
+  return id;
+}
+
+unsigned
+lvm_get_variable_count(void)
+{
+  unsigned count;
+
+  for(count = 0;
+      count < LVM_MAX_VARIABLE_ID && variables[count].name[0] != '\0';
+      count++);
+  return count;
+}
+
+void
+lvm_set_variable_slot(variable_id_t id, long value)
+{
+  variables[id].value.l = value;
+}
+
+lvm_status_t
+lvm_compile(lvm_instance_t *p)
+{
+  lvm_status_t r;
+
+  if(p->error) {
+    return SEMANTIC_ERROR;
+  }
+
+  p->program_length = 0;
+  program_depth = 0;
+  max_program_depth = 0;
+
+  p->ip = 0;
+  if(get_type(p) != LVM_CMP_OP) {
+    return SEMANTIC_ERROR;
+  }
+  r = compile_logic(p, *get_operator(p));
+  if(!LVM_ERROR(r) && max_program_depth > LVM_STACK_SIZE) {
+    r = STACK_OVERFLOW;
+  }
+  if(LVM_ERROR(r)) {
+    p->program_length = 0;
+    return r;
+  }
+
+  PRINTF("Compiled the predicate into %u instructions\n",
+         (unsigned)p->program_length);
+  return TRUE;
+}
+
+lvm_status_t
+lvm_execute_batch(lvm_instance_t *p, const long *values,
+                  unsigned nrows, unsigned char *results)
+{
+  unsigned stride;
+
+  if(p->program_length == 0) {
+    return EXECUTION_ERROR;
+  }
+
+  /* The status of each row is stored, so that a row with an error
+     is treated the same way as by lvm_execute(). */
+  stride = lvm_get_variable_count();
+  for(; nrows > 0; nrows--) {
+    *results++ = run_program(p, values);
+    values += stride;
+  }
+
+  return TRUE;
+}
+
 void
 lvm_set_variable(lvm_instance_t *p, char *name)
 {
@@ -44,6 +44,20 @@
 
 #include "db-options.h"
 
+#ifndef LVM_MAX_VARIABLE_ID
+#define LVM_MAX_VARIABLE_ID		8
+#endif
+
+/* The maximum number of instructions in a compiled predicate. */
+#ifndef LVM_MAX_INSNS
+#define LVM_MAX_INSNS			24
+#endif
+
+/* The evaluation stack depth of a compiled predicate. */
+#ifndef LVM_STACK_SIZE
+#define LVM_STACK_SIZE			8
+#endif
+
 enum lvm_status {
   FALSE = 0,
   TRUE = 1,
@@ -69,6 +83,7 @@ struct lvm_instance {
   lvm_ip_t end;
   lvm_ip_t ip;
   unsigned error;
+  unsigned char program_length;
 };
 typedef struct lvm_instance lvm_instance_t;
 
@@ -130,6 +145,12 @@ void lvm_print_derivations(lvm_instance_t *p);
 lvm_status_t lvm_execute(lvm_instance_t *p);
 lvm_status_t lvm_register_variable(char *name, operand_type_t type);
 lvm_status_t lvm_set_variable_value(char *name, operand_value_t value);
+variable_id_t lvm_get_variable_id(char *name);
+unsigned lvm_get_variable_count(void);
+void lvm_set_variable_slot(variable_id_t id, long value);
+lvm_status_t lvm_compile(lvm_instance_t *p);
+lvm_status_t lvm_execute_batch(lvm_instance_t *p, const long *values,
+                               unsigned nrows, unsigned char *results);
 void lvm_print_code(lvm_instance_t *p);
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p);
 lvm_ip_t lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end);
@@ -64,6 +64,9 @@ struct source_dest_map {
   attribute_t *to_attr;
   unsigned from_offset;
   unsigned to_offset;
+  /* The LVM variable slot of the attribute, or LVM_MAX_VARIABLE_ID if
+     the attribute is not used in the predicate. */
+  variable_id_t var_id;
 };
 
 static struct source_dest_map attr_map[AQL_ATTRIBUTE_LIMIT];
@@ -88,6 +91,19 @@ static unsigned char * const left_row = row;
 static unsigned char * const right_row = extra_row;
 static unsigned char * const join_row = result_row;
 
+/* Block buffers for the scan cursors of the relations in a query. */
+static unsigned char scan_block[DB_SCAN_BLOCK_SIZE];
+#if DB_FEATURE_JOIN
+static unsigned char right_scan_block[DB_SCAN_BLOCK_SIZE];
+#endif /* DB_FEATURE_JOIN */
+
+/* Predicate variable values and results for a batch of consecutive
+   rows in the scan block. */
+static long batch_values[DB_PREDICATE_BATCH_SIZE];
+static unsigned char batch_result[DB_PREDICATE_BATCH_SIZE];
+static tuple_id_t batch_first;
+static unsigned batch_count;
+
 LIST(relations);
 MEMB(relations_memb, relation_t, DB_RELATION_POOL_SIZE);
 MEMB(attributes_memb, attribute_t, DB_ATTRIBUTE_POOL_SIZE);
@@ -250,7 +266,9 @@ relation_load(char *name)
   list_add(relations, rel);
 
 end:
-  if(rel->dir == DB_STORAGE && DB_ERROR(storage_load(rel))) {
+  /* The tuple file is opened once and shared by all references. */
+  if(rel->dir == DB_STORAGE && !RELATION_HAS_TUPLES(rel) &&
+     DB_ERROR(storage_load(rel))) {
     relation_release(rel);
     return NULL;
   }
@@ -273,11 +291,18 @@ relation_release(relation_t *rel)
 }
 
 relation_t *
-relation_create(char *name, db_direction_t dir)
+relation_create(char *name, db_direction_t dir, uint8_t flags)
 {
   relation_t old_rel;
   relation_t *rel;
 
+#if !DB_FEATURE_SERIES
+  if(flags & RELATION_FLAG_SERIES) {
+    PRINTF("DB: Series relations are not supported\n");
+    return NULL;
+  }
+#endif /* !DB_FEATURE_SERIES */
+
   if(*name != '\0') {
     relation_clear(&old_rel);
 
@@ -298,6 +323,7 @@ relation_create(char *name, db_direction_t dir)
     strncpy(rel->name, name, sizeof(rel->name) - 1);
     rel->name[sizeof(rel->name) - 1] = '\0';
     rel->dir = dir;
+    rel->flags = flags;
 
     if(dir == DB_STORAGE) {
       storage_drop_relation(rel, 1);
@@ -547,48 +573,6 @@ relation_insert(relation_t *rel, attribute_value_t *values)
   return storage_put_row(rel, record);
 }
 
-static void
-aggregate(attribute_t *attr, attribute_value_t *value)
-{
-  long long_value;
-
-  switch(value->domain) {
-  case DOMAIN_INT:
-    long_value = VALUE_INT(value);
-    break;
-  case DOMAIN_LONG:
-    long_value = VALUE_LONG(value);
-    break;
-  default:
-    return;
-  }
-
-  switch(attr->aggregator) {
-  case AQL_COUNT:
-    attr->aggregation_value++;
-    break;
-  case AQL_SUM:
-    attr->aggregation_value += long_value;
-    break;
-  case AQL_MEAN:
-    break;
-  case AQL_MEDIAN:
-    break;
-  case AQL_MAX:
-    if(long_value > attr->aggregation_value) {
-      attr->aggregation_value = long_value;
-    }
-    break;
-  case AQL_MIN:
-    if(long_value < attr->aggregation_value) {
-      attr->aggregation_value = long_value;
-    }
-    break;
-  default:
-    break;
-  }
-}
-
 static db_result_t
 generate_attribute_map(struct source_dest_map *attr_map, unsigned attribute_count,
                        relation_t *from_rel, relation_t *to_rel, 
@@ -655,7 +639,7 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
 
       if(range <= min_range) {
         index = attr->index;
-        av_min.domain = av_max.domain = DOMAIN_INT;
+        av_min.domain = av_max.domain = DOMAIN_LONG;
         VALUE_LONG(&av_min) = min.l;
         VALUE_LONG(&av_max) = max.l;
       }
@@ -671,18 +655,515 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
   }
 }
 
+/* Let a full scan of a series relation skip the blocks in which the
+   attribute with the smallest derived range is outside of it. */
+static void
+select_range(db_handle_t *handle, lvm_instance_t *lvm_instance)
+{
+  attribute_t *attr;
+  attribute_t *range_attr;
+  operand_value_t min;
+  operand_value_t max;
+  long range_min;
+  long range_max;
+  unsigned long min_range;
+
+  range_attr = NULL;
+  range_min = range_max = 0;
+  min_range = ULONG_MAX;
+
+  for(attr = list_head(handle->rel->attributes);
+      attr != NULL;
+      attr = attr->next) {
+    if((attr->domain == DOMAIN_INT || attr->domain == DOMAIN_LONG) &&
+       !LVM_ERROR(lvm_get_derived_range(lvm_instance, attr->name, &min, &max)) &&
+       (unsigned long)max.l - (unsigned long)min.l < min_range) {
+      min_range = (unsigned long)max.l - (unsigned long)min.l;
+      range_attr = attr;
+      range_min = min.l;
+      range_max = max.l;
+    }
+  }
+
+  if(range_attr != NULL) {
+    storage_scan_set_range(&handle->scan, range_attr, range_min, range_max);
+  }
+}
+
+static long
+get_predicate_value(attribute_t *attr, const unsigned char *from_ptr)
+{
+  if(attr->domain == DOMAIN_INT) {
+    return from_ptr[0] << 8 | from_ptr[1];
+  }
+  return (uint32_t)from_ptr[0] << 24 |
+         (uint32_t)from_ptr[1] << 16 |
+         (uint32_t)from_ptr[2] << 8 |
+         from_ptr[3];
+}
+
+static uint32_t
+hash_key(long key)
+{
+  return (uint32_t)key * 2654435761UL;
+}
+
+/* Whether the rows of a relation are sorted on an attribute. The
+   inline index requires this. */
+static int
+attribute_is_sorted(attribute_t *attr)
+{
+  return index_exists(attr) && ((index_t *)attr->index)->type == INDEX_INLINE;
+}
+
+/* Evaluate the predicate for the buffered rows starting at the
+   current tuple. The variable values of each row are stored in
+   slot order, which is the layout that lvm_execute_batch() uses. */
+static void
+filter_batch(db_handle_t *handle, struct source_dest_map *attr_map_end)
+{
+  struct source_dest_map *attr_map_ptr;
+  storage_row_t row_ptr;
+  unsigned stride;
+  unsigned nrows;
+  unsigned i;
+  long *values;
+
+  stride = lvm_get_variable_count();
+  nrows = storage_scan_buffered(&handle->scan, handle->tuple_id);
+  if(stride > 0 && nrows > DB_PREDICATE_BATCH_SIZE / stride) {
+    nrows = DB_PREDICATE_BATCH_SIZE / stride;
+  } else if(nrows > DB_PREDICATE_BATCH_SIZE) {
+    nrows = DB_PREDICATE_BATCH_SIZE;
+  }
+
+  values = batch_values;
+  for(i = 0; i < nrows; i++) {
+    storage_scan_get_row(&handle->scan, handle->tuple_id + i, &row_ptr);
+    for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+      if(attr_map_ptr->var_id < LVM_MAX_VARIABLE_ID) {
+        values[attr_map_ptr->var_id] =
+          get_predicate_value(attr_map_ptr->from_attr,
+                              row_ptr + attr_map_ptr->from_offset);
+      }
+    }
+    values += stride;
+  }
+
+  batch_first = handle->tuple_id;
+  batch_count = nrows;
+  lvm_execute_batch(((aql_adt_t *)handle->adt)->lvm_instance,
+                    batch_values, nrows, batch_result);
+}
+
+/*
+ * Aggregation. The aggregated values of each group are kept in a
+ * bounded table. A query without GROUP BY aggregates all rows into a
+ * single group.
+ *
+ * If the relation is sorted on the grouping attribute, a group is
+ * complete when the key changes, and it is streamed out right away.
+ * Otherwise, the table keeps the groups with the smallest keys that
+ * fit, and the groups are returned in key order at the end of the
+ * scan. Any remaining groups are computed in further passes over the
+ * relation.
+ */
+typedef uint8_t group_slot_t;
+
+#define GROUP_NONE	0xff
+
+struct group {
+  long key;
+  long values[AQL_ATTRIBUTE_LIMIT];
+  tuple_id_t count;
+  group_slot_t next;
+};
+
+static struct {
+  struct source_dest_map *key_map;
+  struct source_dest_map *map_end;
+  long window;
+  /* Groups up to this key have been returned in earlier passes. */
+  long floor;
+  /* Groups from this key on are left for a later pass. */
+  long ceiling;
+  group_slot_t used;
+  group_slot_t next_emit;
+  uint8_t streaming;
+  uint8_t has_floor;
+  uint8_t overflow;
+} grouping;
+
+static struct group groups[DB_GROUP_LIMIT];
+static group_slot_t group_buckets[DB_GROUP_BUCKETS];
+
+static void
+set_row_value(attribute_t *attr, unsigned char *to_ptr, long value)
+{
+  if(attr->domain == DOMAIN_INT) {
+    to_ptr[0] = value >> 8;
+    to_ptr[1] = value & 0xff;
+  } else {
+    to_ptr[0] = value >> 24;
+    to_ptr[1] = value >> 16;
+    to_ptr[2] = value >> 8;
+    to_ptr[3] = value & 0xff;
+  }
+}
+
+static void
+clear_groups(void)
+{
+  int i;
+
+  grouping.used = 0;
+  for(i = 0; i < DB_GROUP_BUCKETS; i++) {
+    group_buckets[i] = GROUP_NONE;
+  }
+}
+
+static long
+group_key(storage_row_t row_ptr)
+{
+  long key;
+  long offset;
+
+  if(grouping.key_map == NULL) {
+    return 0;
+  }
+
+  key = get_predicate_value(grouping.key_map->from_attr,
+                            row_ptr + grouping.key_map->from_offset);
+  if(grouping.window > 0) {
+    /* Use the start of the time window as the key. */
+    offset = key % grouping.window;
+    if(offset < 0) {
+      offset += grouping.window;
+    }
+    key -= offset;
+  }
+  return key;
+}
+
+static void
+group_init(struct group *group, long key)
+{
+  struct source_dest_map *attr_map_ptr;
+  long *value;
+
+  group->key = key;
+  group->count = 0;
+
+  for(attr_map_ptr = attr_map, value = group->values;
+      attr_map_ptr < grouping.map_end;
+      attr_map_ptr++, value++) {
+    switch(attr_map_ptr->to_attr->aggregator) {
+    case AQL_MAX:
+      *value = LONG_MIN;
+      break;
+    case AQL_MIN:
+      *value = LONG_MAX;
+      break;
+    default:
+      *value = 0;
+      break;
+    }
+  }
+}
+
+static void
+group_update(struct group *group, storage_row_t row_ptr)
+{
+  struct source_dest_map *attr_map_ptr;
+  long *value;
+  long row_value;
+
+  group->count++;
+
+  for(attr_map_ptr = attr_map, value = group->values;
+      attr_map_ptr < grouping.map_end;
+      attr_map_ptr++, value++) {
+    if(attr_map_ptr->to_attr->aggregator == AQL_NONE ||
+       attr_map_ptr->to_attr->aggregator == AQL_COUNT ||
+       (attr_map_ptr->from_attr->domain != DOMAIN_INT &&
+        attr_map_ptr->from_attr->domain != DOMAIN_LONG)) {
+      continue;
+    }
+
+    row_value = get_predicate_value(attr_map_ptr->from_attr,
+                                    row_ptr + attr_map_ptr->from_offset);
+    switch(attr_map_ptr->to_attr->aggregator) {
+    case AQL_SUM:
+    case AQL_MEAN:
+      *value += row_value;
+      break;
+    case AQL_MAX:
+      if(row_value > *value) {
+        *value = row_value;
+      }
+      break;
+    case AQL_MIN:
+      if(row_value < *value) {
+        *value = row_value;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static group_slot_t *
+group_bucket(long key)
+{
+  return &group_buckets[(hash_key(key) >> 16) % DB_GROUP_BUCKETS];
+}
+
+static struct group *
+group_find(long key)
+{
+  group_slot_t slot;
+
+  for(slot = *group_bucket(key); slot != GROUP_NONE; slot = groups[slot].next) {
+    if(groups[slot].key == key) {
+      return &groups[slot];
+    }
+  }
+  return NULL;
+}
+
+static struct group *
+group_add(long key)
+{
+  group_slot_t slot;
+  group_slot_t max;
+  group_slot_t *link;
+
+  if(grouping.used < DB_GROUP_LIMIT) {
+    slot = grouping.used++;
+  } else {
+    /* The table is full. Keep the groups with the smallest keys,
+       and leave the others for a later pass. */
+    grouping.overflow = 1;
+    for(max = 0, slot = 1; slot < grouping.used; slot++) {
+      if(groups[slot].key > groups[max].key) {
+        max = slot;
+      }
+    }
+    if(key > groups[max].key) {
+      grouping.ceiling = key;
+      return NULL;
+    }
+
+    grouping.ceiling = groups[max].key;
+    for(link = group_bucket(groups[max].key); *link != max;
+        link = &groups[*link].next);
+    *link = groups[max].next;
+    slot = max;
+  }
+
+  group_init(&groups[slot], key);
+  link = group_bucket(key);
+  groups[slot].next = *link;
+  *link = slot;
+
+  return &groups[slot];
+}
+
+/* Fill in the result row of a group. */
+static db_result_t
+group_output(db_handle_t *handle, struct group *group)
+{
+  struct source_dest_map *attr_map_ptr;
+  attribute_t *result_attr;
+  long *value;
+  long result_value;
+
+  for(attr_map_ptr = attr_map, value = group->values;
+      attr_map_ptr < grouping.map_end;
+      attr_map_ptr++, value++) {
+    result_attr = attr_map_ptr->to_attr;
+    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
+      continue;
+    }
+
+    switch(result_attr->aggregator) {
+    case AQL_NONE:
+      result_value = group->key;
+      break;
+    case AQL_COUNT:
+      result_value = group->count;
+      break;
+    case AQL_MEAN:
+      result_value = group->count > 0 ? *value / (long)group->count : 0;
+      break;
+    default:
+      result_value = *value;
+      break;
+    }
+    set_row_value(result_attr, result_row + attr_map_ptr->to_offset,
+                  result_value);
+  }
+
+  if(AQL_GET_FLAGS((aql_adt_t *)handle->adt) & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
+      PRINTF("DB: Failed to store a row in the result relation!\n");
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+static db_result_t
+aggregate_row(db_handle_t *handle, storage_row_t row_ptr)
+{
+  struct group *group;
+  long key;
+  db_result_t result;
+
+  key = group_key(row_ptr);
+
+  if(grouping.streaming) {
+    group = &groups[0];
+    if(grouping.used == 0) {
+      grouping.used = 1;
+      group_init(group, key);
+    } else if(group->key != key) {
+      /* The rows arrive in key order, so the group is complete. */
+      result = group_output(handle, group);
+      group_init(group, key);
+      group_update(group, row_ptr);
+      return result;
+    }
+    group_update(group, row_ptr);
+    return DB_OK;
+  }
+
+  if((grouping.has_floor && key <= grouping.floor) ||
+     (grouping.overflow && key >= grouping.ceiling)) {
+    return DB_OK;
+  }
+
+  group = group_find(key);
+  if(group == NULL) {
+    group = group_add(key);
+    if(group == NULL) {
+      return DB_OK;
+    }
+  }
+  group_update(group, row_ptr);
+
+  return DB_OK;
+}
+
+static db_result_t
+emit_groups(db_handle_t *handle)
+{
+  aql_adt_t *adt;
+
+  if(grouping.next_emit < grouping.used) {
+    return group_output(handle, &groups[grouping.next_emit++]);
+  }
+
+  if(!grouping.overflow) {
+    return DB_FINISHED;
+  }
+
+  /* Start another pass over the relation for the groups that
+     did not fit in the table. */
+  PRINTF("DB: Starting another aggregation pass after key %ld\n",
+         groups[grouping.used - 1].key);
+  grouping.floor = groups[grouping.used - 1].key;
+  grouping.has_floor = 1;
+  grouping.overflow = 0;
+  clear_groups();
+
+  handle->flags &= ~DB_HANDLE_FLAG_EMIT_GROUPS;
+  handle->tuple_id = 0;
+  batch_count = 0;
+  if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
+    adt = (aql_adt_t *)handle->adt;
+    select_index(handle, adt->lvm_instance);
+  }
+
+  return DB_OK;
+}
+
+static db_result_t
+finish_aggregation(db_handle_t *handle)
+{
+  struct group group;
+  int i, j;
+
+  if(grouping.used == 0 && grouping.key_map == NULL) {
+    /* Aggregates over no rows still produce a result. */
+    grouping.used = 1;
+    group_init(&groups[0], 0);
+  }
+
+  /* Sort the groups by key. */
+  for(i = 1; i < grouping.used; i++) {
+    group = groups[i];
+    for(j = i; j > 0 && groups[j - 1].key > group.key; j--) {
+      groups[j] = groups[j - 1];
+    }
+    groups[j] = group;
+  }
+
+  grouping.next_emit = 0;
+  handle->flags |= DB_HANDLE_FLAG_EMIT_GROUPS;
+
+  return emit_groups(handle);
+}
+
+static db_result_t
+init_grouping(db_handle_t *handle, aql_adt_t *adt)
+{
+  attribute_t *attr;
+
+  grouping.map_end = attr_map + handle->result_rel->attribute_count;
+  grouping.key_map = NULL;
+  grouping.window = 0;
+  grouping.streaming = 1;
+  grouping.has_floor = 0;
+  grouping.overflow = 0;
+  clear_groups();
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) {
+    grouping.key_map = &attr_map[adt->group_attribute];
+    grouping.window = adt->group_window;
+    attr = grouping.key_map->from_attr;
+    if(attr->domain != DOMAIN_INT && attr->domain != DOMAIN_LONG) {
+      PRINTF("DB: Cannot group by the attribute %s\n", attr->name);
+      return DB_TYPE_ERROR;
+    }
+
+    /* Rows are read in key order if the relation is sorted on the
+       attribute, and no other index is used for the selection. */
+    grouping.streaming = attribute_is_sorted(attr) &&
+      (!(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) ||
+       handle->index_iterator.index == attr->index);
+  }
+
+  return DB_OK;
+}
+
 static db_result_t
 generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
 {
   relation_t *result_rel;
   unsigned attribute_count;
   attribute_t *attr;
+  struct source_dest_map *attr_map_ptr;
 
   result_rel = handle->result_rel;
 
   handle->current_row = 0;
   handle->ncolumns = 0;
   handle->tuple_id = 0;
+  storage_scan_init(&handle->scan, rel, scan_block, sizeof(scan_block));
   for(attr = list_head(result_rel->attributes); attr != NULL; attr = attr->next) {
     if(attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
       continue;
@@ -700,6 +1181,39 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     /* Try to establish acceptable ranges for the attribute values. */
     if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
       select_index(handle, adt->lvm_instance);
+      if(!(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) &&
+         !(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC)) {
+        select_range(handle, adt->lvm_instance);
+      }
+    }
+  }
+
+  /* Bind the attributes used in the predicate to their variable
+     slots, so that rows are not matched by attribute name. */
+  for(attr_map_ptr = attr_map;
+      attr_map_ptr < attr_map + attribute_count;
+      attr_map_ptr++) {
+    attr = attr_map_ptr->from_attr;
+    attr_map_ptr->var_id = LVM_MAX_VARIABLE_ID;
+    if(adt->lvm_instance != NULL &&
+       (attr->domain == DOMAIN_INT || attr->domain == DOMAIN_LONG)) {
+      attr_map_ptr->var_id = lvm_get_variable_id(attr->name);
+    }
+  }
+
+  /* A full scan evaluates the compiled predicate over the buffered
+     rows in batches. Otherwise the compiled predicate is evaluated
+     row by row, or interpreted if it could not be compiled. */
+  batch_count = 0;
+  if(adt->lvm_instance != NULL &&
+     !LVM_ERROR(lvm_compile(adt->lvm_instance)) &&
+     !(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX)) {
+    handle->flags |= DB_HANDLE_FLAG_BATCH_FILTER;
+  }
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+    if(DB_ERROR(init_grouping(handle, adt))) {
+      return DB_TYPE_ERROR;
     }
   }
 
@@ -741,11 +1255,8 @@ relation_process_select(void *handle_ptr)
   struct source_dest_map *attr_map_ptr, *attr_map_end;
   attribute_t *result_attr;
   unsigned char *from_ptr;
-  unsigned char *to_ptr;
-  operand_value_t operand_value;
-  uint8_t intbuf[2];
-  attribute_value_t value;
   lvm_status_t wanted_result;
+  storage_row_t row_ptr;
 
   handle = (db_handle_t *)handle_ptr;
   adt = (aql_adt_t *)handle->adt;
@@ -753,6 +1264,11 @@ relation_process_select(void *handle_ptr)
   attribute_count = handle->result_rel->attribute_count;
   attr_map_end = attr_map + attribute_count;
 
+  if(handle->flags & DB_HANDLE_FLAG_EMIT_GROUPS) {
+    return emit_groups(handle);
+  }
+
+next_row:
   if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
     handle->tuple_id = index_get_next(&handle->index_iterator);
     if(handle->tuple_id == INVALID_TUPLE) {
@@ -761,43 +1277,55 @@ relation_process_select(void *handle_ptr)
         return DB_INDEX_ERROR;
       }
 
-      if(adt->flags & AQL_FLAG_AGGREGATE) {
-        goto end_aggregation;
+      if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+        return finish_aggregation(handle);
       }
 
       return DB_FINISHED;
     }
   }
 
+  wanted_result = TRUE;
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) {
+    wanted_result = FALSE;
+  }
+
   /* Put the tuples fulfilling the given condition into a new relation.
      The tuples may be projected. */
-  result = storage_get_row(handle->rel, &handle->tuple_id, row);
-  handle->tuple_id++;
+  if(!(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX)) {
+    handle->tuple_id = storage_scan_skip(&handle->scan, handle->tuple_id);
+  }
+  result = storage_scan_get_row(&handle->scan, handle->tuple_id, &row_ptr);
   if(DB_ERROR(result)) {
     PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
     return result;
   } else if(result == DB_FINISHED) {
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      goto end_aggregation;
+      return finish_aggregation(handle);
     }
     return DB_FINISHED;
   }
 
+  if(handle->flags & DB_HANDLE_FLAG_BATCH_FILTER) {
+    if(handle->tuple_id - batch_first >= batch_count) {
+      filter_batch(handle, attr_map_end);
+    }
+    if(batch_result[handle->tuple_id++ - batch_first] != wanted_result) {
+      goto next_buffered_row;
+    }
+  } else {
+    handle->tuple_id++;
+  }
+
   /* Process the attributes in the result relation. */
   for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    from_ptr = row + attr_map_ptr->from_offset;
+    from_ptr = row_ptr + attr_map_ptr->from_offset;
     result_attr = attr_map_ptr->to_attr;
 
     /* Update the internal state of the PLE. */
-    if(result_attr->domain == DOMAIN_INT) {
-      operand_value.l = from_ptr[0] << 8 | from_ptr[1];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    } else if(result_attr->domain == DOMAIN_LONG) {
-      operand_value.l = (uint32_t)from_ptr[0] << 24 |
-                        (uint32_t)from_ptr[1] << 16 |
-                        (uint32_t)from_ptr[2] << 8 |
-                        from_ptr[3];
-      lvm_set_variable_value(result_attr->name, operand_value);
+    if(attr_map_ptr->var_id < LVM_MAX_VARIABLE_ID) {
+      lvm_set_variable_slot(attr_map_ptr->var_id,
+                            get_predicate_value(attr_map_ptr->from_attr, from_ptr));
     }
 
     if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
@@ -813,22 +1341,14 @@ relation_process_select(void *handle_ptr)
     }
   }
 
-  wanted_result = TRUE;
-  if(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) {
-    wanted_result = FALSE;
-  }
-
   /* Check whether the given predicate is true for this tuple. */
   if(adt->lvm_instance == NULL ||
+     (handle->flags & DB_HANDLE_FLAG_BATCH_FILTER) ||
      lvm_execute(adt->lvm_instance) == wanted_result) {
     if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-        from_ptr = row + attr_map_ptr->from_offset;
-        result = db_phy_to_value(&value, attr_map_ptr->to_attr, from_ptr);
-        if(DB_ERROR(result)) {
-	  return result;
-        }
-        aggregate(attr_map_ptr->to_attr, &value);
+      result = aggregate_row(handle, row_ptr);
+      if(result != DB_OK) {
+        return result;
       }
     } else {
       if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
@@ -842,31 +1362,15 @@ relation_process_select(void *handle_ptr)
     }
   }
 
-  return DB_OK;
-
-end_aggregation:
-  /* Generate aggregated result if requested. */
-  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    result_attr = attr_map_ptr->to_attr;
-    to_ptr = result_row + attr_map_ptr->to_offset;
-
-    intbuf[0] = result_attr->aggregation_value >> 8;
-    intbuf[1] = result_attr->aggregation_value & 0xff;
-    from_ptr = intbuf;
-    memcpy(to_ptr, from_ptr, result_attr->element_size);
-  }
-
-  if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
-    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
-      PRINTF("DB: Failed to store a row in the result relation!\n");
-      return DB_STORAGE_ERROR;
-    }
+next_buffered_row:
+  /* Keep going while the next row of a full scan is already in the
+     block buffer, so that a whole block is processed per call. */
+  if(!(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) &&
+     storage_scan_buffered(&handle->scan, handle->tuple_id) > 0) {
+    goto next_row;
   }
 
-  handle->current_row = 1;
-  AQL_GET_FLAGS(adt) &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
-
-  return DB_GOT_ROW;
+  return DB_OK;
 }
 
 db_result_t
@@ -880,6 +1384,7 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
   attribute_t *attr;
   int i;
   int normal_attributes;
+  int aggregated_attributes;
 
   adt = (aql_adt_t *)adt_ptr;
 
@@ -895,7 +1400,8 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     dir = DB_MEMORY;
   }
   relation_remove(name, 1);
-  relation_create(name, dir);
+  /* A stored result keeps the format of the relation. */
+  relation_create(name, dir, dir == DB_STORAGE ? rel->flags : 0);
   handle->result_rel = relation_load(name);
 
   if(handle->result_rel == NULL) {
@@ -903,7 +1409,8 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     return DB_ALLOCATION_ERROR;
   }
 
-  for(i = normal_attributes = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
+  normal_attributes = aggregated_attributes = 0;
+  for(i = 0; i < AQL_ATTRIBUTE_COUNT(adt); i++) {
     attribute_name = adt->attributes[i].name;
 
     attr = relation_attribute_get(rel, attribute_name);
@@ -916,10 +1423,17 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     PRINTF("DB: Found attribute %s in relation %s\n",
 	attribute_name, rel->name);
 
+    if(adt->aggregators[i] == AQL_MEDIAN) {
+      PRINTF("DB: The median cannot be computed in one pass\n");
+      relation_release(handle->result_rel);
+      return DB_IMPLEMENTATION_ERROR;
+    }
+
+    /* Aggregated values may exceed the range of the attribute. */
     attr = relation_attribute_add(handle->result_rel, dir,
 				  attribute_name, 
-				  adt->aggregators[i] ? DOMAIN_INT : attr->domain,
-				  attr->element_size);
+				  adt->aggregators[i] ? DOMAIN_LONG : attr->domain,
+				  adt->aggregators[i] ? 4 : attr->element_size);
     if(attr == NULL) {
       PRINTF("DB: Failed to add a result attribute\n");
       relation_release(handle->result_rel);
@@ -927,31 +1441,24 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     }
 
     attr->aggregator = adt->aggregators[i];
-    switch(attr->aggregator) {
-    case AQL_NONE:
-      if(!(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
-        /* Only count attributes projected into the result set. */
-        normal_attributes++;
-      }
-      break;
-    case AQL_MAX:
-      attr->aggregation_value = LONG_MIN;
-      break;
-    case AQL_MIN:
-      attr->aggregation_value = LONG_MAX;
-      break;
-    default:
-      attr->aggregation_value = 0;
-      break;
-    }
-
     attr->flags = adt->attributes[i].flags;
+
+    /* Only count attributes projected into the result set. The
+       grouping attribute may be projected with aggregates. */
+    if(attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
+      continue;
+    } else if(attr->aggregator != AQL_NONE) {
+      aggregated_attributes++;
+    } else if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) ||
+              i != adt->group_attribute) {
+      normal_attributes++;
+    }
   }
 
   /* Preclude mixes of normal attributes and aggregated ones in 
      selection results. */
   if(normal_attributes > 0 &&
-     handle->result_rel->attribute_count > normal_attributes) {
+     (aggregated_attributes > 0 || (AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP))) {
      return DB_RELATIONAL_ERROR;
   }
 
@@ -959,39 +1466,393 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
 }
 
 #if DB_FEATURE_JOIN
-db_result_t
-relation_process_join(void *handle_ptr)
+/*
+ * Join strategies. The planner in relation_join() picks one from the
+ * cardinalities of the relations and from the indexes on the join
+ * attribute.
+ */
+enum {
+  JOIN_INDEX,	/* Index lookups in the right relation for each left row. */
+  JOIN_HASH,	/* A hash table over the smaller relation. */
+  JOIN_MERGE	/* A merge of two relations sorted on the attribute. */
+};
+
+/* The phases of a hash join. */
+enum {
+  JOIN_PHASE_COUNT,
+  JOIN_PHASE_PARTITION,
+  JOIN_PHASE_BUILD,
+  JOIN_PHASE_PROBE,
+  JOIN_PHASE_MATCH
+};
+
+/* The number of keys that a join reads in one processing step if it
+   does not produce a row before that. */
+#define JOIN_STEP		64
+
+/* The number of spilled records that are read from storage at a time. */
+#define JOIN_READ_RECORDS	8
+
+#define JOIN_NONE		0xffff
+
+typedef uint16_t join_slot_t;
+
+#if DB_JOIN_PARTITIONS > 255
+#error "DB_JOIN_PARTITIONS must fit in 8 bits."
+#endif
+
+/* A join key and the row that it belongs to. Spilled partitions
+   consist of these records. */
+struct join_record {
+  long key;
+  tuple_id_t tuple_id;
+};
+
+struct join_entry {
+  struct join_record record;
+  join_slot_t next;
+};
+
+/*
+ * A join input reads the keys of one of the relations in a join,
+ * either from the relation itself or from a partition in the spill
+ * file.
+ */
+struct join_input {
+  relation_t *rel;
+  attribute_t *attr;
+  storage_scan_t *scan;
+  unsigned char *row;
+  unsigned offset;
+  tuple_id_t next;
+  /* The end of the partition that is read, or INVALID_TUPLE when
+     the keys are read from the relation. */
+  tuple_id_t end;
+  /* The record offsets of the partitions in the spill file. */
+  tuple_id_t regions[DB_JOIN_PARTITIONS + 1];
+};
+
+static struct {
+  struct join_input left;
+  struct join_input right;
+  struct join_input *build;
+  struct join_input *probe;
+  struct join_input *input;
+  db_storage_id_t storage;
+  char filename[DB_MAX_FILENAME_LENGTH];
+  tuple_id_t read_first;
+  tuple_id_t group_start;
+  long key;
+  join_slot_t used;
+  join_slot_t match;
+  uint8_t read_count;
+  uint8_t strategy;
+  uint8_t phase;
+  uint8_t partitions;
+  uint8_t partition;
+  uint8_t build_done;
+  uint8_t in_group;
+} join;
+
+/* The join table. While the relations are partitioned, the same
+   memory holds a write buffer for each partition. */
+static union {
+  struct join_entry entries[DB_JOIN_TABLE_SIZE];
+  struct join_record records[DB_JOIN_TABLE_SIZE];
+} join_memory;
+static join_slot_t join_buckets[DB_JOIN_BUCKETS];
+static tuple_id_t join_fill[DB_JOIN_PARTITIONS];
+static join_slot_t join_buffered[DB_JOIN_PARTITIONS];
+static struct join_record join_read_buffer[JOIN_READ_RECORDS];
+
+static unsigned
+join_partition(long key)
 {
-  db_handle_t *handle;
+  return (hash_key(key) >> 8) % join.partitions;
+}
+
+static void
+join_input_init(struct join_input *input, relation_t *rel,
+                attribute_t *attr, storage_scan_t *scan, unsigned char *row)
+{
+  input->rel = rel;
+  input->attr = attr;
+  input->scan = scan;
+  input->row = row;
+  input->offset = get_attribute_value_offset(rel, attr);
+  input->next = 0;
+  input->end = INVALID_TUPLE;
+  memset(input->regions, 0, sizeof(input->regions));
+}
+
+/* Read the key at the current position of a join input. */
+static db_result_t
+join_read(struct join_input *input, struct join_record *record)
+{
+  storage_row_t row_ptr;
   db_result_t result;
-  relation_t *left_rel;
-  relation_t *right_rel;
+  unsigned count;
+
+  if(input->end == INVALID_TUPLE) {
+    result = storage_scan_get_row(input->scan, input->next, &row_ptr);
+    if(result != DB_OK) {
+      return result;
+    }
+    record->key = get_predicate_value(input->attr, row_ptr + input->offset);
+    record->tuple_id = input->next;
+    return DB_OK;
+  }
+
+  if(input->next >= input->end) {
+    return DB_FINISHED;
+  }
+
+  if(input->next < join.read_first ||
+     input->next >= join.read_first + join.read_count) {
+    count = JOIN_READ_RECORDS;
+    if(count > input->end - input->next) {
+      count = input->end - input->next;
+    }
+    if(DB_ERROR(storage_read(join.storage, join_read_buffer,
+                             (unsigned long)input->next * sizeof(struct join_record),
+                             count * sizeof(struct join_record)))) {
+      join.read_count = 0;
+      return DB_STORAGE_ERROR;
+    }
+    join.read_first = input->next;
+    join.read_count = count;
+  }
+
+  *record = join_read_buffer[input->next - join.read_first];
+  return DB_OK;
+}
+
+/* Copy a row of a join input to the row buffer of its relation. */
+static db_result_t
+join_fetch(struct join_input *input, tuple_id_t tuple_id)
+{
+  storage_row_t row_ptr;
+  db_result_t result;
+
+  result = storage_scan_get_row(input->scan, tuple_id, &row_ptr);
+  if(DB_ERROR(result)) {
+    return result;
+  } else if(result == DB_FINISHED) {
+    PRINTF("DB: The join refers to an invalid row: %lu\n",
+           (unsigned long)tuple_id);
+    return DB_IMPLEMENTATION_ERROR;
+  }
+  memcpy(input->row, row_ptr, input->rel->row_length);
+
+  return DB_OK;
+}
+
+static void
+join_remove_storage(void)
+{
+  if(join.filename[0] != '\0') {
+    if(join.storage >= 0) {
+      storage_close(join.storage);
+    }
+    storage_remove(join.filename);
+    join.filename[0] = '\0';
+  }
+}
+
+/* Assign a region in the spill file to each partition from the
+   number of keys that were counted for it. */
+static db_result_t
+join_create_partitions(void)
+{
+  char *filename;
+  unsigned p;
+
+  join.build->regions[0] = 0;
+  for(p = 0; p < join.partitions; p++) {
+    join.build->regions[p + 1] += join.build->regions[p];
+  }
+  join.probe->regions[0] = join.build->regions[join.partitions];
+  for(p = 0; p < join.partitions; p++) {
+    join.probe->regions[p + 1] += join.probe->regions[p];
+  }
+
+  filename = storage_generate_file("join",
+                                   (unsigned long)join.probe->regions[join.partitions] *
+                                   sizeof(struct join_record));
+  if(filename == NULL) {
+    return DB_STORAGE_ERROR;
+  }
+  strncpy(join.filename, filename, sizeof(join.filename) - 1);
+  join.filename[sizeof(join.filename) - 1] = '\0';
+
+  join.storage = storage_open(join.filename);
+  if(join.storage < 0) {
+    return DB_STORAGE_ERROR;
+  }
+  join.read_count = 0;
+
+  PRINTF("DB: Spilling %lu join keys in %u partitions to %s\n",
+         (unsigned long)join.probe->regions[join.partitions],
+         join.partitions, join.filename);
+
+  return DB_OK;
+}
+
+static void
+join_start_spill(struct join_input *input)
+{
+  unsigned p;
+
+  join.input = input;
+  input->next = 0;
+  input->end = INVALID_TUPLE;
+  for(p = 0; p < join.partitions; p++) {
+    join_fill[p] = input->regions[p];
+    join_buffered[p] = 0;
+  }
+}
+
+static db_result_t
+join_flush(unsigned p)
+{
+  unsigned slice;
+  db_result_t result;
+
+  if(join_buffered[p] == 0) {
+    return DB_OK;
+  }
+
+  slice = DB_JOIN_TABLE_SIZE / join.partitions;
+  result = storage_write(join.storage, &join_memory.records[p * slice],
+                         (unsigned long)join_fill[p] * sizeof(struct join_record),
+                         join_buffered[p] * sizeof(struct join_record));
+  join_fill[p] += join_buffered[p];
+  join_buffered[p] = 0;
+
+  return result;
+}
+
+static db_result_t
+join_spill(struct join_record *record)
+{
+  unsigned p;
+  unsigned slice;
+
+  p = join_partition(record->key);
+  slice = DB_JOIN_TABLE_SIZE / join.partitions;
+  join_memory.records[p * slice + join_buffered[p]++] = *record;
+  if(join_buffered[p] == slice) {
+    return join_flush(p);
+  }
+
+  return DB_OK;
+}
+
+static void
+join_clear_table(void)
+{
+  unsigned i;
+
+  join.used = 0;
+  for(i = 0; i < DB_JOIN_BUCKETS; i++) {
+    join_buckets[i] = JOIN_NONE;
+  }
+}
+
+static join_slot_t
+join_lookup(join_slot_t slot, long key)
+{
+  while(slot != JOIN_NONE && join_memory.entries[slot].record.key != key) {
+    slot = join_memory.entries[slot].next;
+  }
+  return slot;
+}
+
+static void
+join_open_partition(struct join_input *input)
+{
+  if(join.partitions > 1) {
+    input->next = input->regions[join.partition];
+    input->end = input->regions[join.partition + 1];
+  } else {
+    input->next = 0;
+    input->end = INVALID_TUPLE;
+  }
+}
+
+/* Set up the inputs to read the current partition of both relations. */
+static void
+join_start_partition(void)
+{
+  join_open_partition(join.build);
+  join_open_partition(join.probe);
+  join.build_done = 0;
+  join_clear_table();
+  join.phase = JOIN_PHASE_BUILD;
+}
+
+static void
+join_rewind_probe(void)
+{
+  join_open_partition(join.probe);
+  join.phase = JOIN_PHASE_PROBE;
+}
+
+/* Fill in the resulting tuple from the rows in the row buffers of the
+   left and the right relation. */
+static db_result_t
+join_emit(db_handle_t *handle)
+{
   relation_t *join_rel;
   unsigned char *join_next_attribute_ptr;
   size_t element_size;
+  int i;
+
+  join_rel = handle->join_rel;
+  join_next_attribute_ptr = join_row;
+
+  for(i = 0; i < join_rel->attribute_count; i++) {
+    element_size = source_map[i].attr->element_size;
+
+    memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
+    join_next_attribute_ptr += element_size;
+  }
+
+  if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(join_rel, join_row))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+static db_result_t
+process_index_join(db_handle_t *handle)
+{
+  db_result_t result;
+  relation_t *left_rel;
   tuple_id_t right_tuple_id;
   attribute_value_t value;
-  int i;
+  storage_row_t row_ptr;
 
-  handle = (db_handle_t *)handle_ptr;
   left_rel = handle->left_rel;
-  right_rel = handle->right_rel;
-  join_rel = handle->join_rel;
 
   if(!(handle->flags & DB_HANDLE_FLAG_INDEX_STEP)) {
     goto inner_loop;
   }
 
-  /* Equi-join for indexed attributes only. In the outer loop, we iterate over
-     each tuple in the left relation. */
+  /* In the outer loop, we iterate over each tuple in the left relation. */
   for(handle->tuple_id = 0;; handle->tuple_id++) {
-    result = storage_get_row(left_rel, &handle->tuple_id, left_row);
+    result = storage_scan_get_row(&handle->scan, handle->tuple_id, &row_ptr);
     if(DB_ERROR(result)) {
       PRINTF("DB: Failed to get a row in left relation %s!\n", left_rel->name);
       return result;
     } else if(result == DB_FINISHED) {
       return DB_FINISHED;
     }
+    memcpy(left_row, row_ptr, left_rel->row_length);
 
     if(DB_ERROR(relation_get_value(left_rel, handle->left_join_attr, left_row, &value))) {
       PRINTF("DB: Failed to get a value of the attribute \"%s\" to join on\n",
@@ -1010,48 +1871,308 @@ relation_process_join(void *handle_ptr)
     /* In the inner loop, we iterate over all rows with a matching value for the
        join attribute. The index component provides an iterator for this purpose. */
 inner_loop:
-    for(;;) {
-      /* Get all rows matching the attribute value in the right relation. */
-      right_tuple_id = index_get_next(&handle->index_iterator);
-      if(right_tuple_id == INVALID_TUPLE) {
-        /* Exclude this row from the left relation in the result,
-           and step to the next value in the index iteration. */
-        handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+    /* Get all rows matching the attribute value in the right relation. */
+    right_tuple_id = index_get_next(&handle->index_iterator);
+    if(right_tuple_id == INVALID_TUPLE) {
+      /* Exclude this row from the left relation in the result,
+         and step to the next value in the index iteration. */
+      handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+      continue;
+    }
+
+    result = join_fetch(&join.right, right_tuple_id);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+
+    return join_emit(handle);
+  }
+
+  return DB_OK;
+}
+
+static db_result_t
+process_hash_join(db_handle_t *handle)
+{
+  struct join_record record;
+  struct join_entry *entry;
+  db_result_t result;
+  unsigned step;
+  join_slot_t *bucket;
+
+  for(step = 0; step < JOIN_STEP; step++) {
+    switch(join.phase) {
+    case JOIN_PHASE_COUNT:
+      /* Count the keys of each partition in both relations. */
+      result = join_read(join.input, &record);
+      if(DB_ERROR(result)) {
+        return result;
+      } else if(result == DB_OK) {
+        join.input->regions[join_partition(record.key) + 1]++;
+        join.input->next++;
+      } else if(join.input == join.build) {
+        join.input = join.probe;
+      } else {
+        result = join_create_partitions();
+        if(DB_ERROR(result)) {
+          return result;
+        }
+        join_start_spill(join.build);
+        join.phase = JOIN_PHASE_PARTITION;
+      }
+      break;
+    case JOIN_PHASE_PARTITION:
+      /* Write the keys of both relations to the spill file. */
+      result = join_read(join.input, &record);
+      if(result == DB_OK) {
+        result = join_spill(&record);
+        join.input->next++;
+      } else if(result == DB_FINISHED) {
+        for(join.partition = 0; join.partition < join.partitions;
+            join.partition++) {
+          result = join_flush(join.partition);
+          if(DB_ERROR(result)) {
+            break;
+          }
+        }
+        if(join.input == join.build) {
+          join_start_spill(join.probe);
+        } else {
+          join.partition = 0;
+          join_start_partition();
+        }
+      }
+      if(DB_ERROR(result)) {
+        return result;
+      }
+      break;
+    case JOIN_PHASE_BUILD:
+      /* Fill the table with keys from the build relation. If the
+         partition does not fit, it is joined in several rounds. */
+      if(join.used == DB_JOIN_TABLE_SIZE) {
+        join_rewind_probe();
         break;
       }
-
-      result = storage_get_row(right_rel, &right_tuple_id, right_row);
+      result = join_read(join.build, &record);
       if(DB_ERROR(result)) {
-        PRINTF("DB: Failed to get a row in right relation %s!\n", right_rel->name);
         return result;
       } else if(result == DB_FINISHED) {
-	PRINTF("DB: The index refers to an invalid row: %lu\n",
-	       (unsigned long)right_tuple_id);
-        return DB_IMPLEMENTATION_ERROR;
+        join.build_done = 1;
+        if(join.used > 0) {
+          join_rewind_probe();
+        } else if(++join.partition < join.partitions) {
+          join_start_partition();
+        } else {
+          join_remove_storage();
+          return DB_FINISHED;
+        }
+        break;
       }
+      join.build->next++;
+      bucket = &join_buckets[(hash_key(record.key) >> 16) % DB_JOIN_BUCKETS];
+      entry = &join_memory.entries[join.used];
+      entry->record = record;
+      entry->next = *bucket;
+      *bucket = join.used++;
+      break;
+    case JOIN_PHASE_PROBE:
+      result = join_read(join.probe, &record);
+      if(DB_ERROR(result)) {
+        return result;
+      } else if(result == DB_FINISHED) {
+        if(!join.build_done) {
+          join_clear_table();
+          join.phase = JOIN_PHASE_BUILD;
+        } else if(++join.partition < join.partitions) {
+          join_start_partition();
+        } else {
+          join_remove_storage();
+          return DB_FINISHED;
+        }
+        break;
+      }
+      join.probe->next++;
+      bucket = &join_buckets[(hash_key(record.key) >> 16) % DB_JOIN_BUCKETS];
+      join.match = join_lookup(*bucket, record.key);
+      if(join.match != JOIN_NONE) {
+        result = join_fetch(join.probe, record.tuple_id);
+        if(DB_ERROR(result)) {
+          return result;
+        }
+        join.key = record.key;
+        join.phase = JOIN_PHASE_MATCH;
+      }
+      break;
+    case JOIN_PHASE_MATCH:
+      entry = &join_memory.entries[join.match];
+      result = join_fetch(join.build, entry->record.tuple_id);
+      if(DB_ERROR(result)) {
+        return result;
+      }
+      join.match = join_lookup(entry->next, join.key);
+      if(join.match == JOIN_NONE) {
+        join.phase = JOIN_PHASE_PROBE;
+      }
+      return join_emit(handle);
+    }
+  }
 
-      /* Use the source attribute map to fill in the physical representation
-	 of the resulting tuple. */
-      join_next_attribute_ptr = join_row;
+  return DB_OK;
+}
 
-      for(i = 0; i < join_rel->attribute_count; i++) {
-	element_size = source_map[i].attr->element_size;
+static db_result_t
+process_merge_join(db_handle_t *handle)
+{
+  struct join_record left;
+  struct join_record right;
+  db_result_t result;
+  unsigned step;
 
-	memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
-	join_next_attribute_ptr += element_size;
+  for(step = 0; step < JOIN_STEP; step++) {
+    result = join_read(&join.left, &left);
+    if(result != DB_OK) {
+      return result;
+    }
+    result = join_read(&join.right, &right);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+
+    if(!join.in_group) {
+      if(result == DB_FINISHED) {
+        return DB_FINISHED;
       }
+      if(left.key < right.key) {
+        join.left.next++;
+      } else if(left.key > right.key) {
+        join.right.next++;
+      } else {
+        join.in_group = 1;
+        join.group_start = join.right.next;
+        join.key = left.key;
+      }
+      continue;
+    }
 
-      if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(join_rel, join_row))) {
-          return DB_STORAGE_ERROR;
-        }
+    if(result == DB_OK && right.key == join.key) {
+      if(DB_ERROR(result = join_fetch(&join.left, left.tuple_id)) ||
+         DB_ERROR(result = join_fetch(&join.right, right.tuple_id))) {
+        return result;
       }
+      join.right.next++;
+      return join_emit(handle);
+    }
 
-      handle->current_row++;
-      return DB_GOT_ROW;
+    /* The left row has been joined with the whole group of rows with
+       the same key in the right relation. The next left row is joined
+       with the same group if it has the same key. */
+    join.left.next++;
+    result = join_read(&join.left, &left);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+    if(result == DB_OK && left.key == join.key) {
+      join.right.next = join.group_start;
+    } else {
+      join.in_group = 0;
+    }
+  }
+
+  return DB_OK;
+}
+
+db_result_t
+relation_process_join(void *handle_ptr)
+{
+  db_handle_t *handle;
+
+  handle = (db_handle_t *)handle_ptr;
+
+  switch(join.strategy) {
+  case JOIN_HASH:
+    return process_hash_join(handle);
+  case JOIN_MERGE:
+    return process_merge_join(handle);
+  default:
+    return process_index_join(handle);
+  }
+}
+
+void
+relation_free_join(void *handle_ptr)
+{
+  join_remove_storage();
+}
+
+/* Choose a join strategy from the sizes of the relations and the
+   indexes on the join attribute. */
+static db_result_t
+plan_join(db_handle_t *handle)
+{
+  tuple_id_t left_cardinality;
+  tuple_id_t right_cardinality;
+  unsigned long partitions;
+  attribute_t *left_attr;
+  attribute_t *right_attr;
+
+  left_attr = handle->left_join_attr;
+  right_attr = handle->right_join_attr;
+
+  join_remove_storage();
+  join_input_init(&join.left, handle->left_rel, left_attr,
+                  &handle->scan, left_row);
+  join_input_init(&join.right, handle->right_rel, right_attr,
+                  &handle->right_scan, right_row);
+
+  left_cardinality = relation_cardinality(handle->left_rel);
+  right_cardinality = relation_cardinality(handle->right_rel);
+  if(left_cardinality == INVALID_TUPLE || right_cardinality == INVALID_TUPLE) {
+    return DB_STORAGE_ERROR;
+  }
+
+  if(index_exists(right_attr) &&
+     ((unsigned long)left_cardinality * DB_JOIN_INDEX_RATIO <= right_cardinality ||
+      left_attr->domain == DOMAIN_STRING || right_attr->domain == DOMAIN_STRING)) {
+    join.strategy = JOIN_INDEX;
+  } else if(left_attr->domain == DOMAIN_STRING ||
+            right_attr->domain == DOMAIN_STRING) {
+    PRINTF("DB: Joins on strings require an index on the right relation\n");
+    return DB_INDEX_ERROR;
+  } else if(attribute_is_sorted(left_attr) && attribute_is_sorted(right_attr)) {
+    join.strategy = JOIN_MERGE;
+    join.in_group = 0;
+  } else {
+    join.strategy = JOIN_HASH;
+    if(left_cardinality <= right_cardinality) {
+      join.build = &join.left;
+      join.probe = &join.right;
+    } else {
+      join.build = &join.right;
+      join.probe = &join.left;
+      left_cardinality = right_cardinality;
+    }
+
+    /* Clamp before narrowing to the 8-bit partition count. */
+    partitions = ((unsigned long)left_cardinality + DB_JOIN_TABLE_SIZE - 1) /
+                 DB_JOIN_TABLE_SIZE;
+    if(partitions > DB_JOIN_PARTITIONS) {
+      partitions = DB_JOIN_PARTITIONS;
+    }
+    join.partitions = partitions;
+    if(join.partitions <= 1) {
+      join.partitions = 1;
+      join.partition = 0;
+      join_start_partition();
+    } else {
+      join.input = join.build;
+      join.phase = JOIN_PHASE_COUNT;
     }
   }
 
+  PRINTF("DB: Joining %lu and %lu rows with strategy %u\n",
+         (unsigned long)left_cardinality, (unsigned long)right_cardinality,
+         join.strategy);
+
   return DB_OK;
 }
 
@@ -1067,6 +2188,7 @@ generate_join_result(db_handle_t *handle)
   int i;
   int offset;
   unsigned char *from_ptr;
+  db_result_t result;
 
   handle->tuple = (tuple_t)join_row;
   handle->tuple_id = 0;
@@ -1075,6 +2197,10 @@ generate_join_result(db_handle_t *handle)
   right_rel = handle->right_rel;
   join_rel = handle->join_rel;
 
+  storage_scan_init(&handle->scan, left_rel, scan_block, sizeof(scan_block));
+  storage_scan_init(&handle->right_scan, right_rel, right_scan_block,
+                    sizeof(right_scan_block));
+
   /* Generate a map over the source attributes for each
      attribute in the join relation. */
   for(i = 0, result_attr = list_head(join_rel->attributes);
@@ -1102,6 +2228,11 @@ generate_join_result(db_handle_t *handle)
     source_pair->from_ptr = from_ptr;
   }
 
+  result = plan_join(handle);
+  if(DB_ERROR(result)) {
+    return result;
+  }
+
   handle->flags |= DB_HANDLE_FLAG_PROCESSING;
 
   return DB_OK;
@@ -1137,7 +2268,7 @@ relation_join(void *query_result, void *adt_ptr)
     dir = DB_MEMORY;
   }
   relation_remove(name, 1);
-  relation_create(name, dir);
+  relation_create(name, dir, 0);
   join_rel = relation_load(name);
   handle->result_rel = join_rel;
 
@@ -1158,11 +2289,6 @@ relation_join(void *query_result, void *adt_ptr)
     return DB_RELATIONAL_ERROR;
   }
 
-  if(!index_exists(handle->right_join_attr)) {
-    PRINTF("DB: The attribute to join on is not indexed\n");
-    return DB_INDEX_ERROR;
-  }
-
   /*
    * Define the resulting relation. We start from 1 when counting attributes
    * because the first attribute is only the one to join, and is not included
@@ -56,6 +56,9 @@ typedef enum db_direction {
 
 #define RELATION_HAS_TUPLES(rel) ((rel)->tuple_storage >= 0)
 
+/* The rows are stored in compressed blocks that are appended to. */
+#define RELATION_FLAG_SERIES	0x1
+
 /*
  * A relation consists of a name, a set of domains, a set of indexes,
  * and a set of keys. Each relation must have a primary key.
@@ -70,6 +73,7 @@ struct relation {
   tuple_id_t next_row;
   db_storage_id_t tuple_storage;
   db_direction_t dir;
+  uint8_t flags;
   uint8_t references;
   char name[RELATION_NAME_LENGTH + 1];
   char tuple_filename[RELATION_NAME_LENGTH + 1];
@@ -82,9 +86,10 @@ db_result_t relation_init(void);
 db_result_t relation_process_remove(void *);
 db_result_t relation_process_select(void *);
 db_result_t relation_process_join(void *);
+void relation_free_join(void *);
 relation_t *relation_load(char *);
 db_result_t relation_release(relation_t *);
-relation_t *relation_create(char *, db_direction_t);
+relation_t *relation_create(char *, db_direction_t, uint8_t);
 db_result_t relation_rename(char *, char *);
 attribute_t *relation_attribute_add(relation_t *, db_direction_t, char *,
 				    domain_t, size_t);
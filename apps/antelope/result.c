@@ -178,6 +178,11 @@ db_free(db_handle_t *handle)
   if(handle->right_rel != NULL) {
     relation_release(handle->right_rel);
   }
+#if DB_FEATURE_JOIN
+  if(handle->join_rel != NULL) {
+    relation_free_join(handle);
+  }
+#endif /* DB_FEATURE_JOIN */
 
   handle->flags = 0;
 
@@ -49,9 +49,13 @@ typedef unsigned char *tuple_t;
 #define DB_HANDLE_FLAG_INDEX_STEP	0x01
 #define DB_HANDLE_FLAG_SEARCH_INDEX	0x02
 #define DB_HANDLE_FLAG_PROCESSING	0x04
+#define DB_HANDLE_FLAG_BATCH_FILTER	0x08
+#define DB_HANDLE_FLAG_EMIT_GROUPS	0x10
 
 struct db_handle {
   index_iterator_t index_iterator;
+  storage_scan_t scan;
+  storage_scan_t right_scan;
   tuple_id_t tuple_id;
   tuple_id_t current_row;
   relation_t *rel;
@@ -47,6 +47,7 @@
 
 #include "db-options.h"
 #include "storage.h"
+#include "storage-series.h"
 
 struct attribute_record {
   char name[ATTRIBUTE_NAME_LENGTH];
@@ -79,12 +80,18 @@ char *
 storage_generate_file(char *prefix, unsigned long size)
 {
   static char filename[ATTRIBUTE_NAME_LENGTH + sizeof(".ffff")];
-#if !DB_FEATURE_COFFEE
   int fd;
-#endif
 
-  snprintf(filename, sizeof(filename), "%s.%x", prefix,
-           (unsigned)(random_rand() & 0xffff));
+  /* The MaxHeap index reseeds the random generator with its keys, so
+     the same names can come up again. Skip names that are in use. */
+  do {
+    snprintf(filename, sizeof(filename), "%s.%x", prefix,
+             (unsigned)(random_rand() & 0xffff));
+    fd = cfs_open(filename, CFS_READ);
+    if(fd >= 0) {
+      cfs_close(fd);
+    }
+  } while(fd >= 0);
 
 #if DB_FEATURE_COFFEE
   PRINTF("DB: Reserving %lu bytes in %s\n", size, filename);
@@ -156,6 +163,11 @@ storage_get_relation(relation_t *rel, char *name)
 
   rel->tuple_filename[sizeof(rel->tuple_filename) - 1] ^= ROW_XOR;
 
+  if(strncmp(rel->tuple_filename, SERIES_FILE_PREFIX ".",
+             sizeof(SERIES_FILE_PREFIX)) == 0) {
+    rel->flags |= RELATION_FLAG_SERIES;
+  }
+
   /* Read attribute records. */
   result = DB_OK;
   for(i = 0;; i++) {
@@ -212,7 +224,9 @@ storage_put_relation(relation_t *rel)
   }
 
   if(rel->tuple_filename[0] == '\0') {
-    str = storage_generate_file("tuple", DB_COFFEE_RESERVE_SIZE);
+    str = storage_generate_file(rel->flags & RELATION_FLAG_SERIES ?
+                                SERIES_FILE_PREFIX : "tuple",
+                                DB_COFFEE_RESERVE_SIZE);
     if(str == NULL) {
       cfs_close(fd);
       cfs_remove(rel->name);
@@ -279,6 +293,12 @@ storage_put_attribute(relation_t *rel, attribute_t *attr)
 db_result_t
 storage_drop_relation(relation_t *rel, int remove_tuples)
 {
+#if DB_FEATURE_SERIES
+  if(rel->flags & RELATION_FLAG_SERIES) {
+    series_drop(rel);
+  }
+#endif /* DB_FEATURE_SERIES */
+
   if(remove_tuples && RELATION_HAS_TUPLES(rel)) {
     cfs_remove(rel->tuple_filename);
   }
@@ -406,6 +426,12 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
   int r;
   tuple_id_t nrows;
 
+#if DB_FEATURE_SERIES
+  if(rel->flags & RELATION_FLAG_SERIES) {
+    return series_get_row(rel, *tuple_id, row);
+  }
+#endif /* DB_FEATURE_SERIES */
+
   if(DB_ERROR(storage_get_row_amount(rel, &nrows))) {
     return DB_STORAGE_ERROR;
   }
@@ -449,6 +475,12 @@ storage_put_row(relation_t *rel, storage_row_t row)
   char buf[rel->row_length];
 #endif
 
+#if DB_FEATURE_SERIES
+  if(rel->flags & RELATION_FLAG_SERIES) {
+    return series_put_row(rel, row);
+  }
+#endif /* DB_FEATURE_SERIES */
+
   end = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
   if(end == (cfs_offset_t)-1) {
     return DB_STORAGE_ERROR;
@@ -496,6 +528,10 @@ storage_get_row_amount(relation_t *rel, tuple_id_t *amount)
 
   if(rel->row_length == 0) {
     *amount = 0;
+#if DB_FEATURE_SERIES
+  } else if(rel->flags & RELATION_FLAG_SERIES) {
+    return series_get_row_amount(rel, amount);
+#endif /* DB_FEATURE_SERIES */
   } else {
     offset = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
     if(offset == (cfs_offset_t)-1) {
@@ -508,6 +544,155 @@ storage_get_row_amount(relation_t *rel, tuple_id_t *amount)
   return DB_OK;
 }
 
+void
+storage_scan_init(storage_scan_t *scan, relation_t *rel,
+                  unsigned char *block, unsigned block_size)
+{
+  scan->rel = rel;
+  scan->block = block;
+  scan->block_size = block_size;
+  scan->nrows = INVALID_TUPLE;
+  scan->first = 0;
+  scan->count = 0;
+  scan->range_attr = NULL;
+}
+
+void
+storage_scan_set_range(storage_scan_t *scan, attribute_t *attr,
+                       long min, long max)
+{
+  if(scan->rel->flags & RELATION_FLAG_SERIES) {
+    scan->range_attr = attr;
+    scan->range_min = min;
+    scan->range_max = max;
+  }
+}
+
+static db_result_t
+scan_fill(storage_scan_t *scan, tuple_id_t tuple_id)
+{
+  relation_t *rel;
+  unsigned rows;
+  unsigned length;
+  unsigned char *ptr;
+  int r;
+
+#if DB_FEATURE_SERIES
+  if(scan->rel->flags & RELATION_FLAG_SERIES) {
+    return series_scan_fill(scan, tuple_id);
+  }
+#endif /* DB_FEATURE_SERIES */
+
+  rel = scan->rel;
+  rows = scan->block_size / rel->row_length;
+  if(rows == 0) {
+    PRINTF("DB: A row of %u bytes does not fit in the scan block\n",
+           (unsigned)rel->row_length);
+    return DB_LIMIT_ERROR;
+  }
+
+  /* Read a whole block if the access continues forward from the
+     buffered rows. Index lookups that jump elsewhere read one row. */
+  if(scan->count > 0 &&
+     (tuple_id < scan->first ||
+      tuple_id - (scan->first + scan->count) >= rows)) {
+    rows = 1;
+  }
+  if(rows > scan->nrows - tuple_id) {
+    rows = scan->nrows - tuple_id;
+  }
+
+  scan->count = 0;
+  if(cfs_seek(rel->tuple_storage, (cfs_offset_t)tuple_id * rel->row_length,
+              CFS_SEEK_SET) == (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+
+  ptr = scan->block;
+  length = rows * rel->row_length;
+  while(length > 0) {
+    r = cfs_read(rel->tuple_storage, ptr, length);
+    if(r <= 0) {
+      PRINTF("DB: Reading failed on fd %d\n", rel->tuple_storage);
+      return DB_STORAGE_ERROR;
+    }
+    ptr += r;
+    length -= r;
+  }
+
+  for(ptr = scan->block + rel->row_length - 1;
+      ptr < scan->block + rows * rel->row_length;
+      ptr += rel->row_length) {
+    *ptr ^= ROW_XOR;
+  }
+
+  scan->first = tuple_id;
+  scan->count = rows;
+
+  PRINTF("DB: Read %u rows from relation %s\n", rows, rel->name);
+
+  return DB_OK;
+}
+
+db_result_t
+storage_scan_get_row(storage_scan_t *scan, tuple_id_t tuple_id,
+                     storage_row_t *row)
+{
+  db_result_t result;
+
+  if(scan->nrows == INVALID_TUPLE) {
+    if(DB_ERROR(storage_get_row_amount(scan->rel, &scan->nrows))) {
+      scan->nrows = INVALID_TUPLE;
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  if(tuple_id >= scan->nrows) {
+    return DB_FINISHED;
+  }
+
+  if(tuple_id < scan->first || tuple_id >= scan->first + scan->count) {
+    result = scan_fill(scan, tuple_id);
+    if(result != DB_OK) {
+      return result;
+    }
+  }
+
+  *row = scan->block + (tuple_id - scan->first) * scan->rel->row_length;
+  return DB_OK;
+}
+
+unsigned
+storage_scan_buffered(storage_scan_t *scan, tuple_id_t tuple_id)
+{
+  if(tuple_id < scan->first || tuple_id >= scan->first + scan->count) {
+    return 0;
+  }
+  return scan->first + scan->count - tuple_id;
+}
+
+tuple_id_t
+storage_scan_skip(storage_scan_t *scan, tuple_id_t tuple_id)
+{
+#if DB_FEATURE_SERIES
+  if(scan->range_attr != NULL &&
+     (tuple_id < scan->first || tuple_id >= scan->first + scan->count)) {
+    return series_scan_skip(scan, tuple_id);
+  }
+#endif /* DB_FEATURE_SERIES */
+  return tuple_id;
+}
+
+db_result_t
+storage_flush(void)
+{
+#if DB_FEATURE_SERIES
+  return series_flush();
+#else
+  return DB_OK;
+#endif /* DB_FEATURE_SERIES */
+}
+
 db_storage_id_t
 storage_open(const char *filename)
 {
@@ -528,6 +713,12 @@ storage_close(db_storage_id_t fd)
   cfs_close(fd);
 }
 
+void
+storage_remove(const char *filename)
+{
+  cfs_remove(filename);
+}
+
 db_result_t
 storage_read(db_storage_id_t fd,
 	     void *buffer, unsigned long offset, unsigned length)
@@ -548,7 +739,13 @@ storage_read(db_storage_id_t fd,
   ptr = buffer;
   while(length > 0) {
     r = cfs_read(fd, ptr, length);
-    if(r <= 0) {
+    if(r == 0) {
+      /* File systems that do not extend a file when seeking past its
+         end return end-of-file instead of the unwritten zeroes. */
+      memset(ptr, 0, length);
+      break;
+    }
+    if(r < 0) {
       return DB_STORAGE_ERROR;
     }
     ptr += r;
@@ -0,0 +1,882 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	An append-only storage format for time series. The rows of a
+ *	series relation are collected in memory, and are then written
+ *	column by column in a compressed block of a fixed size.
+ *
+ *	Numeric values are stored as variable-length differences to the
+ *	previous value in the column, or as differences of differences,
+ *	which reduces regular timestamps to a byte each. Each block
+ *	records the range of every numeric column, so that scans can skip
+ *	the blocks that cannot match the predicate of a query.
+ */
+
+#include <string.h>
+
+#include "cfs/cfs.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#include "db-options.h"
+#include "storage-series.h"
+
+#if DB_FEATURE_SERIES
+
+/*
+ * The layout of a block:
+ *
+ *   The tuple ID of the first row, 4 bytes.
+ *   The number of rows, 1 byte.
+ *   A descriptor for each attribute: the encoding of the column, and
+ *   for numeric attributes the minimum and maximum values, 4 bytes each.
+ *   The columns, in the order of the attributes.
+ *
+ * The last byte of a block is a non-zero mark, so that Coffee
+ * determines the length of the file correctly.
+ */
+#define BLOCK_FIRST_ROW		0
+#define BLOCK_ROW_COUNT		4
+#define BLOCK_HEADER		5
+#define BLOCK_MARK		0xa5
+
+#define MAX_ROWS		255
+
+/* Column encodings. */
+#define ENCODING_RAW		0	/* The values as in the row. */
+#define ENCODING_DELTA		1	/* Differences between the values. */
+#define ENCODING_DOD		2	/* Differences between the differences. */
+
+#define IS_NUMERIC(domain)	((domain) == DOMAIN_INT || \
+				 (domain) == DOMAIN_LONG)
+#define DESCRIPTOR_SIZE(domain)	(IS_NUMERIC(domain) ? 9 : 1)
+
+/* The largest encoding of a numeric value. */
+#define MAX_VARINT_SIZE		5
+
+/* The encoded size of a column of the rows in the buffer is tracked
+   for both numeric encodings, and the smaller one is written. */
+struct column {
+  uint32_t last;
+  uint32_t delta;
+  long min;
+  long max;
+  uint16_t delta_length;
+  uint16_t dod_length;
+  uint8_t domain;
+  uint8_t size;
+};
+
+/* The rows of one relation that have not been written yet. */
+struct buffer {
+  char filename[RELATION_NAME_LENGTH + 1];
+  tuple_id_t first;
+  uint16_t last_use;
+  uint8_t count;
+  uint8_t capacity;
+  uint8_t columns;
+  uint8_t row_length;
+  struct column column[DB_MAX_ATTRIBUTES_PER_RELATION];
+  unsigned char rows[DB_SERIES_BUFFER_SIZE];
+};
+
+/* Each series relation that is inserted into gets its own buffer, so
+   that interleaved inserts into a few relations still fill their
+   blocks. */
+static struct buffer buffers[DB_SERIES_BUFFERS];
+static uint16_t use_count;
+
+/* The most recently read block, or only its header if the block has
+   not been loaded completely. The data is also used for encoding. */
+static struct {
+  char filename[RELATION_NAME_LENGTH + 1];
+  unsigned long number;
+  tuple_id_t first;
+  uint8_t count;
+  uint8_t loaded;
+  unsigned char data[DB_SERIES_BLOCK_SIZE];
+} block;
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get_u32(const unsigned char *ptr)
+{
+  return (uint32_t)ptr[0] << 24 | (uint32_t)ptr[1] << 16 |
+         (uint32_t)ptr[2] << 8 | ptr[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_u32(unsigned char *ptr, uint32_t value)
+{
+  ptr[0] = value >> 24;
+  ptr[1] = value >> 16;
+  ptr[2] = value >> 8;
+  ptr[3] = value;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get_value(const unsigned char *ptr, uint8_t domain)
+{
+  if(domain == DOMAIN_INT) {
+    return (uint32_t)ptr[0] << 8 | ptr[1];
+  }
+  return get_u32(ptr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_value(unsigned char *ptr, uint8_t domain, uint32_t value)
+{
+  if(domain == DOMAIN_INT) {
+    ptr[0] = value >> 8;
+    ptr[1] = value;
+  } else {
+    put_u32(ptr, value);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Map signed differences to unsigned values, so that small negative
+   differences are also encoded in few bytes. */
+static uint32_t
+zigzag(uint32_t value)
+{
+  return (value << 1) ^ (value & 0x80000000UL ? 0xffffffffUL : 0);
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+unzigzag(uint32_t value)
+{
+  return (value >> 1) ^ (value & 1 ? 0xffffffffUL : 0);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+varint_length(uint32_t value)
+{
+  unsigned length;
+
+  for(length = 1; value >= 0x80; value >>= 7) {
+    length++;
+  }
+  return length;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned char *
+put_varint(unsigned char *ptr, uint32_t value)
+{
+  while(value >= 0x80) {
+    *ptr++ = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  *ptr++ = value;
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
+static const unsigned char *
+get_varint(const unsigned char *ptr, const unsigned char *end,
+           uint32_t *value)
+{
+  unsigned shift;
+
+  *value = 0;
+  for(shift = 0; ptr < end && shift < 7 * MAX_VARINT_SIZE; shift += 7) {
+    *value |= (uint32_t)(*ptr & 0x7f) << shift;
+    if(!(*ptr++ & 0x80)) {
+      return ptr;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+header_size(relation_t *rel)
+{
+  attribute_t *attr;
+  unsigned size;
+
+  size = BLOCK_HEADER;
+  for(attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+    size += DESCRIPTOR_SIZE(attr->domain);
+  }
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static struct buffer *
+buffer_find(relation_t *rel)
+{
+  int i;
+
+  for(i = 0; i < DB_SERIES_BUFFERS; i++) {
+    if(buffers[i].filename[0] != '\0' &&
+       strcmp(buffers[i].filename, rel->tuple_filename) == 0) {
+      return &buffers[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+block_count(db_storage_id_t fd, unsigned long *count)
+{
+  cfs_offset_t end;
+
+  end = cfs_seek(fd, 0, CFS_SEEK_END);
+  if(end == (cfs_offset_t)-1) {
+    return DB_STORAGE_ERROR;
+  }
+  *count = (unsigned long)end / DB_SERIES_BLOCK_SIZE;
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+read_block(relation_t *rel, unsigned long number, int whole)
+{
+  if(block.filename[0] != '\0' &&
+     strcmp(block.filename, rel->tuple_filename) == 0 &&
+     block.number == number && (block.loaded || !whole)) {
+    return DB_OK;
+  }
+
+  block.filename[0] = '\0';
+  if(DB_ERROR(storage_read(rel->tuple_storage, block.data,
+                           number * DB_SERIES_BLOCK_SIZE,
+                           whole ? DB_SERIES_BLOCK_SIZE :
+                                   header_size(rel)))) {
+    PRINTF("DB: Failed to read block %lu of %s\n", number, rel->name);
+    return DB_STORAGE_ERROR;
+  }
+
+  strcpy(block.filename, rel->tuple_filename);
+  block.number = number;
+  block.first = get_u32(&block.data[BLOCK_FIRST_ROW]);
+  block.count = block.data[BLOCK_ROW_COUNT];
+  block.loaded = whole;
+
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* Read the block that contains a stored row. */
+static db_result_t
+load_block(relation_t *rel, tuple_id_t tuple_id, int whole)
+{
+  unsigned long blocks;
+  unsigned long low;
+  unsigned long high;
+  unsigned long middle;
+  unsigned char first[4];
+
+  if(DB_ERROR(block_count(rel->tuple_storage, &blocks))) {
+    return DB_STORAGE_ERROR;
+  }
+  if(blocks == 0) {
+    return DB_FINISHED;
+  }
+
+  low = 0;
+  high = blocks;
+  if(block.filename[0] != '\0' &&
+     strcmp(block.filename, rel->tuple_filename) == 0 &&
+     tuple_id >= block.first) {
+    /* Scans read the blocks in order. */
+    if(tuple_id < block.first + block.count) {
+      low = block.number;
+      high = low + 1;
+    } else if(tuple_id == block.first + block.count &&
+              block.number + 1 < blocks) {
+      low = block.number + 1;
+      high = low + 1;
+    } else {
+      low = block.number;
+    }
+  }
+
+  /* Find the last block that starts at or before the row. */
+  while(high - low > 1) {
+    middle = low + (high - low) / 2;
+    if(DB_ERROR(storage_read(rel->tuple_storage, first,
+                             middle * DB_SERIES_BLOCK_SIZE + BLOCK_FIRST_ROW,
+                             sizeof(first)))) {
+      return DB_STORAGE_ERROR;
+    }
+    if(get_u32(first) <= tuple_id) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  if(DB_ERROR(read_block(rel, low, whole))) {
+    return DB_STORAGE_ERROR;
+  }
+  if(tuple_id < block.first || tuple_id >= block.first + block.count) {
+    return DB_FINISHED;
+  }
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+stored_rows(relation_t *rel, tuple_id_t *rows)
+{
+  unsigned long blocks;
+
+  if(DB_ERROR(block_count(rel->tuple_storage, &blocks))) {
+    return DB_STORAGE_ERROR;
+  }
+  if(blocks == 0) {
+    *rows = 0;
+    return DB_OK;
+  }
+  if(DB_ERROR(read_block(rel, blocks - 1, 0))) {
+    return DB_STORAGE_ERROR;
+  }
+  *rows = block.first + block.count;
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* Decode rows of the loaded block into consecutive rows. */
+static db_result_t
+decode_rows(relation_t *rel, tuple_id_t tuple_id, unsigned rows,
+            unsigned char *rows_ptr)
+{
+  attribute_t *attr;
+  const unsigned char *descriptor;
+  const unsigned char *ptr;
+  const unsigned char *end;
+  unsigned offset;
+  unsigned first;
+  unsigned i;
+  uint32_t value;
+  uint32_t delta;
+  uint32_t code;
+  uint8_t encoding;
+
+  first = tuple_id - block.first;
+  descriptor = &block.data[BLOCK_HEADER];
+  ptr = &block.data[header_size(rel)];
+  end = &block.data[DB_SERIES_BLOCK_SIZE - 1];
+
+  for(attr = list_head(rel->attributes), offset = 0;
+      attr != NULL;
+      offset += attr->element_size, attr = attr->next) {
+    encoding = *descriptor;
+    descriptor += DESCRIPTOR_SIZE(attr->domain);
+
+    if(encoding == ENCODING_RAW) {
+      if(ptr + block.count * attr->element_size > end) {
+        return DB_STORAGE_ERROR;
+      }
+      for(i = 0; i < rows; i++) {
+        memcpy(rows_ptr + i * rel->row_length + offset,
+               ptr + (first + i) * attr->element_size, attr->element_size);
+      }
+      ptr += block.count * attr->element_size;
+      continue;
+    }
+
+    if(!IS_NUMERIC(attr->domain)) {
+      return DB_STORAGE_ERROR;
+    }
+
+    value = delta = 0;
+    for(i = 0; i < block.count; i++) {
+      ptr = get_varint(ptr, end, &code);
+      if(ptr == NULL) {
+        PRINTF("DB: Corrupt column %s in relation %s\n",
+               attr->name, rel->name);
+        return DB_STORAGE_ERROR;
+      }
+
+      if(i == 0) {
+        value = code;
+      } else {
+        code = unzigzag(code);
+        if(encoding == ENCODING_DOD && i > 1) {
+          code += delta;
+        }
+        delta = code;
+        value += delta;
+      }
+
+      if(i >= first && i < first + rows) {
+        put_value(rows_ptr + (i - first) * rel->row_length + offset,
+                  attr->domain, value);
+      }
+    }
+  }
+
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+column_add(struct column *column, uint32_t value, unsigned count)
+{
+  uint32_t delta;
+
+  if(count == 0) {
+    column->delta_length = column->dod_length = varint_length(value);
+    column->min = column->max = (long)value;
+  } else {
+    delta = value - column->last;
+    column->delta_length += varint_length(zigzag(delta));
+    column->dod_length +=
+      varint_length(zigzag(count == 1 ? delta : delta - column->delta));
+    column->delta = delta;
+    if((long)value < column->min) {
+      column->min = (long)value;
+    }
+    if((long)value > column->max) {
+      column->max = (long)value;
+    }
+  }
+  column->last = value;
+}
+/*---------------------------------------------------------------------------*/
+static void
+buffer_add(struct buffer *buffer, storage_row_t row)
+{
+  struct column *column;
+  unsigned offset;
+  int i;
+
+  for(i = 0, offset = 0; i < buffer->columns; i++) {
+    column = &buffer->column[i];
+    if(IS_NUMERIC(column->domain)) {
+      column_add(column, get_value(row + offset, column->domain),
+                 buffer->count);
+    }
+    offset += column->size;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+encoded_length(struct buffer *buffer, unsigned count)
+{
+  struct column *column;
+  unsigned length;
+  int i;
+
+  length = BLOCK_HEADER + 1;
+  for(i = 0; i < buffer->columns; i++) {
+    column = &buffer->column[i];
+    length += DESCRIPTOR_SIZE(column->domain);
+    if(!IS_NUMERIC(column->domain)) {
+      length += count * column->size;
+    } else if(column->dod_length < column->delta_length) {
+      length += column->dod_length;
+    } else {
+      length += column->delta_length;
+    }
+  }
+  return length;
+}
+/*---------------------------------------------------------------------------*/
+static void
+encode_block(struct buffer *buffer)
+{
+  struct column *column;
+  unsigned char *descriptor;
+  unsigned char *ptr;
+  unsigned char *row;
+  unsigned offset;
+  uint32_t value;
+  uint32_t delta;
+  uint32_t last_delta;
+  uint8_t encoding;
+  int i, j;
+
+  block.filename[0] = '\0';
+  memset(block.data, 0, sizeof(block.data));
+  put_u32(&block.data[BLOCK_FIRST_ROW], buffer->first);
+  block.data[BLOCK_ROW_COUNT] = buffer->count;
+
+  descriptor = &block.data[BLOCK_HEADER];
+  ptr = descriptor;
+  for(i = 0; i < buffer->columns; i++) {
+    ptr += DESCRIPTOR_SIZE(buffer->column[i].domain);
+  }
+
+  for(i = 0, offset = 0; i < buffer->columns; i++) {
+    column = &buffer->column[i];
+
+    if(!IS_NUMERIC(column->domain)) {
+      *descriptor++ = ENCODING_RAW;
+      for(j = 0, row = buffer->rows; j < buffer->count;
+          j++, row += buffer->row_length) {
+        memcpy(ptr, row + offset, column->size);
+        ptr += column->size;
+      }
+      offset += column->size;
+      continue;
+    }
+
+    encoding = column->dod_length < column->delta_length ?
+               ENCODING_DOD : ENCODING_DELTA;
+    descriptor[0] = encoding;
+    put_u32(&descriptor[1], (uint32_t)column->min);
+    put_u32(&descriptor[5], (uint32_t)column->max);
+    descriptor += 9;
+
+    value = last_delta = 0;
+    for(j = 0, row = buffer->rows; j < buffer->count;
+        j++, row += buffer->row_length) {
+      if(j == 0) {
+        value = get_value(row + offset, column->domain);
+        ptr = put_varint(ptr, value);
+        continue;
+      }
+      delta = get_value(row + offset, column->domain) - value;
+      value += delta;
+      ptr = put_varint(ptr, zigzag(encoding == ENCODING_DOD && j > 1 ?
+                                   delta - last_delta : delta));
+      last_delta = delta;
+    }
+    offset += column->size;
+  }
+
+  block.data[DB_SERIES_BLOCK_SIZE - 1] = BLOCK_MARK;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+buffer_init(struct buffer *buffer, relation_t *rel)
+{
+  attribute_t *attr;
+  struct column *column;
+  unsigned length;
+
+  if(rel->row_length == 0 || rel->row_length > sizeof(buffer->rows)) {
+    return DB_LIMIT_ERROR;
+  }
+
+  /* A block must be able to hold at least one row. */
+  length = BLOCK_HEADER + 1;
+  column = buffer->column;
+  for(attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+    column->domain = attr->domain;
+    column->size = attr->element_size;
+    length += DESCRIPTOR_SIZE(attr->domain) +
+      (IS_NUMERIC(attr->domain) ? MAX_VARINT_SIZE : attr->element_size);
+    column++;
+  }
+  if(length > DB_SERIES_BLOCK_SIZE) {
+    PRINTF("DB: The rows of %s do not fit in a block\n", rel->name);
+    return DB_LIMIT_ERROR;
+  }
+
+  if(DB_ERROR(stored_rows(rel, &buffer->first))) {
+    return DB_STORAGE_ERROR;
+  }
+
+  strcpy(buffer->filename, rel->tuple_filename);
+  buffer->columns = rel->attribute_count;
+  buffer->row_length = rel->row_length;
+  buffer->capacity = sizeof(buffer->rows) / rel->row_length;
+  if(buffer->capacity > MAX_ROWS) {
+    buffer->capacity = MAX_ROWS;
+  }
+  buffer->count = 0;
+
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+buffer_flush(struct buffer *buffer)
+{
+  int fd;
+  cfs_offset_t end;
+  unsigned padding;
+  db_result_t result;
+
+  if(buffer->count == 0) {
+    return DB_OK;
+  }
+
+  encode_block(buffer);
+
+  fd = cfs_open(buffer->filename, CFS_READ | CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    return DB_STORAGE_ERROR;
+  }
+
+  result = DB_STORAGE_ERROR;
+  end = cfs_seek(fd, 0, CFS_SEEK_END);
+  if(end != (cfs_offset_t)-1) {
+    /* Align the block after an incompletely written one. The
+       contents of the padding do not matter. */
+    padding = (DB_SERIES_BLOCK_SIZE - end % DB_SERIES_BLOCK_SIZE) %
+              DB_SERIES_BLOCK_SIZE;
+    if(padding == 0 ||
+       cfs_write(fd, block.data, padding) == (int)padding) {
+      if(cfs_write(fd, block.data, DB_SERIES_BLOCK_SIZE) ==
+         DB_SERIES_BLOCK_SIZE) {
+        result = DB_OK;
+      }
+    }
+  }
+  cfs_close(fd);
+
+  if(DB_ERROR(result)) {
+    PRINTF("DB: Failed to write a block to %s\n", buffer->filename);
+    return result;
+  }
+
+  PRINTF("DB: Wrote %u rows to %s\n", buffer->count, buffer->filename);
+
+  buffer->first += buffer->count;
+  buffer->count = 0;
+
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* Take a free buffer, or write out the rows of the least recently
+   used one. */
+static struct buffer *
+buffer_allocate(void)
+{
+  struct buffer *buffer;
+  int i;
+
+  buffer = &buffers[0];
+  for(i = 0; i < DB_SERIES_BUFFERS; i++) {
+    if(buffers[i].filename[0] == '\0') {
+      return &buffers[i];
+    }
+    if((uint16_t)(use_count - buffers[i].last_use) >
+       (uint16_t)(use_count - buffer->last_use)) {
+      buffer = &buffers[i];
+    }
+  }
+
+  if(DB_ERROR(buffer_flush(buffer))) {
+    return NULL;
+  }
+  buffer->filename[0] = '\0';
+  return buffer;
+}
+/*---------------------------------------------------------------------------*/
+db_result_t
+series_flush(void)
+{
+  db_result_t result;
+  int i;
+
+  result = DB_OK;
+  for(i = 0; i < DB_SERIES_BUFFERS; i++) {
+    if(buffers[i].filename[0] != '\0' &&
+       DB_ERROR(buffer_flush(&buffers[i]))) {
+      result = DB_STORAGE_ERROR;
+    }
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+db_result_t
+series_put_row(relation_t *rel, storage_row_t row)
+{
+  struct column columns[DB_MAX_ATTRIBUTES_PER_RELATION];
+  struct buffer *buffer;
+  db_result_t result;
+
+  buffer = buffer_find(rel);
+  if(buffer == NULL) {
+    buffer = buffer_allocate();
+    if(buffer == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+    result = buffer_init(buffer, rel);
+    if(DB_ERROR(result)) {
+      return result;
+    }
+  }
+  buffer->last_use = ++use_count;
+
+  memcpy(columns, buffer->column, sizeof(columns));
+  buffer_add(buffer, row);
+  if(encoded_length(buffer, buffer->count + 1) > DB_SERIES_BLOCK_SIZE) {
+    /* Write the rows that fit, and start a new block with this row. */
+    memcpy(buffer->column, columns, sizeof(columns));
+    if(DB_ERROR(buffer_flush(buffer))) {
+      return DB_STORAGE_ERROR;
+    }
+    buffer_add(buffer, row);
+  }
+
+  memcpy(&buffer->rows[buffer->count * buffer->row_length], row,
+         buffer->row_length);
+  buffer->count++;
+
+  if(buffer->count == buffer->capacity) {
+    return buffer_flush(buffer);
+  }
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+db_result_t
+series_get_row(relation_t *rel, tuple_id_t tuple_id, storage_row_t row)
+{
+  struct buffer *buffer;
+  db_result_t result;
+
+  buffer = buffer_find(rel);
+  if(buffer != NULL && tuple_id >= buffer->first) {
+    if(tuple_id - buffer->first >= buffer->count) {
+      return DB_FINISHED;
+    }
+    memcpy(row, &buffer->rows[(tuple_id - buffer->first) * buffer->row_length],
+           buffer->row_length);
+    return DB_OK;
+  }
+
+  result = load_block(rel, tuple_id, 1);
+  if(result != DB_OK) {
+    return result;
+  }
+  return decode_rows(rel, tuple_id, 1, row);
+}
+/*---------------------------------------------------------------------------*/
+db_result_t
+series_get_row_amount(relation_t *rel, tuple_id_t *amount)
+{
+  struct buffer *buffer;
+
+  buffer = buffer_find(rel);
+  if(buffer != NULL) {
+    *amount = buffer->first + buffer->count;
+    return DB_OK;
+  }
+  return stored_rows(rel, amount);
+}
+/*---------------------------------------------------------------------------*/
+void
+series_drop(relation_t *rel)
+{
+  struct buffer *buffer;
+
+  buffer = buffer_find(rel);
+  if(buffer != NULL) {
+    buffer->filename[0] = '\0';
+    buffer->count = 0;
+  }
+  if(strcmp(block.filename, rel->tuple_filename) == 0) {
+    block.filename[0] = '\0';
+  }
+}
+/*---------------------------------------------------------------------------*/
+db_result_t
+series_scan_fill(storage_scan_t *scan, tuple_id_t tuple_id)
+{
+  relation_t *rel;
+  struct buffer *buffer;
+  unsigned rows;
+  unsigned available;
+  db_result_t result;
+
+  rel = scan->rel;
+  rows = scan->block_size / rel->row_length;
+  if(rows == 0) {
+    return DB_LIMIT_ERROR;
+  }
+
+  scan->count = 0;
+  buffer = buffer_find(rel);
+  if(buffer != NULL && tuple_id >= buffer->first) {
+    if(tuple_id - buffer->first >= buffer->count) {
+      return DB_FINISHED;
+    }
+    available = buffer->first + buffer->count - tuple_id;
+    if(rows > available) {
+      rows = available;
+    }
+    memcpy(scan->block,
+           &buffer->rows[(tuple_id - buffer->first) * buffer->row_length],
+           rows * buffer->row_length);
+  } else {
+    result = load_block(rel, tuple_id, 1);
+    if(result != DB_OK) {
+      return result;
+    }
+    available = block.first + block.count - tuple_id;
+    if(rows > available) {
+      rows = available;
+    }
+    if(DB_ERROR(decode_rows(rel, tuple_id, rows, scan->block))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  scan->first = tuple_id;
+  scan->count = rows;
+
+  return DB_OK;
+}
+/*---------------------------------------------------------------------------*/
+tuple_id_t
+series_scan_skip(storage_scan_t *scan, tuple_id_t tuple_id)
+{
+  relation_t *rel;
+  struct buffer *buffer;
+  attribute_t *attr;
+  const unsigned char *descriptor;
+  long min;
+  long max;
+
+  rel = scan->rel;
+  buffer = buffer_find(rel);
+
+  for(;;) {
+    if(buffer != NULL && tuple_id >= buffer->first) {
+      return tuple_id;
+    }
+    if(load_block(rel, tuple_id, 0) != DB_OK) {
+      return tuple_id;
+    }
+
+    descriptor = &block.data[BLOCK_HEADER];
+    for(attr = list_head(rel->attributes);
+        attr != NULL && attr != scan->range_attr;
+        attr = attr->next) {
+      descriptor += DESCRIPTOR_SIZE(attr->domain);
+    }
+    if(attr == NULL || descriptor[0] == ENCODING_RAW) {
+      return tuple_id;
+    }
+
+    min = (long)get_u32(&descriptor[1]);
+    max = (long)get_u32(&descriptor[5]);
+    if(max >= scan->range_min && min <= scan->range_max) {
+      return tuple_id;
+    }
+
+    PRINTF("DB: Skipping %u rows from tuple %lu\n",
+           block.count, (unsigned long)tuple_id);
+    tuple_id = block.first + block.count;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#endif /* DB_FEATURE_SERIES */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	The storage format of series relations, which is used by the
+ *	CFS storage backend.
+ */
+
+#ifndef STORAGE_SERIES_H
+#define STORAGE_SERIES_H
+
+#include "storage.h"
+
+/* The prefix of the tuple file names of series relations. The format
+   of a relation is recorded in the file name, so that the relation
+   catalog keeps its format. */
+#define SERIES_FILE_PREFIX	"ts"
+
+db_result_t series_put_row(relation_t *, storage_row_t);
+db_result_t series_get_row(relation_t *, tuple_id_t, storage_row_t);
+db_result_t series_get_row_amount(relation_t *, tuple_id_t *);
+db_result_t series_flush(void);
+void series_drop(relation_t *);
+
+db_result_t series_scan_fill(storage_scan_t *, tuple_id_t);
+tuple_id_t series_scan_skip(storage_scan_t *, tuple_id_t);
+
+#endif /* STORAGE_SERIES_H */
@@ -50,6 +50,26 @@
 
 typedef unsigned char * storage_row_t;
 
+/*
+ * A scan cursor reads the rows of a relation in blocks of several
+ * rows, and keeps the row count of the relation for the duration
+ * of a query.
+ */
+struct storage_scan {
+  relation_t *rel;
+  unsigned char *block;
+  unsigned block_size;
+  tuple_id_t nrows;
+  tuple_id_t first;
+  unsigned count;
+  /* Scans of series relations skip the blocks in which the values of
+     this attribute are outside of the range. */
+  attribute_t *range_attr;
+  long range_min;
+  long range_max;
+};
+typedef struct storage_scan storage_scan_t;
+
 char *storage_generate_file(char *, unsigned long);
 
 db_result_t storage_load(relation_t *);
@@ -68,8 +88,19 @@ db_result_t storage_get_row(relation_t *, tuple_id_t *, storage_row_t);
 db_result_t storage_put_row(relation_t *, storage_row_t);
 db_result_t storage_get_row_amount(relation_t *, tuple_id_t *);
 
+void storage_scan_init(storage_scan_t *, relation_t *, unsigned char *,
+                       unsigned);
+db_result_t storage_scan_get_row(storage_scan_t *, tuple_id_t,
+                                 storage_row_t *);
+unsigned storage_scan_buffered(storage_scan_t *, tuple_id_t);
+void storage_scan_set_range(storage_scan_t *, attribute_t *, long, long);
+tuple_id_t storage_scan_skip(storage_scan_t *, tuple_id_t);
+
+db_result_t storage_flush(void);
+
 db_storage_id_t storage_open(const char *);
 void storage_close(db_storage_id_t);
+void storage_remove(const char *);
 db_result_t storage_read(db_storage_id_t, void *, unsigned long, unsigned);
 db_result_t storage_write(db_storage_id_t, void *, unsigned long, unsigned);
 
@@ -55,6 +55,7 @@
 #endif
 
 #include "dev/leds.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -146,6 +147,102 @@ read_page(struct deluge_object *obj, unsigned pagenum, unsigned char *buf)
   return cfs_read(obj->cfs_fd, (char *)buf, S_PAGE);
 }
 
+static void
+index_name(struct deluge_object *obj, char *name, int size)
+{
+  strncpy(name, obj->filename, size - sizeof(DELUGE_INDEX_SUFFIX));
+  name[size - sizeof(DELUGE_INDEX_SUFFIX)] = '\0';
+  strcat(name, DELUGE_INDEX_SUFFIX);
+}
+
+/* Write the index record of a page, or the whole index if pagenum is
+   negative. */
+static void
+save_index(struct deluge_object *obj, int pagenum)
+{
+  char name[32];
+  struct deluge_index_header header;
+  struct deluge_index_record record;
+  int fd, i, first, last;
+  cfs_offset_t offset;
+
+  index_name(obj, name, sizeof(name));
+  /* Without CFS_APPEND, some file systems truncate the file. */
+  fd = cfs_open(name, CFS_READ | CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    return;
+  }
+
+  if(pagenum < 0) {
+    first = 0;
+    last = OBJECT_PAGE_COUNT(*obj) - 1;
+    offset = 0;
+  } else {
+    first = last = pagenum;
+    offset = sizeof(header) + pagenum * sizeof(record);
+  }
+  if(cfs_seek(fd, offset, CFS_SEEK_SET) != offset) {
+    cfs_close(fd);
+    return;
+  }
+
+  if(pagenum < 0) {
+    header.format = DELUGE_INDEX_FORMAT;
+    header.version = obj->version;
+    header.size = obj->size;
+    cfs_write(fd, &header, sizeof(header));
+  }
+
+  for(i = first; i <= last; i++) {
+    record.version = obj->pages[i].version;
+    record.flags = obj->pages[i].flags;
+    record.crc = obj->pages[i].crc;
+    cfs_write(fd, &record, sizeof(record));
+  }
+  cfs_close(fd);
+}
+
+/* Restore the page state from the index. Returns 0 if the index is
+   missing or does not describe the current object. */
+static int
+load_index(struct deluge_object *obj)
+{
+  char name[32];
+  struct deluge_index_header header;
+  struct deluge_index_record record;
+  struct deluge_page *page;
+  int fd, i;
+
+  index_name(obj, name, sizeof(name));
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+
+  if(cfs_read(fd, &header, sizeof(header)) != sizeof(header) ||
+     header.format != DELUGE_INDEX_FORMAT ||
+     header.version != obj->version || header.size != obj->size) {
+    cfs_close(fd);
+    return 0;
+  }
+
+  for(i = 0; i < OBJECT_PAGE_COUNT(*obj); i++) {
+    if(cfs_read(fd, &record, sizeof(record)) != sizeof(record)) {
+      cfs_close(fd);
+      return 0;
+    }
+    page = &obj->pages[i];
+    page->version = record.version;
+    page->flags = record.flags;
+    page->crc = record.crc;
+    page->packet_set = (page->flags & PAGE_COMPLETE) ? ALL_PACKETS : 0;
+    page->last_request = 0;
+    page->last_data = 0;
+  }
+  cfs_close(fd);
+  return 1;
+}
+
 static void
 init_page(struct deluge_object *obj, int pagenum, int have)
 {
@@ -167,6 +264,7 @@ init_page(struct deluge_object *obj, int pagenum, int have)
   } else {
     page->version = 0;
     page->packet_set = 0;
+    page->crc = 0;
   }
 }
 
@@ -190,7 +288,6 @@ file_size(const char *file)
 static int
 init_object(struct deluge_object *obj, char *filename, unsigned version)
 {
-  static struct deluge_page *page;
   int i;
 
   obj->cfs_fd = cfs_open(filename, CFS_READ | CFS_WRITE);
@@ -204,7 +301,11 @@ init_object(struct deluge_object *obj, char *filename, unsigned version)
   obj->version = obj->update_version = version;
   obj->current_rx_page = 0;
   obj->nrequests = 0;
-  obj->tx_set = 0;
+  obj->rx_pkt_size = 0;
+  obj->tx_pkt_size = 0;
+  obj->summary_highest = 0;
+  obj->summary_pkt_size = S_PKT;
+  memset(obj->tx_set, 0, sizeof(obj->tx_set));
 
   obj->pages = malloc(OBJECT_PAGE_COUNT(*obj) * sizeof(*obj->pages));
   if(obj->pages == NULL) {
@@ -212,9 +313,14 @@ init_object(struct deluge_object *obj, char *filename, unsigned version)
     return -1; 
   }
 
-  for(i = 0; i < OBJECT_PAGE_COUNT(current_object); i++) {
-    page = &current_object.pages[i];
-    init_page(&current_object, i, 1);
+  /* Reading every page to compute its CRC is slow, so this is only
+     done when there is no valid index from an earlier run. */
+  if(!load_index(obj)) {
+    PRINTF("Rebuilding the page index of %s\n", filename);
+    for(i = 0; i < OBJECT_PAGE_COUNT(*obj); i++) {
+      init_page(obj, i, 1);
+    }
+    save_index(obj, -1);
   }
 
   memset(obj->current_page, 0, sizeof(obj->current_page));
@@ -236,22 +342,72 @@ highest_available_page(struct deluge_object *obj)
   return i;
 }
 
+/* The largest packet size that does not exceed max and that divides
+   the page into whole packets. */
+static unsigned
+packet_size(unsigned max)
+{
+  unsigned size;
+
+  size = max > S_PKT ? S_PKT : max;
+  while(size > S_PKT_MIN && S_PAGE % size != 0) {
+    size--;
+  }
+  return size < S_PKT_MIN ? S_PKT_MIN : size;
+}
+
 static void
 send_request(void *arg)
 {
   struct deluge_object *obj;
   struct deluge_msg_request request;
+  struct deluge_page *page;
+  unsigned pkt_size;
+  int i;
 
   obj = (struct deluge_object *)arg;
 
+  /* Partially received pages have to be received again if the packet
+     size changes. */
+  pkt_size = packet_size(obj->summary_pkt_size);
+  if(pkt_size != obj->rx_pkt_size) {
+    for(i = 0; i < DELUGE_PIPELINE &&
+          obj->current_rx_page + i < OBJECT_PAGE_COUNT(*obj); i++) {
+      page = &obj->pages[obj->current_rx_page + i];
+      if(!(page->flags & PAGE_COMPLETE)) {
+        page->packet_set = 0;
+      }
+    }
+    obj->rx_pkt_size = pkt_size;
+  }
+
+  memset(&request, 0, sizeof(request));
   request.cmd = DELUGE_CMD_REQUEST;
   request.pagenum = obj->current_rx_page;
   request.version = obj->pages[request.pagenum].version;
-  request.request_set = ~obj->pages[obj->current_rx_page].packet_set;
   request.object_id = obj->object_id;
+  request.pkt_size = pkt_size;
 
-  PRINTF("Sending request for page %d, version %u, request_set %u\n", 
-	request.pagenum, request.version, request.request_set);
+  /* Request the window of pages that the neighbor has, with a bitmap
+     of the packets that are still missing from each page. */
+  for(i = 0; i < DELUGE_PIPELINE; i++) {
+    if(request.pagenum + i >= obj->summary_highest ||
+       request.pagenum + i >= OBJECT_PAGE_COUNT(*obj)) {
+      break;
+    }
+    page = &obj->pages[request.pagenum + i];
+    if(page->version != request.version) {
+      break;
+    }
+    if(!(page->flags & PAGE_COMPLETE)) {
+      request.request_set[i] = ~page->packet_set & PACKET_MASK(pkt_size);
+    }
+  }
+  request.npages = i > 0 ? i : 1;
+
+  PRINTF("Sending request for pages %d-%d, version %u, packet size %u\n", 
+	request.pagenum, request.pagenum + request.npages - 1,
+	request.version, pkt_size);
   packetbuf_copyfrom(&request, sizeof(request));
   unicast_send(&deluge_uc, &obj->summary_from);
 
@@ -279,6 +435,7 @@ advertise_summary(struct deluge_object *obj)
   summary.version = obj->update_version;
   summary.highest_available = highest_available_page(obj);
   summary.object_id = obj->object_id;
+  summary.max_pkt = S_PKT;
 
   PRINTF("Advertising summary for object id %u: version=%u, available=%u\n",
 	(unsigned)obj->object_id, summary.version, summary.highest_available);
@@ -333,6 +490,8 @@ handle_summary(struct deluge_msg_summary *msg, const linkaddr_t *sender)
     }
 
     linkaddr_copy(&current_object.summary_from, sender);
+    current_object.summary_highest = msg->highest_available;
+    current_object.summary_pkt_size = msg->max_pkt;
     transition(DELUGE_STATE_RX);
 
     if(ctimer_expired(&rx_timer)) {
@@ -344,60 +503,91 @@ handle_summary(struct deluge_msg_summary *msg, const linkaddr_t *sender)
 }
 
 static void
-send_page(struct deluge_object *obj, unsigned pagenum)
+send_page(struct deluge_object *obj, unsigned pagenum, uint32_t tx_set)
 {
   unsigned char buf[S_PAGE];
   struct deluge_msg_packet pkt;
   unsigned char *cp;
+  unsigned pkt_size;
+  int len;
+  uint16_t crc;
 
+  pkt_size = obj->tx_pkt_size;
   pkt.cmd = DELUGE_CMD_PACKET;
   pkt.pagenum = pagenum;
   pkt.version = obj->pages[pagenum].version;
   pkt.packetnum = 0;
   pkt.object_id = obj->object_id;
   pkt.crc = 0;
+  pkt.pkt_size = pkt_size;
+
+  len = read_page(obj, pagenum, buf);
+  if(len < 0) {
+    len = 0;
+  }
+  memset(&buf[len], 0, S_PAGE - len);
 
-  read_page(obj, pagenum, buf);
+  /* The file may have been changed since the index was written, so the
+     page CRC is taken from the data that is sent. */
+  crc = crc16_data(buf, S_PAGE, 0);
+  if(crc != obj->pages[pagenum].crc) {
+    PRINTF("Page %u changed since the index was written\n", pagenum);
+    obj->pages[pagenum].crc = crc;
+    save_index(obj, pagenum);
+  }
+  pkt.page_crc = crc;
 
   /* Divide the page into packets and send them one at a time. */
-  for(cp = buf; cp + S_PKT <= (unsigned char *)&buf[S_PAGE]; cp += S_PKT) {
-    if(obj->tx_set & (1 << pkt.packetnum)) {
-      pkt.crc = crc16_data(cp, S_PKT, 0);
-      memcpy(pkt.payload, cp, S_PKT);
-      packetbuf_copyfrom(&pkt, sizeof(pkt));
+  for(cp = buf; cp + pkt_size <= (unsigned char *)&buf[S_PAGE]; cp += pkt_size) {
+    if(tx_set & (1UL << pkt.packetnum)) {
+      pkt.crc = crc16_data(cp, pkt_size, 0);
+      memcpy(pkt.payload, cp, pkt_size);
+      packetbuf_copyfrom(&pkt, offsetof(struct deluge_msg_packet, payload) + pkt_size);
       broadcast_send(&deluge_broadcast);
     }
     pkt.packetnum++;
   }
-  obj->tx_set = 0;
 }
 
 static void
 tx_callback(void *arg)
 {
   struct deluge_object *obj;
+  int i;
 
   obj = (struct deluge_object *)arg;
-  if(obj->current_tx_page >= 0 && obj->tx_set) {
-    send_page(obj, obj->current_tx_page);
-    /* Deluge T.2. */
-    if(obj->tx_set) {
-      packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
-			 PACKETBUF_ATTR_PACKET_TYPE_STREAM);
-      ctimer_reset(&tx_timer);
-    } else {
-      packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
-			 PACKETBUF_ATTR_PACKET_TYPE_STREAM_END);
-      obj->current_tx_page = -1;
-      transition(DELUGE_STATE_MAINTAIN);
+  if(obj->current_tx_page < 0) {
+    return;
+  }
+
+  /* Send the first page of the window that has requested packets. */
+  for(i = 0; i < DELUGE_PIPELINE; i++) {
+    if(obj->tx_set[i] != 0) {
+      send_page(obj, obj->current_tx_page + i, obj->tx_set[i]);
+      obj->tx_set[i] = 0;
+      break;
     }
   }
+
+  for(i = 0; i < DELUGE_PIPELINE && obj->tx_set[i] == 0; i++);
+  if(i < DELUGE_PIPELINE) {
+    /* Deluge T.2. Keep the lower layers in streaming mode until the
+       whole window has been sent. */
+    packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
+		       PACKETBUF_ATTR_PACKET_TYPE_STREAM);
+    ctimer_set(&tx_timer, T_TX_PAGE, tx_callback, obj);
+  } else {
+    packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
+		       PACKETBUF_ATTR_PACKET_TYPE_STREAM_END);
+    obj->current_tx_page = -1;
+    transition(DELUGE_STATE_MAINTAIN);
+  }
 }
 
 static void
 handle_request(struct deluge_msg_request *msg)
 {
-  int highest_available;
+  int highest_available, i, npages;
 
   if(msg->pagenum >= OBJECT_PAGE_COUNT(current_object)) {
     return;
@@ -407,19 +597,35 @@ handle_request(struct deluge_msg_request *msg)
     neighbor_inconsistency = 1;
   }
 
+  if(msg->pkt_size > S_PKT || msg->pkt_size < S_PKT_MIN ||
+     S_PAGE % msg->pkt_size != 0) {
+    return;
+  }
+
   highest_available = highest_available_page(&current_object);
 
   /* Deluge M.6 */
   if(msg->version == current_object.version &&
-      msg->pagenum <= highest_available) {
-    current_object.pages[msg->pagenum].last_request = clock_time();
+      msg->pagenum < highest_available) {
+    npages = msg->npages;
+    if(npages > DELUGE_PIPELINE) {
+      npages = DELUGE_PIPELINE;
+    }
+    if(msg->pagenum + npages > highest_available) {
+      npages = highest_available - msg->pagenum;
+    }
 
     /* Deluge T.1 */
-    if(msg->pagenum == current_object.current_tx_page) {
-      current_object.tx_set |= msg->request_set;
-    } else {
+    if(msg->pagenum != current_object.current_tx_page ||
+       msg->pkt_size != current_object.tx_pkt_size) {
       current_object.current_tx_page = msg->pagenum;
-      current_object.tx_set = msg->request_set;
+      current_object.tx_pkt_size = msg->pkt_size;
+      memset(current_object.tx_set, 0, sizeof(current_object.tx_set));
+    }
+    for(i = 0; i < npages; i++) {
+      current_object.pages[msg->pagenum + i].last_request = clock_time();
+      current_object.tx_set[i] |= msg->request_set[i] &
+        PACKET_MASK(msg->pkt_size);
     }
 
     transition(DELUGE_STATE_TX);
@@ -428,19 +634,51 @@ handle_request(struct deluge_msg_request *msg)
 }
 
 static void
-handle_packet(struct deluge_msg_packet *msg)
+complete_page(struct deluge_page *page, unsigned pagenum, uint8_t version,
+              unsigned char *data, uint16_t page_crc)
+{
+  uint16_t crc;
+
+  crc = crc16_data(data, S_PAGE, 0);
+  if(crc != page_crc) {
+    /* The packets did not add up to the page that the sender has. */
+    PRINTF("page %u crc: %hu, calculated crc: %hu\n", pagenum, page_crc, crc);
+    page->packet_set = 0;
+    return;
+  }
+
+  write_page(&current_object, pagenum, data);
+  page->version = version;
+  page->crc = crc;
+  page->flags = PAGE_COMPLETE;
+  save_index(&current_object, pagenum);
+  PRINTF("Page %u completed\n", pagenum);
+}
+
+static void
+handle_packet(struct deluge_msg_packet *msg, int len)
 {
   struct deluge_page *page;
   uint16_t crc;
   struct deluge_msg_packet packet;
+  unsigned char *data;
+  unsigned slot;
 
-  memcpy(&packet, msg, sizeof(packet));
+  memcpy(&packet, msg, len);
 
   PRINTF("Incoming packet for object id %u, version %u, page %u, packet num %u!\n",
 	(unsigned)packet.object_id, (unsigned)packet.version,
 	(unsigned)packet.pagenum, (unsigned)packet.packetnum);
 
-  if(packet.pagenum != current_object.current_rx_page) {
+  if(packet.pagenum < current_object.current_rx_page ||
+     packet.pagenum >= current_object.current_rx_page + DELUGE_PIPELINE ||
+     packet.pagenum >= OBJECT_PAGE_COUNT(current_object)) {
+    return;
+  }
+
+  if(packet.pkt_size != current_object.rx_pkt_size ||
+     len < offsetof(struct deluge_msg_packet, payload) + packet.pkt_size ||
+     (unsigned)(packet.packetnum + 1) * packet.pkt_size > S_PAGE) {
     return;
   }
 
@@ -450,44 +688,56 @@ handle_packet(struct deluge_msg_packet *msg)
 
   page = &current_object.pages[packet.pagenum];
   if(packet.version == page->version && !(page->flags & PAGE_COMPLETE)) {
-    memcpy(&current_object.current_page[S_PKT * packet.packetnum],
-	packet.payload, S_PKT);
-
-    crc = crc16_data(packet.payload, S_PKT, 0);
+    crc = crc16_data(packet.payload, packet.pkt_size, 0);
     if(packet.crc != crc) {
       PRINTF("packet crc: %hu, calculated crc: %hu\n", packet.crc, crc);
       return;
     }
 
-    page->last_data = clock_time();
-    page->packet_set |= (1 << packet.packetnum);
+    /* Pages in the window map onto the receive buffers by their
+       number. */
+    slot = packet.pagenum % DELUGE_PIPELINE;
+    data = current_object.current_page[slot];
+    memcpy(&data[packet.pkt_size * packet.packetnum],
+	packet.payload, packet.pkt_size);
 
-    if(page->packet_set == ALL_PACKETS) {
-      /* This is the last packet of the requested page; stop streaming. */
-      packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
-			 PACKETBUF_ATTR_PACKET_TYPE_STREAM_END);
+    page->last_data = clock_time();
+    page->packet_set |= (1UL << packet.packetnum);
 
-      write_page(&current_object, packet.pagenum, current_object.current_page);
-      page->version = packet.version;
-      page->flags = PAGE_COMPLETE;
-      PRINTF("Page %u completed\n", packet.pagenum);
+    if(page->packet_set == PACKET_MASK(packet.pkt_size)) {
+      complete_page(page, packet.pagenum, packet.version, data,
+                    packet.page_crc);
 
-      current_object.current_rx_page++;
+      /* Move the window past the pages that are complete. */
+      while(current_object.current_rx_page < OBJECT_PAGE_COUNT(current_object) &&
+            (current_object.pages[current_object.current_rx_page].flags & PAGE_COMPLETE)) {
+        current_object.current_rx_page++;
+      }
 
-      if(packet.pagenum == OBJECT_PAGE_COUNT(current_object) - 1) {
+      if(current_object.current_rx_page == OBJECT_PAGE_COUNT(current_object)) {
+	/* This is the last packet of the object; stop streaming. */
+	packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
+			   PACKETBUF_ATTR_PACKET_TYPE_STREAM_END);
 	current_object.version = current_object.update_version;
+	save_index(&current_object, -1);
 	leds_on(LEDS_RED);
 	PRINTF("Update completed for object %u, version %u\n", 
 	       (unsigned)current_object.object_id, packet.version);
-      } else if(current_object.current_rx_page < OBJECT_PAGE_COUNT(current_object)) {
+	/* Deluge R.3 */
+	transition(DELUGE_STATE_MAINTAIN);
+      } else if(current_object.current_rx_page > packet.pagenum) {
+	/* The lowest page of the window is done: request the next
+	   window. */
+	packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
+			   PACKETBUF_ATTR_PACKET_TYPE_STREAM_END);
         if(ctimer_expired(&rx_timer)) {
 	  ctimer_set(&rx_timer,
 		CONST_OMEGA * ESTIMATED_TX_TIME + (random_rand() % T_R),
 		send_request, &current_object);
 	}
+	/* Deluge R.3 */
+	transition(DELUGE_STATE_MAINTAIN);
       }
-      /* Deluge R.3 */
-      transition(DELUGE_STATE_MAINTAIN);
     } else {
       /* More packets to come. Put lower layers in streaming mode. */
       packetbuf_set_attr(PACKETBUF_ATTR_PACKET_TYPE,
@@ -537,7 +787,7 @@ handle_profile(struct deluge_msg_profile *msg)
 	msg->version, msg->npages);
 
   leds_off(LEDS_RED);
-  current_object.tx_set = 0;
+  memset(current_object.tx_set, 0, sizeof(current_object.tx_set));
 
   npages = OBJECT_PAGE_COUNT(*obj);
   obj->size = msg->npages * S_PAGE;
@@ -566,10 +816,13 @@ handle_profile(struct deluge_msg_profile *msg)
 
   for(; i < msg->npages; i++) {
     init_page(obj, i, 0);
+    obj->pages[i].version = msg->version_vector[i];
   }
 
   obj->current_rx_page = highest_available_page(obj);
   obj->update_version = msg->version;
+  obj->rx_pkt_size = 0;
+  save_index(obj, -1);
 
   transition(DELUGE_STATE_RX);
 
@@ -600,8 +853,9 @@ command_dispatcher(const linkaddr_t *sender)
       handle_request((struct deluge_msg_request *)msg);
     break;
   case DELUGE_CMD_PACKET:
-    if(len >= sizeof(struct deluge_msg_packet))
-      handle_packet((struct deluge_msg_packet *)msg);
+    if(len >= offsetof(struct deluge_msg_packet, payload) &&
+       len <= sizeof(struct deluge_msg_packet))
+      handle_packet((struct deluge_msg_packet *)msg, len);
     break;
   case DELUGE_CMD_PROFILE:
     profile = (struct deluge_msg_profile *)msg;
@@ -60,9 +60,41 @@ PROCESS_NAME(deluge_process);
 /* All pages up to, and including, this page are complete. */
 #define PAGE_AVAILABLE	1
 
+/* The largest packet payload that this node sends or receives. The
+   payload size used for a page transfer is negotiated as the largest
+   size that both neighbors support and that divides the page size. */
+#ifdef DELUGE_CONF_PACKET_SIZE
+#define S_PKT		DELUGE_CONF_PACKET_SIZE
+#else
 #define S_PKT		64		/* Deluge packet size. */
-#define N_PKT		4		/* Packets per page. */
-#define S_PAGE		(S_PKT * N_PKT)	/* Fixed page size. */
+#endif
+
+#ifdef DELUGE_CONF_PAGE_SIZE
+#define S_PAGE		DELUGE_CONF_PAGE_SIZE
+#else
+#define S_PAGE		256		/* Fixed page size. */
+#endif
+
+#define N_PKT		(S_PAGE / S_PKT)	/* Packets per page. */
+
+/* The smallest packet payload, limited by the width of the packet
+   bitmaps. */
+#define S_PKT_MIN	(S_PAGE / 32)
+
+#if S_PKT < S_PKT_MIN || S_PAGE % S_PKT != 0
+#error DELUGE_CONF_PACKET_SIZE must divide the page size into at most 32 packets
+#endif
+
+/* The number of consecutive pages that can be requested and received
+   at the same time. Each page in the window needs an S_PAGE buffer. */
+#ifdef DELUGE_CONF_PIPELINE
+#define DELUGE_PIPELINE	DELUGE_CONF_PIPELINE
+#else
+#define DELUGE_PIPELINE	2
+#endif
+
+/* The time between the transmissions of two pages in a window. */
+#define T_TX_PAGE	(CLOCK_SECOND / 8)
 
 /* Bounds for the round time in seconds. */
 #define T_LOW		2
@@ -77,7 +109,16 @@ PROCESS_NAME(deluge_process);
 /* The number of pages in this object. */
 #define OBJECT_PAGE_COUNT(obj)	(((obj).size + (S_PAGE - 1)) / S_PAGE)
 
-#define ALL_PACKETS		((1 << N_PKT) - 1)
+#define ALL_PACKETS		PACKET_MASK(S_PKT)
+/* A bitmap with one bit for each packet of a page. */
+#define PACKET_MASK(pkt_size)	(S_PAGE / (pkt_size) >= 32 ?		\
+				 0xffffffffUL :				\
+				 (1UL << (S_PAGE / (pkt_size))) - 1)
+
+/* The per-page state is persisted in a file with this suffix, so that
+   the pages need not be read back at startup. */
+#define DELUGE_INDEX_SUFFIX	".di"
+#define DELUGE_INDEX_FORMAT	1
 
 #define DELUGE_CMD_SUMMARY	1
 #define DELUGE_CMD_REQUEST	2
@@ -101,14 +142,18 @@ struct deluge_msg_summary {
   uint8_t version;
   uint8_t highest_available;
   deluge_object_id_t object_id;
+  uint8_t max_pkt;
 };
 
 struct deluge_msg_request {
   uint8_t cmd;
   uint8_t version;
   uint8_t pagenum;
-  uint8_t request_set;
+  uint8_t npages;
+  /* Selective NACK bitmaps, one for each page from pagenum on. */
+  uint32_t request_set[DELUGE_PIPELINE];
   deluge_object_id_t object_id;
+  uint8_t pkt_size;
 };
 
 struct deluge_msg_packet {
@@ -117,7 +162,9 @@ struct deluge_msg_packet {
   uint8_t pagenum;
   uint8_t packetnum;
   uint16_t crc;
+  uint16_t page_crc;
   deluge_object_id_t object_id;
+  uint8_t pkt_size;
   unsigned char payload[S_PKT];
 };
 
@@ -139,8 +186,12 @@ struct deluge_object {
   uint8_t current_rx_page;
   int8_t current_tx_page;
   uint8_t nrequests;
-  uint8_t current_page[S_PAGE];
-  uint8_t tx_set;
+  uint8_t rx_pkt_size;
+  uint8_t tx_pkt_size;
+  uint8_t summary_highest;
+  uint8_t summary_pkt_size;
+  uint8_t current_page[DELUGE_PIPELINE][S_PAGE];
+  uint32_t tx_set[DELUGE_PIPELINE];
   int cfs_fd;
   linkaddr_t summary_from;
 };
@@ -154,6 +205,19 @@ struct deluge_page {
   uint8_t version;
 };
 
+/* The persisted per-page state. */
+struct deluge_index_header {
+  uint8_t format;
+  uint8_t version;
+  uint16_t size;
+};
+
+struct deluge_index_record {
+  uint8_t version;
+  uint8_t flags;
+  uint16_t crc;
+};
+
 int deluge_disseminate(char *file, unsigned version);
 
 #endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Batching of sensor samples into compact frames
+ */
+
+#include "sample-batch.h"
+
+#include <string.h>
+
+/* A zig-zag encoded 16-bit value takes at most three varint bytes. */
+#define MAX_FIELD_LEN 3
+
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_varint(uint8_t *p, int16_t value)
+{
+  uint16_t v;
+
+  /* Zig-zag encoding maps small negative values to small codes. */
+  v = ((uint16_t)value << 1) ^ (uint16_t)(value < 0 ? 0xffff : 0);
+  while(v >= 0x80) {
+    *p++ = (v & 0x7f) | 0x80;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static const uint8_t *
+get_varint(const uint8_t *p, const uint8_t *end, int16_t *value)
+{
+  uint16_t v;
+  int shift;
+
+  v = 0;
+  for(shift = 0; p < end && shift < 16; shift += 7) {
+    v |= (uint16_t)(*p & 0x7f) << shift;
+    if((*p++ & 0x80) == 0) {
+      *value = (int16_t)((v >> 1) ^ -(v & 1));
+      return p;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+timeout(void *ptr)
+{
+  sample_batch_flush(ptr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(struct sample_batch *b)
+{
+  b->count = 0;
+  b->len = SAMPLE_BATCH_HDR_LEN;
+  memset(b->prev, 0, sizeof(b->prev));
+}
+/*---------------------------------------------------------------------------*/
+void
+sample_batch_init(struct sample_batch *b, uint8_t nfields,
+                  uint8_t max_samples, clock_time_t deadline,
+                  sample_batch_flush_t flush)
+{
+  if(nfields > SAMPLE_BATCH_MAX_FIELDS) {
+    nfields = SAMPLE_BATCH_MAX_FIELDS;
+  }
+  b->nfields = nfields;
+  b->max_samples = max_samples > 0 ? max_samples : 1;
+  b->deadline = deadline;
+  b->flush = flush;
+  memset(&b->stats, 0, sizeof(b->stats));
+  reset(b);
+}
+/*---------------------------------------------------------------------------*/
+void
+sample_batch_flush(struct sample_batch *b)
+{
+  ctimer_stop(&b->timer);
+  if(b->count == 0) {
+    return;
+  }
+
+  b->frame[0] = b->nfields;
+  b->frame[1] = b->count;
+  b->stats.frames++;
+  b->stats.bytes += b->len;
+  if(b->flush != NULL) {
+    b->flush(b, b->frame, b->len);
+  }
+  reset(b);
+}
+/*---------------------------------------------------------------------------*/
+void
+sample_batch_add(struct sample_batch *b, const int16_t *fields)
+{
+  uint8_t *p;
+  int i;
+
+  if(b->len + b->nfields * MAX_FIELD_LEN > SAMPLE_BATCH_FRAME_SIZE) {
+    sample_batch_flush(b);
+  }
+
+  p = &b->frame[b->len];
+  for(i = 0; i < b->nfields; i++) {
+    p = put_varint(p, fields[i] - b->prev[i]);
+    b->prev[i] = fields[i];
+  }
+  b->len = p - b->frame;
+  b->stats.samples++;
+
+  if(++b->count >= b->max_samples) {
+    sample_batch_flush(b);
+  } else if(b->count == 1 && b->deadline > 0) {
+    ctimer_set(&b->timer, b->deadline, timeout, b);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+sample_batch_reader_init(struct sample_batch_reader *r,
+                         const uint8_t *frame, int len, uint8_t nfields)
+{
+  /* The caller's field array has exactly nfields entries, so a frame
+     with fewer fields would leave some of them unset. */
+  if(len < SAMPLE_BATCH_HDR_LEN || frame[0] != nfields ||
+     frame[0] > SAMPLE_BATCH_MAX_FIELDS) {
+    return -1;
+  }
+  r->nfields = frame[0];
+  r->remaining = frame[1];
+  r->ptr = frame + SAMPLE_BATCH_HDR_LEN;
+  r->end = frame + len;
+  memset(r->prev, 0, sizeof(r->prev));
+  return r->remaining;
+}
+/*---------------------------------------------------------------------------*/
+int
+sample_batch_read(struct sample_batch_reader *r, int16_t *fields)
+{
+  int16_t delta;
+  int i;
+
+  if(r->remaining == 0) {
+    return 0;
+  }
+
+  for(i = 0; i < r->nfields; i++) {
+    r->ptr = get_varint(r->ptr, r->end, &delta);
+    if(r->ptr == NULL) {
+      r->remaining = 0;
+      return 0;
+    }
+    r->prev[i] += delta;
+    fields[i] = r->prev[i];
+  }
+  r->remaining--;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Batching of sensor samples into compact frames
+ *
+ *         Samples are vectors of 16-bit integer fields. A batch
+ *         collects up to a maximum number of samples, or waits until
+ *         a deadline after the first sample, and then hands one frame
+ *         to the flush callback. The first sample of a frame is
+ *         stored as-is and every following sample as the difference
+ *         to the one before, each field as a zig-zag encoded varint.
+ */
+
+#ifndef SAMPLE_BATCH_H_
+#define SAMPLE_BATCH_H_
+
+#include "contiki.h"
+#include "sys/ctimer.h"
+
+/* The maximum number of fields in a sample. */
+#ifdef SAMPLE_BATCH_CONF_MAX_FIELDS
+#define SAMPLE_BATCH_MAX_FIELDS SAMPLE_BATCH_CONF_MAX_FIELDS
+#else
+#define SAMPLE_BATCH_MAX_FIELDS 8
+#endif
+
+/* The maximum size of an encoded frame. The default leaves room for
+   the compressed IPv6/UDP headers in a single 802.15.4 frame. */
+#ifdef SAMPLE_BATCH_CONF_FRAME_SIZE
+#define SAMPLE_BATCH_FRAME_SIZE SAMPLE_BATCH_CONF_FRAME_SIZE
+#else
+#define SAMPLE_BATCH_FRAME_SIZE 64
+#endif
+
+/* Frame header: the number of fields and the number of samples. */
+#define SAMPLE_BATCH_HDR_LEN 2
+
+struct sample_batch;
+
+typedef void (* sample_batch_flush_t)(struct sample_batch *b,
+                                      const uint8_t *frame, int len);
+
+struct sample_batch_stats {
+  /* Samples added, frames flushed and encoded bytes flushed. */
+  unsigned long samples, frames, bytes;
+};
+
+struct sample_batch {
+  struct ctimer timer;
+  sample_batch_flush_t flush;
+  clock_time_t deadline;
+  uint8_t nfields;
+  uint8_t max_samples;
+  uint8_t count;
+  uint8_t len;
+  int16_t prev[SAMPLE_BATCH_MAX_FIELDS];
+  uint8_t frame[SAMPLE_BATCH_FRAME_SIZE];
+  struct sample_batch_stats stats;
+};
+
+struct sample_batch_reader {
+  const uint8_t *ptr;
+  const uint8_t *end;
+  uint8_t nfields;
+  uint8_t remaining;
+  int16_t prev[SAMPLE_BATCH_MAX_FIELDS];
+};
+
+/**
+ * \brief      Initialize a sample batch
+ * \param b    The batch
+ * \param nfields The number of fields in each sample
+ * \param max_samples The number of samples after which a frame is flushed
+ * \param deadline The longest time a sample is held back, or 0 for none
+ * \param flush The function that is called with each frame
+ */
+void sample_batch_init(struct sample_batch *b, uint8_t nfields,
+                       uint8_t max_samples, clock_time_t deadline,
+                       sample_batch_flush_t flush);
+
+/**
+ * \brief      Add a sample to a batch
+ * \param b    The batch
+ * \param fields The values of the sample's fields
+ *
+ *             The frame is flushed before the sample is added if the
+ *             sample might not fit, and after the sample is added if
+ *             the batch is full.
+ */
+void sample_batch_add(struct sample_batch *b, const int16_t *fields);
+
+/**
+ * \brief      Flush the samples of a batch, if there are any
+ */
+void sample_batch_flush(struct sample_batch *b);
+
+/**
+ * \brief      Start decoding a frame
+ * \return     The number of samples in the frame, or -1 if the frame
+ *             is malformed or does not have exactly nfields fields
+ */
+int sample_batch_reader_init(struct sample_batch_reader *r,
+                             const uint8_t *frame, int len,
+                             uint8_t nfields);
+
+/**
+ * \brief      Decode the next sample of a frame
+ * \param fields Receives the values of the sample's fields
+ * \return     1 if a sample was decoded, 0 at the end of the frame or
+ *             if the frame is truncated
+ */
+int sample_batch_read(struct sample_batch_reader *r, int16_t *fields);
+
+#endif /* SAMPLE_BATCH_H_ */
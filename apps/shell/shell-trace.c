@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Shell command that dumps the binary event trace
+ */
+
+#include "contiki.h"
+#include "shell.h"
+#include "sys/trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+PROCESS(shell_trace_process, "trace");
+SHELL_COMMAND(trace_command,
+	      "trace",
+	      "trace [clear]: dump the event trace, or clear it",
+	      &shell_trace_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(shell_trace_process, ev, data)
+{
+  char line[2 + 6 * 2 * sizeof(struct trace_record)];
+
+  PROCESS_BEGIN();
+
+  if(data != NULL && strncmp(data, "clear", 5) == 0) {
+    trace_clear();
+    PROCESS_EXIT();
+  }
+
+  /* Same format as trace_dump(), so that tools/trace/trace-decode can
+     read the output of either. */
+  snprintf(line, sizeof(line), "TRACE-START %lu %lu %u %lu",
+           (unsigned long)CLOCK_SECOND, (unsigned long)RTIMER_SECOND,
+           trace_count(), trace_lost());
+  shell_output_str(&trace_command, line, "");
+  while(trace_format(line, sizeof(line)) > 0) {
+    shell_output_str(&trace_command, line, "");
+  }
+  shell_output_str(&trace_command, "TRACE-END", "");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+shell_trace_init(void)
+{
+  shell_register_command(&trace_command);
+}
+/*---------------------------------------------------------------------------*/
@@ -71,24 +71,45 @@ MEMB(conns, struct httpd_state, CONNS);
 #define ISO_period  0x2e
 #define ISO_slash   0x2f
 
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate(void *state)
+{
+  struct httpd_state *s = (struct httpd_state *)state;
+
+  if(s->fresh) {
+    /* The segment was read into uip_appdata by send_file(). */
+    s->fresh = 0;
+    return s->len;
+  }
+
+  /* Read the segment again for a retransmission. */
+  if(cfs_seek(s->fd, s->offset, CFS_SEEK_SET) != s->offset ||
+     cfs_read(s->fd, uip_appdata, s->len) != s->len) {
+    return 0;
+  }
+  return s->len;
+}
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_file(struct httpd_state *s))
 {
   PSOCK_BEGIN(&s->sout);
-  
-  do {
-    /* Read data from file system into buffer */
-    s->len = cfs_read(s->fd, s->outputbuf, sizeof(s->outputbuf));
 
-    /* If there is data in the buffer, send it */
-    if(s->len > 0) {
-      PSOCK_SEND(&s->sout, (uint8_t *)s->outputbuf, s->len);
-    } else {
+  s->offset = 0;
+  while(1) {
+    /* Read data from the file system directly into the packet. The
+       file is read before the segment is sent, because an empty
+       segment would never be acknowledged. */
+    s->len = cfs_read(s->fd, uip_appdata, uip_mss());
+    if(s->len <= 0) {
       break;
     }
-  } while(s->len > 0);
-      
+    s->fresh = 1;
+    PSOCK_GENERATOR_SEND(&s->sout, generate, s);
+    s->offset += s->len;
+  }
+
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
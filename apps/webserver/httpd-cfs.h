@@ -35,6 +35,7 @@
 #define HTTPD_CFS_H_
 
 #include "contiki-net.h"
+#include "cfs/cfs.h"
 
 #ifndef WEBSERVER_CONF_CFS_PATHLEN
 #define HTTPD_PATHLEN 80
@@ -47,11 +48,12 @@ struct httpd_state {
   struct psock sin, sout;
   struct pt outputpt;
   char inputbuf[HTTPD_PATHLEN + 30];
-  char outputbuf[UIP_TCP_MSS];
   char filename[HTTPD_PATHLEN];
   char state;
+  char fresh;
   int fd;
   int len;
+  cfs_offset_t offset;
 };
 
 
@@ -43,6 +43,7 @@
 static uint16_t count[HTTPD_FS_NUMFILES];
 #endif /* HTTPD_FS_STATISTICS */
 
+#ifndef HTTPD_FS_HASH_SIZE
 /*-----------------------------------------------------------------------------------*/
 static uint8_t
 httpd_fs_strcmp(const char *str1, const char *str2)
@@ -64,10 +65,62 @@ loop:
   ++i;
   goto loop;
 }
+#else /* HTTPD_FS_HASH_SIZE */
+/*-----------------------------------------------------------------------------------*/
+/* A name ends at a null, carriage return or newline character, as
+   the names of included files are read from script lines, or at the
+   question mark that starts the query string of a request. */
+#define NAME_END(c) ((c) == 0 || (c) == '\r' || (c) == '\n' || (c) == '?')
+
+/* The perfect hash of the file names that tools/makefsdata
+   generates. It must be kept in sync with the makefsdata script. */
+static int
+httpd_fs_lookup(const char *name)
+{
+  const char *p;
+  uint16_t h;
+  int i;
+
+  h = HTTPD_FS_HASH_SEED;
+  for(p = name; !NAME_END(*p); p++) {
+    h = (h * 33) ^ (unsigned char)*p;
+  }
+  h ^= h >> 8;
+
+  i = httpd_fs_hash[h & (HTTPD_FS_HASH_SIZE - 1)] - 1;
+  if(i < 0) {
+    return -1;
+  }
+
+  /* The slot may hold a different file with the same hash. */
+  p = httpd_fs_files[i]->name;
+  for(; *p != 0; p++, name++) {
+    if(*p != *name) {
+      return -1;
+    }
+  }
+  return NAME_END(*name) ? i : -1;
+}
+#endif /* HTTPD_FS_HASH_SIZE */
 /*-----------------------------------------------------------------------------------*/
 int
 httpd_fs_open(const char *name, struct httpd_fs_file *file)
 {
+#ifdef HTTPD_FS_HASH_SIZE
+  int i;
+
+  i = httpd_fs_lookup(name);
+  if(i < 0) {
+    return 0;
+  }
+  file->data = (char *)httpd_fs_files[i]->data;
+  file->len = httpd_fs_files[i]->len;
+  file->header = httpd_fs_headers[i];
+#if HTTPD_FS_STATISTICS
+  ++count[i];
+#endif /* HTTPD_FS_STATISTICS */
+  return 1;
+#else /* HTTPD_FS_HASH_SIZE */
 #if HTTPD_FS_STATISTICS
   uint16_t i = 0;
 #endif /* HTTPD_FS_STATISTICS */
@@ -80,6 +133,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
     if(httpd_fs_strcmp(name, f->name) == 0) {
       file->data = f->data;
       file->len = f->len;
+      file->header = NULL;
 #if HTTPD_FS_STATISTICS
       ++count[i];
 #endif /* HTTPD_FS_STATISTICS */
@@ -91,6 +145,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
 
   }
   return 0;
+#endif /* HTTPD_FS_HASH_SIZE */
 }
 /*-----------------------------------------------------------------------------------*/
 void
@@ -108,6 +163,12 @@ httpd_fs_init(void)
 uint16_t
 httpd_fs_count(char *name)
 {
+#ifdef HTTPD_FS_HASH_SIZE
+  int i;
+
+  i = httpd_fs_lookup(name);
+  return i < 0 ? 0 : count[i];
+#else /* HTTPD_FS_HASH_SIZE */
   struct httpd_fsdata_file_noconst *f;
   uint16_t i;
 
@@ -122,6 +183,7 @@ httpd_fs_count(char *name)
     ++i;
   }
   return 0;
+#endif /* HTTPD_FS_HASH_SIZE */
 }
 #endif /* HTTPD_FS_STATISTICS */
 /*-----------------------------------------------------------------------------------*/
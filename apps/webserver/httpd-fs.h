@@ -41,6 +41,9 @@
 struct httpd_fs_file {
   char *data;
   int len;
+  /* The Content-type and Content-Length headers of the file, if
+     they were generated by makefsdata. */
+  const char *header;
 };
 
 /* file must be allocated by caller and will be filled in
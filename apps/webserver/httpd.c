@@ -194,7 +194,10 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
   SEND_STRING(&s->sout, statushdr);
 
   ptr = strrchr(s->filename, ISO_period);
-  if(ptr == NULL) {
+  if(s->file.header != NULL) {
+    /* The headers were generated along with the file system. */
+    ptr = s->file.header;
+  } else if(ptr == NULL) {
     ptr = http_content_type_binary;
   } else if(strncmp(http_html, ptr, 5) == 0 ||
 	    strncmp(http_shtml, ptr, 6) == 0) {
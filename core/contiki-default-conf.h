@@ -256,5 +256,19 @@
 #define CONTIKIMAC_CONF_WITH_PHASE_OPTIMIZATION 0
 #endif /* CONTIKIMAC_CONF_WITH_PHASE_OPTIMIZATION */
 
+/* PHASE_CONF_DRIFT_CORRECT specifies if the phase optimization should
+   estimate the clock drift of each neighbor. With a drift estimate,
+   the wake-up time of a neighbor can be predicted further into the
+   future and the guard time before it can be shrunk. */
+#ifndef PHASE_CONF_DRIFT_CORRECT
+#define PHASE_CONF_DRIFT_CORRECT 1
+#endif /* PHASE_CONF_DRIFT_CORRECT */
+
+/* PHASE_CONF_STATS enables the phase_stats counters for prediction
+   error and strobe counts. */
+#ifndef PHASE_CONF_STATS
+#define PHASE_CONF_STATS 0
+#endif /* PHASE_CONF_STATS */
+
 
 #endif /* CONTIKI_DEFAULT_CONF_H */
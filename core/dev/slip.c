@@ -42,6 +42,7 @@
 #define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
 
 #include "dev/slip.h"
+#include "lib/ringbuf16.h"
 
 #define SLIP_END     0300
 #define SLIP_ESC     0333
@@ -59,31 +60,45 @@ uint16_t slip_rubbish, slip_twopackets, slip_overflow, slip_ip_drop;
 #define SLIP_STATISTICS(statement) statement
 #endif
 
-/* Must be at least one byte larger than UIP_BUFSIZE! */
-#define RX_BUFSIZE (UIP_BUFSIZE - UIP_LLH_LEN + 16)
+/*
+ * Bytes are stored in rxbuf as they arrive, still SLIP encoded, and
+ * are decoded straight into the uIP buffer by the process. As many
+ * frames as fit can be buffered. The escapes take space in rxbuf, so a
+ * frame that is full of them needs up to twice its size. The default
+ * holds such a frame of the largest size, the SLIP_END on either side
+ * of it and the byte that the ring buffer keeps free.
+ */
+#ifdef SLIP_CONF_RX_BUFSIZE
+#define RX_BUFSIZE SLIP_CONF_RX_BUFSIZE
+#else
+#define RX_BUFSIZE (2 * (UIP_BUFSIZE - UIP_LLH_LEN) + 3)
+#endif
+
+/* Decoder states. */
+enum {
+  STATE_OK,
+  STATE_ESC,
+  STATE_RUBBISH,
+};
 
+/* Input states of the interrupt handler. */
 enum {
-  STATE_TWOPACKETS = 0,	/* We have 2 packets and drop incoming data. */
-  STATE_OK = 1,
-  STATE_ESC = 2,
-  STATE_RUBBISH = 3,
+  RX_STOPPED,	/* The process is not running, incoming data is dropped. */
+  RX_OK,
+  RX_DROP,	/* rxbuf overflowed, drop data until the next SLIP_END. */
 };
 
+static struct ringbuf16 rxbuf;
+static uint8_t rxbuf_data[RX_BUFSIZE];
+static volatile uint8_t rx_state = RX_STOPPED;
+
 /*
- * Variables begin and end manage the buffer space in a cyclic
- * fashion. The first used byte is at begin and end is one byte past
- * the last. I.e. [begin, end) is the actively used space.
- *
- * If begin != pkt_end we have a packet at [begin, pkt_end),
- * furthermore, if state == STATE_TWOPACKETS we have one more packet at
- * [pkt_end, end). If more bytes arrive in state STATE_TWOPACKETS
- * they are discarded.
+ * The number of SLIP_END bytes put in rxbuf by the interrupt handler
+ * and taken out of it by the process. Each side only writes its own
+ * counter.
  */
-
-static uint8_t state = STATE_TWOPACKETS;
-static uint16_t begin, end;
-static uint8_t rxbuf[RX_BUFSIZE];
-static uint16_t pkt_end;		/* SLIP_END tracker. */
+static volatile uint8_t frames_in;
+static uint8_t frames_out;
 
 static void (* input_callback)(void) = NULL;
 /*---------------------------------------------------------------------------*/
@@ -93,23 +108,34 @@ slip_set_input_callback(void (*c)(void))
   input_callback = c;
 }
 /*---------------------------------------------------------------------------*/
-/* slip_send: forward (IPv4) packets with {UIP_FW_NETIF(..., slip_send)}
- * was used in slip-bridge.c
- */
-uint8_t
-slip_send(void)
+/* Write data with SLIP_END and SLIP_ESC escaped. */
+static void
+write_escaped(const uint8_t *ptr, uint16_t len)
 {
-  uint16_t i;
-  uint8_t *ptr;
+#ifdef SLIP_CONF_ARCH_WRITE
+  /* The platform can write a block of bytes at once: pass on runs of
+     bytes that need no escaping as they are. */
+  static const uint8_t esc_end[2] = { SLIP_ESC, SLIP_ESC_END };
+  static const uint8_t esc_esc[2] = { SLIP_ESC, SLIP_ESC_ESC };
+  uint16_t run;
+
+  while(len > 0) {
+    for(run = 0; run < len && ptr[run] != SLIP_END && ptr[run] != SLIP_ESC;
+        run++);
+    if(run > 0) {
+      SLIP_CONF_ARCH_WRITE(ptr, run);
+      ptr += run;
+      len -= run;
+    } else {
+      SLIP_CONF_ARCH_WRITE(*ptr == SLIP_END ? esc_end : esc_esc, 2);
+      ptr++;
+      len--;
+    }
+  }
+#else /* SLIP_CONF_ARCH_WRITE */
   uint8_t c;
 
-  slip_arch_writeb(SLIP_END);
-
-  ptr = &uip_buf[UIP_LLH_LEN];
-  for(i = 0; i < uip_len; ++i) {
-    if(i == UIP_TCPIP_HLEN) {
-      ptr = (uint8_t *)uip_appdata;
-    }
+  while(len-- > 0) {
     c = *ptr++;
     if(c == SLIP_END) {
       slip_arch_writeb(SLIP_ESC);
@@ -120,6 +146,23 @@ slip_send(void)
     }
     slip_arch_writeb(c);
   }
+#endif /* SLIP_CONF_ARCH_WRITE */
+}
+/*---------------------------------------------------------------------------*/
+/* slip_send: forward (IPv4) packets with {UIP_FW_NETIF(..., slip_send)}
+ * was used in slip-bridge.c
+ */
+uint8_t
+slip_send(void)
+{
+  slip_arch_writeb(SLIP_END);
+
+  if(uip_len <= UIP_TCPIP_HLEN) {
+    write_escaped(&uip_buf[UIP_LLH_LEN], uip_len);
+  } else {
+    write_escaped(&uip_buf[UIP_LLH_LEN], UIP_TCPIP_HLEN);
+    write_escaped((uint8_t *)uip_appdata, uip_len - UIP_TCPIP_HLEN);
+  }
   slip_arch_writeb(SLIP_END);
 
   return UIP_FW_OK;
@@ -128,23 +171,8 @@ slip_send(void)
 uint8_t
 slip_write(const void *_ptr, int len)
 {
-  const uint8_t *ptr = _ptr;
-  uint16_t i;
-  uint8_t c;
-
   slip_arch_writeb(SLIP_END);
-
-  for(i = 0; i < len; ++i) {
-    c = *ptr++;
-    if(c == SLIP_END) {
-      slip_arch_writeb(SLIP_ESC);
-      c = SLIP_ESC_END;
-    } else if(c == SLIP_ESC) {
-      slip_arch_writeb(SLIP_ESC);
-      c = SLIP_ESC_ESC;
-    }
-    slip_arch_writeb(c);
-  }
+  write_escaped(_ptr, len);
   slip_arch_writeb(SLIP_END);
 
   return len;
@@ -153,98 +181,160 @@ slip_write(const void *_ptr, int len)
 static void
 rxbuf_init(void)
 {
-  begin = end = pkt_end = 0;
+  rx_state = RX_STOPPED;
+  ringbuf16_init(&rxbuf, rxbuf_data, sizeof(rxbuf_data));
+  frames_out = frames_in;
+  rx_state = RX_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* The first byte in rxbuf, or -1 if it is empty. */
+static int
+rxbuf_first(void)
+{
+  uint8_t *ptr;
+
+  if(ringbuf16_peek(&rxbuf, &ptr) == 0) {
+    return -1;
+  }
+  return *ptr;
+}
+/*---------------------------------------------------------------------------*/
+/* Check if rxbuf starts with the string s, which may wrap around the
+   end of the buffer. */
+static int
+rxbuf_starts_with(const char *s, uint16_t len)
+{
+  uint8_t *ptr;
+  uint16_t n;
+
+  if(ringbuf16_elements(&rxbuf) < len) {
+    return 0;
+  }
+  n = ringbuf16_peek(&rxbuf, &ptr);
+  if(n >= len) {
+    return memcmp(ptr, s, len) == 0;
+  }
+  return memcmp(ptr, s, n) == 0 &&
+    memcmp(rxbuf_data, s + n, len - n) == 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Decode the frame at the head of rxbuf into outbuf and remove it from
+ * rxbuf, including its SLIP_END. Returns the length of the frame, or
+ * zero if it was empty, broken or longer than blen.
+ */
+static uint16_t
+decode_frame(uint8_t *outbuf, uint16_t blen)
+{
+  uint8_t *ptr;
+  uint16_t i, n, run, len;
+  uint8_t c, state;
+
+  len = 0;
   state = STATE_OK;
+  while(1) {
+    /* The frame is complete, so there always is more data. */
+    n = ringbuf16_peek(&rxbuf, &ptr);
+    for(i = 0; i < n; i++) {
+      c = ptr[i];
+      if(c == SLIP_END) {
+        ringbuf16_consume(&rxbuf, i + 1);
+        if(state != STATE_OK) {
+          SLIP_STATISTICS(slip_rubbish++);
+          return 0;
+        }
+        return len;
+      }
+      if(state == STATE_RUBBISH) {
+        continue;
+      }
+      if(state == STATE_ESC) {
+        if(c == SLIP_ESC_END) {
+          c = SLIP_END;
+        } else if(c == SLIP_ESC_ESC) {
+          c = SLIP_ESC;
+        } else {
+          state = STATE_RUBBISH;
+          continue;
+        }
+        state = STATE_OK;
+        run = 1;
+      } else if(c == SLIP_ESC) {
+        state = STATE_ESC;
+        continue;
+      } else {
+        for(run = 1; i + run < n && ptr[i + run] != SLIP_END
+              && ptr[i + run] != SLIP_ESC; run++);
+      }
+
+      if(run > blen - len) {
+        state = STATE_RUBBISH;
+        continue;
+      }
+      if(run == 1) {
+        outbuf[len] = c;
+      } else {
+        memcpy(&outbuf[len], &ptr[i], run);
+      }
+      len += run;
+      i += run - 1;
+    }
+    ringbuf16_consume(&rxbuf, n);
+  }
 }
 /*---------------------------------------------------------------------------*/
 /* Upper half does the polling. */
 static uint16_t
 slip_poll_handler(uint8_t *outbuf, uint16_t blen)
 {
-  /* This is a hack and won't work across buffer edge! */
-  if(rxbuf[begin] == 'C') {
+  uint16_t len;
+
+  /* This is a hack and won't work inside a frame! */
+  if(rxbuf_starts_with("CLIENT", 6)) {
     int i;
-    if(begin < end && (end - begin) >= 6
-       && memcmp(&rxbuf[begin], "CLIENT", 6) == 0) {
-      state = STATE_TWOPACKETS;	/* Interrupts do nothing. */
-      memset(&rxbuf[begin], 0x0, 6);
-      
-      rxbuf_init();
-      
-      for(i = 0; i < 13; i++) {
-	slip_arch_writeb("CLIENTSERVER\300"[i]);
-      }
-      return 0;
+    ringbuf16_consume(&rxbuf, 6);
+    for(i = 0; i < 13; i++) {
+      slip_arch_writeb("CLIENTSERVER\300"[i]);
     }
+    return 0;
   }
 #ifdef SLIP_CONF_ANSWER_MAC_REQUEST
-  else if(rxbuf[begin] == '?') { 
+  else if(rxbuf_starts_with("?M", 2)) {
     /* Used by tapslip6 to request mac for auto configure */
-    int i, j;
+    int j;
     char* hexchar = "0123456789abcdef";
-    if(begin < end && (end - begin) >= 2
-       && rxbuf[begin + 1] == 'M') {
-      state = STATE_TWOPACKETS; /* Interrupts do nothing. */
-      rxbuf[begin] = 0;
-      rxbuf[begin + 1] = 0;
-      
-      rxbuf_init();
-      
-      linkaddr_t addr = get_mac_addr();
-      /* this is just a test so far... just to see if it works */
-      slip_arch_writeb('!');
-      slip_arch_writeb('M');
-      for(j = 0; j < 8; j++) {
-        slip_arch_writeb(hexchar[addr.u8[j] >> 4]);
-        slip_arch_writeb(hexchar[addr.u8[j] & 15]);
-      }
-      slip_arch_writeb(SLIP_END);
-      return 0;
+    ringbuf16_consume(&rxbuf, 2);
+
+    linkaddr_t addr = get_mac_addr();
+    /* this is just a test so far... just to see if it works */
+    slip_arch_writeb('!');
+    slip_arch_writeb('M');
+    for(j = 0; j < 8; j++) {
+      slip_arch_writeb(hexchar[addr.u8[j] >> 4]);
+      slip_arch_writeb(hexchar[addr.u8[j] & 15]);
     }
+    slip_arch_writeb(SLIP_END);
+    return 0;
   }
 #endif /* SLIP_CONF_ANSWER_MAC_REQUEST */
 
-  /*
-   * Interrupt can not change begin but may change pkt_end.
-   * If pkt_end != begin it will not change again.
-   */
-  if(begin != pkt_end) {
-    uint16_t len;
-
-    if(begin < pkt_end) {
-      len = pkt_end - begin;
-      if(len > blen) {
-	len = 0;
-      } else {
-	memcpy(outbuf, &rxbuf[begin], len);
-      }
-    } else {
-      len = (RX_BUFSIZE - begin) + (pkt_end - 0);
-      if(len > blen) {
-	len = 0;
-      } else {
-	unsigned i;
-	for(i = begin; i < RX_BUFSIZE; i++) {
-	  *outbuf++ = rxbuf[i];
-	}
-	for(i = 0; i < pkt_end; i++) {
-	  *outbuf++ = rxbuf[i];
-	}
+  while(frames_out != frames_in) {
+    frames_out++;
+    len = decode_frame(outbuf, blen);
+    if(len > 0) {
+      if(frames_out != frames_in) {
+        /* More frames are buffered, need to be polled again! */
+        process_poll(&slip_process);
       }
+      return len;
     }
-
-    /* Remove data from buffer together with the copied packet. */
-    begin = pkt_end;
-    if(state == STATE_TWOPACKETS) {
-      pkt_end = end;
-      state = STATE_OK;		/* Assume no bytes where lost! */
-      
-      /* One more packet is buffered, need to be polled again! */
-      process_poll(&slip_process);
-    }
-    return len;
   }
 
+  if(rx_state == RX_DROP && ringbuf16_space(&rxbuf) < 2) {
+    /* rxbuf is full with a single unfinished frame. Make room for the
+       interrupt handler to terminate it. */
+    ringbuf16_consume(&rxbuf, ringbuf16_elements(&rxbuf));
+  }
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -316,74 +406,37 @@ PROCESS_THREAD(slip_process, ev, data)
 int
 slip_input_byte(unsigned char c)
 {
-  switch(state) {
-  case STATE_RUBBISH:
-    if(c == SLIP_END) {
-      state = STATE_OK;
+  if(rx_state != RX_OK) {
+    if(rx_state == RX_DROP && c == SLIP_END
+       && ringbuf16_space(&rxbuf) >= 2) {
+      /* Terminate the broken frame with an invalid escape sequence, so
+         that it is dropped by the decoder. */
+      ringbuf16_put(&rxbuf, SLIP_ESC);
+      ringbuf16_put(&rxbuf, SLIP_END);
+      rx_state = RX_OK;
+      frames_in++;
+      process_poll(&slip_process);
+      return 1;
     }
     return 0;
-    
-  case STATE_TWOPACKETS:       /* Two packets are already buffered! */
-    return 0;
+  }
 
-  case STATE_ESC:
-    if(c == SLIP_ESC_END) {
-      c = SLIP_END;
-    } else if(c == SLIP_ESC_ESC) {
-      c = SLIP_ESC;
-    } else {
-      state = STATE_RUBBISH;
-      SLIP_STATISTICS(slip_rubbish++);
-      end = pkt_end;		/* remove rubbish */
-      return 0;
-    }
-    state = STATE_OK;
-    break;
-
-  case STATE_OK:
-    if(c == SLIP_ESC) {
-      state = STATE_ESC;
-      return 0;
-    } else if(c == SLIP_END) {
-	/*
-	 * We have a new packet, possibly of zero length.
-	 *
-	 * There may already be one packet buffered.
-	 */
-      if(end != pkt_end) {	/* Non zero length. */
-	if(begin == pkt_end) {	/* None buffered. */
-	  pkt_end = end;
-	} else {
-	  state = STATE_TWOPACKETS;
-	  SLIP_STATISTICS(slip_twopackets++);
-	}
-	process_poll(&slip_process);
-	return 1;
-      }
-      return 0;
-    }
-    break;
+  if(!ringbuf16_put(&rxbuf, c)) {
+    rx_state = RX_DROP;
+    SLIP_STATISTICS(slip_overflow++);
+    process_poll(&slip_process);
+    return 0;
   }
 
-  /* add_char: */
-  {
-    unsigned next;
-    next = end + 1;
-    if(next == RX_BUFSIZE) {
-      next = 0;
-    }
-    if(next == begin) {		/* rxbuf is full */
-      state = STATE_RUBBISH;
-      SLIP_STATISTICS(slip_overflow++);
-      end = pkt_end;		/* remove rubbish */
-      return 0;
-    }
-    rxbuf[end] = c;
-    end = next;
+  if(c == SLIP_END) {
+    /* We have a new frame, possibly of zero length. */
+    frames_in++;
+    process_poll(&slip_process);
+    return 1;
   }
 
   /* There could be a separate poll routine for this. */
-  if(c == 'T' && rxbuf[begin] == 'C') {
+  if(c == 'T' && rxbuf_first() == 'C') {
     process_poll(&slip_process);
     return 1;
   }
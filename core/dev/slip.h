@@ -83,4 +83,11 @@ void slip_set_input_callback(void (*callback)(void));
 void slip_arch_init(unsigned long ubr);
 void slip_arch_writeb(unsigned char c);
 
+/*
+ * A platform that can write a block of bytes at once, for instance
+ * with DMA, can define SLIP_CONF_ARCH_WRITE(ptr, len) to a function
+ * that does so. It is then used for everything but the SLIP_END
+ * bytes around each frame.
+ */
+
 #endif /* SLIP_H_ */
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ * Doubly linked list manipulation routines.
+ *
+ */
+
+/**
+ * \addtogroup dlist
+ * @{
+ */
+
+#include "lib/dlist.h"
+
+#include <stddef.h>
+
+struct dlist_item {
+  struct dlist_item *next;
+  struct dlist_item *prev;
+};
+
+/*---------------------------------------------------------------------------*/
+static void
+unlink_item(dlist_t list, struct dlist_item *i)
+{
+  if(i->prev == NULL) {
+    list->head = i->next;
+  } else {
+    i->prev->next = i->next;
+  }
+  if(i->next == NULL) {
+    list->tail = i->prev;
+  } else {
+    i->next->prev = i->prev;
+  }
+  i->next = i->prev = NULL;
+  list->length--;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Initialize a doubly linked list.
+ *
+ * \param list The list to be initialized.
+ */
+void
+dlist_init(dlist_t list)
+{
+  list->head = list->tail = NULL;
+  list->length = 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Get a pointer to the first element of a list.
+ *
+ * \param list The list.
+ * \return A pointer to the first element on the list.
+ */
+void *
+dlist_head(dlist_t list)
+{
+  return list->head;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Get a pointer to the last element of a list.
+ *
+ * \param list The list.
+ * \return A pointer to the last element on the list.
+ */
+void *
+dlist_tail(dlist_t list)
+{
+  return list->tail;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Check if an element is on a list.
+ *
+ * \param list The list.
+ * \param item The element.
+ * \return Non-zero if the element is on the list.
+ */
+int
+dlist_contains(dlist_t list, void *item)
+{
+  struct dlist_item *i = item;
+
+  if(i == NULL) {
+    return 0;
+  }
+  if(i->prev == NULL) {
+    return list->head == i;
+  }
+  return i->prev->next == i;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Add an element at the end of a list.
+ *
+ * An element that already is on the list is moved to the end.
+ *
+ * \param list The list.
+ * \param item A pointer to the element to be added.
+ */
+void
+dlist_add(dlist_t list, void *item)
+{
+  struct dlist_item *i = item;
+
+  if(dlist_contains(list, i)) {
+    unlink_item(list, i);
+  }
+
+  i->next = NULL;
+  i->prev = list->tail;
+  if(list->tail == NULL) {
+    list->head = i;
+  } else {
+    ((struct dlist_item *)list->tail)->next = i;
+  }
+  list->tail = i;
+  list->length++;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Add an element at the start of a list.
+ *
+ * An element that already is on the list is moved to the start.
+ *
+ * \param list The list.
+ * \param item A pointer to the element to be added.
+ */
+void
+dlist_push(dlist_t list, void *item)
+{
+  struct dlist_item *i = item;
+
+  if(dlist_contains(list, i)) {
+    unlink_item(list, i);
+  }
+
+  i->prev = NULL;
+  i->next = list->head;
+  if(list->head == NULL) {
+    list->tail = i;
+  } else {
+    ((struct dlist_item *)list->head)->prev = i;
+  }
+  list->head = i;
+  list->length++;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Remove the first element on a list.
+ *
+ * \param list The list.
+ * \return Pointer to the removed element, or NULL if the list is empty.
+ */
+void *
+dlist_pop(dlist_t list)
+{
+  struct dlist_item *i = list->head;
+
+  if(i != NULL) {
+    unlink_item(list, i);
+  }
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Remove the last element on a list.
+ *
+ * \param list The list.
+ * \return Pointer to the removed element, or NULL if the list is empty.
+ */
+void *
+dlist_chop(dlist_t list)
+{
+  struct dlist_item *i = list->tail;
+
+  if(i != NULL) {
+    unlink_item(list, i);
+  }
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Remove a specific element from a list.
+ *
+ * Nothing is done if the element is not on the list.
+ *
+ * \param list The list.
+ * \param item The element that is to be removed from the list.
+ */
+void
+dlist_remove(dlist_t list, void *item)
+{
+  if(dlist_contains(list, item)) {
+    unlink_item(list, item);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Get the length of a list.
+ *
+ * \param list The list.
+ * \return The number of elements on the list.
+ */
+int
+dlist_length(dlist_t list)
+{
+  return list->length;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Insert an element after a specified element on the list
+ * \param list The list
+ * \param previtem The element after which the new element should be inserted
+ * \param newitem  The new element that is to be inserted
+ *
+ *             If previtem is NULL, the new element is placed at the
+ *             start of the list.
+ */
+void
+dlist_insert(dlist_t list, void *previtem, void *newitem)
+{
+  struct dlist_item *p = previtem;
+  struct dlist_item *i = newitem;
+
+  if(p == NULL) {
+    dlist_push(list, i);
+    return;
+  }
+
+  if(dlist_contains(list, i)) {
+    unlink_item(list, i);
+  }
+
+  i->prev = p;
+  i->next = p->next;
+  if(p->next == NULL) {
+    list->tail = i;
+  } else {
+    p->next->prev = i;
+  }
+  p->next = i;
+  list->length++;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Get the element following an element.
+ *
+ * \param item A list element
+ * \return The next element on the list, or NULL.
+ */
+void *
+dlist_item_next(void *item)
+{
+  return item == NULL ? NULL : ((struct dlist_item *)item)->next;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Get the element preceding an element.
+ *
+ * \param item A list element
+ * \return The previous element on the list, or NULL.
+ */
+void *
+dlist_item_prev(void *item)
+{
+  return item == NULL ? NULL : ((struct dlist_item *)item)->prev;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ * Doubly linked list manipulation routines.
+ */
+
+/** \addtogroup lib
+    @{ */
+/**
+ * \defgroup dlist Doubly linked list library
+ *
+ * The doubly linked list library is a variant of the \ref list
+ * "linked list library" for lists that are long or that are changed
+ * often. Adding an element to either end of a list, removing an
+ * element and getting the length of a list take constant time,
+ * whereas the linked list library walks the list for each of these.
+ *
+ * An element of a doubly linked list \b must start with two
+ * pointers: the first points to the next element and the second to
+ * the previous element. As the first pointer is the same as in the
+ * linked list library, the elements can also be iterated with
+ * list_item_next() and passed to code that expects \ref list
+ * elements.
+ *
+ * An element can be on at most one doubly linked list at a time. An
+ * element that is not on a list must have both of its pointers set
+ * to NULL, which is the case for zeroed memory and for elements that
+ * have been removed from a list.
+ *
+ * Lists are declared with the DLIST() macro.
+ *
+ * @{
+ */
+
+#ifndef DLIST_H_
+#define DLIST_H_
+
+#include "lib/list.h"
+
+/**
+ * Declare a doubly linked list.
+ *
+ * The list variable is declared as static to make it easy to use in a
+ * single C module without unnecessarily exporting the name to other
+ * modules.
+ *
+ * \param name The name of the list.
+ */
+#define DLIST(name) \
+         static struct dlist LIST_CONCAT(name,_dlist); \
+         static dlist_t name = &LIST_CONCAT(name,_dlist)
+
+/**
+ * Declare a doubly linked list inside a structure declaraction.
+ *
+ * The list is initialized with the DLIST_STRUCT_INIT() macro. As with
+ * LIST_STRUCT(), the pointer has the name of the parameter to the
+ * macro and points to the list itself, whose name has the suffix
+ * "_dlist".
+ *
+ * \param name The name of the list.
+ */
+#define DLIST_STRUCT(name) \
+         struct dlist LIST_CONCAT(name,_dlist); \
+         dlist_t name
+
+/**
+ * Initialize a doubly linked list that is part of a structure.
+ *
+ * \param struct_ptr A pointer to the struct
+ * \param name The name of the list.
+ */
+#define DLIST_STRUCT_INIT(struct_ptr, name)                             \
+    do {                                                                \
+       (struct_ptr)->name = &((struct_ptr)->LIST_CONCAT(name,_dlist));  \
+       dlist_init((struct_ptr)->name);                                  \
+    } while(0)
+
+struct dlist {
+  void *head;
+  void *tail;
+  unsigned short length;
+};
+
+/**
+ * The doubly linked list type.
+ *
+ */
+typedef struct dlist * dlist_t;
+
+void   dlist_init(dlist_t list);
+void * dlist_head(dlist_t list);
+void * dlist_tail(dlist_t list);
+void * dlist_pop (dlist_t list);
+void   dlist_push(dlist_t list, void *item);
+
+void * dlist_chop(dlist_t list);
+
+void   dlist_add(dlist_t list, void *item);
+void   dlist_remove(dlist_t list, void *item);
+
+int    dlist_length(dlist_t list);
+int    dlist_contains(dlist_t list, void *item);
+
+void   dlist_insert(dlist_t list, void *previtem, void *newitem);
+
+void * dlist_item_next(void *item);
+void * dlist_item_prev(void *item);
+
+#endif /* DLIST_H_ */
+
+/** @} */
+/** @} */
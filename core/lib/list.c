@@ -131,7 +131,9 @@ list_tail(list_t list)
 /**
  * Add an item at the end of a list.
  *
- * This function adds an item to the end of the list.
+ * This function adds an item to the end of the list. The list is
+ * walked to find its end. Lists that are long or that are appended
+ * to often should use the \ref dlist "doubly linked list library".
  *
  * \param list The list.
  * \param item A pointer to the item to be added.
@@ -142,19 +144,29 @@ list_tail(list_t list)
 void
 list_add(list_t list, void *item)
 {
-  struct list *l;
+  struct list *l, *tail;
 
-  /* Make sure not to add the same element twice */
-  list_remove(list, item);
+  /* Make sure not to add the same element twice. The element is
+     unlinked in the same walk that finds the tail of the list. */
+  tail = NULL;
+  for(l = *list; l != NULL; l = l->next) {
+    if(l == item) {
+      if(tail == NULL) {
+        *list = l->next;
+      } else {
+        tail->next = l->next;
+      }
+    } else {
+      tail = l;
+    }
+  }
 
   ((struct list *)item)->next = NULL;
-  
-  l = list_tail(list);
 
-  if(l == NULL) {
+  if(tail == NULL) {
     *list = item;
   } else {
-    l->next = item;
+    tail->next = item;
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -45,8 +45,8 @@
 
 
 #include "mmem.h"
-#include "list.h"
 #include "contiki-conf.h"
+#include <stdint.h>
 #include <string.h>
 
 #ifdef MMEM_CONF_SIZE
@@ -55,10 +55,193 @@
 #define MMEM_SIZE 4096
 #endif
 
-LIST(mmemlist);
+/* The number of free lists. Free blocks are kept in the list of the
+   power-of-two size class of their size in words. */
+#ifdef MMEM_CONF_CLASSES
+#define MMEM_CLASSES MMEM_CONF_CLASSES
+#else
+#define MMEM_CLASSES 8
+#endif
+
+/* The number of blocks that are moved during each call to
+   mmem_alloc() and mmem_free() while a compaction is in progress. */
+#ifdef MMEM_CONF_COMPACT_STEPS
+#define MMEM_COMPACT_STEPS MMEM_CONF_COMPACT_STEPS
+#else
+#define MMEM_COMPACT_STEPS 4
+#endif
+
+/* A compaction is started when this many bytes are free below the
+   highest allocated block. */
+#ifdef MMEM_CONF_COMPACT_THRESHOLD
+#define MMEM_COMPACT_THRESHOLD MMEM_CONF_COMPACT_THRESHOLD
+#else
+#define MMEM_COMPACT_THRESHOLD (MMEM_SIZE / 4)
+#endif
+
+/*
+ * The memory consists of blocks that start with a header word. The
+ * header of an allocated block points to its struct mmem, from which
+ * the size of the block follows. The header of a free block holds its
+ * size in words, shifted left and with the lowest bit set. Free
+ * blocks of two words or more are linked into the free list of their
+ * size class by their second word.
+ */
+typedef uintptr_t word_t;
+
+#define WORD_SIZE		sizeof(word_t)
+#define WORDS(bytes)		(((bytes) + WORD_SIZE - 1) / WORD_SIZE)
+#define BLOCK_WORDS(m)		(1 + WORDS((m)->size))
+
+#define FREE_TAG(words)		((word_t)(words) << 1 | 1)
+#define IS_FREE(tag)		((tag) & 1)
+#define FREE_WORDS(tag)		((tag) >> 1)
+
+#define HEAP_WORDS		(MMEM_SIZE / WORD_SIZE)
+
+struct free_block {
+  word_t tag;
+  struct free_block *next;
+};
+
 unsigned int avail_memory;
-static char memory[MMEM_SIZE];
+
+static word_t heap[HEAP_WORDS];
+
+/* The words above the highest block are free. */
+static unsigned top;
+
+static struct free_block *free_lists[MMEM_CLASSES];
+
+/* An incremental compaction slides the allocated blocks from src
+   down to dst, in address order. */
+static uint8_t compacting;
+static unsigned src;
+static unsigned dst;
+
+static struct mmem_stats stats;
 
+/*---------------------------------------------------------------------------*/
+static unsigned
+size_class(unsigned words)
+{
+  unsigned class;
+
+  for(class = 0; words > 1 && class < MMEM_CLASSES - 1; words >>= 1) {
+    class++;
+  }
+  return class;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+block_words(unsigned offset)
+{
+  word_t tag;
+
+  tag = heap[offset];
+  if(IS_FREE(tag)) {
+    return FREE_WORDS(tag);
+  }
+  return BLOCK_WORDS((struct mmem *)tag);
+}
+/*---------------------------------------------------------------------------*/
+static void
+release(unsigned offset, unsigned words)
+{
+  struct free_block *block;
+  unsigned class;
+
+  block = (struct free_block *)&heap[offset];
+  block->tag = FREE_TAG(words);
+
+  /* Blocks that a running compaction has yet to reach are dropped
+     when it does. A block of one word is too small to be listed. */
+  if((compacting && offset >= src) || words < 2) {
+    return;
+  }
+
+  class = size_class(words);
+  block->next = free_lists[class];
+  free_lists[class] = block;
+}
+/*---------------------------------------------------------------------------*/
+static void
+compact_start(void)
+{
+  memset(free_lists, 0, sizeof(free_lists));
+  src = dst = 0;
+  compacting = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+compact_step(void)
+{
+  struct mmem *m;
+  unsigned words;
+
+  if(src == top) {
+    top = dst;
+    compacting = 0;
+    stats.compactions++;
+    return;
+  }
+
+  words = block_words(src);
+  if(!IS_FREE(heap[src])) {
+    if(src != dst) {
+      m = (struct mmem *)heap[src];
+      memmove(&heap[dst], &heap[src], words * WORD_SIZE);
+      m->ptr = &heap[dst + 1];
+      stats.moved += words * WORD_SIZE;
+    }
+    dst += words;
+  }
+  src += words;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+fragmented(void)
+{
+  return avail_memory - (HEAP_WORDS - top) * WORD_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+compact_some(void)
+{
+  int i;
+
+  if(!compacting && fragmented() >= MMEM_COMPACT_THRESHOLD) {
+    compact_start();
+  }
+  for(i = 0; compacting && i < MMEM_COMPACT_STEPS; i++) {
+    compact_step();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Take a listed free block of at least the requested number of words. */
+static int
+take_free(unsigned words)
+{
+  struct free_block **link;
+  struct free_block *block;
+  unsigned class;
+  unsigned available;
+
+  for(class = size_class(words); class < MMEM_CLASSES; class++) {
+    for(link = &free_lists[class]; *link != NULL; link = &(*link)->next) {
+      block = *link;
+      available = FREE_WORDS(block->tag);
+      if(available >= words) {
+        *link = block->next;
+        if(available > words) {
+          release((word_t *)block - heap + words, available - words);
+        }
+        return (word_t *)block - heap;
+      }
+    }
+  }
+  return -1;
+}
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Allocate a managed memory block
@@ -82,24 +265,50 @@ static char memory[MMEM_SIZE];
 int
 mmem_alloc(struct mmem *m, unsigned int size)
 {
+  unsigned words;
+  int offset;
+
+  m->size = size;
+  words = BLOCK_WORDS(m);
+
   /* Check if we have enough memory left for this allocation. */
-  if(avail_memory < size) {
+  if(avail_memory < words * WORD_SIZE) {
+    stats.failures++;
     return 0;
   }
 
-  /* We had enough memory so we add this memory block to the end of
-     the list of allocated memory blocks. */
-  list_add(mmemlist, m);
+  compact_some();
 
-  /* Set up the pointer so that it points to the first available byte
-     in the memory block. */
-  m->ptr = &memory[MMEM_SIZE - avail_memory];
+  offset = take_free(words);
+  if(offset < 0) {
+    if(HEAP_WORDS - top < words) {
+      /* The memory is too fragmented. Finish any running compaction,
+         and compact again if blocks were freed behind it. */
+      while(compacting) {
+        compact_step();
+      }
+      if(HEAP_WORDS - top < words) {
+        compact_start();
+        while(compacting) {
+          compact_step();
+        }
+      }
+      if(HEAP_WORDS - top < words) {
+        stats.failures++;
+        return 0;
+      }
+    }
+    offset = top;
+    top += words;
+  }
 
-  /* Remember the size of this memory block. */
-  m->size = size;
+  heap[offset] = (word_t)m;
+  m->ptr = &heap[offset + 1];
 
-  /* Decrease the amount of available memory. */
-  avail_memory -= size;
+  avail_memory -= words * WORD_SIZE;
+  if(HEAP_WORDS * WORD_SIZE - avail_memory > stats.high_water) {
+    stats.high_water = HEAP_WORDS * WORD_SIZE - avail_memory;
+  }
 
   /* Return non-zero to indicate that we were able to allocate
      memory. */
@@ -114,29 +323,63 @@ mmem_alloc(struct mmem *m, unsigned int size)
  *             This function deallocates a managed memory block that
  *             previously has been allocated with mmem_alloc().
  *
+ *             The memory is not compacted immediately. Blocks are
+ *             moved a few at a time by later calls to mmem_alloc()
+ *             and mmem_free(), once enough memory has been freed
+ *             below other blocks.
+ *
  */
 void
 mmem_free(struct mmem *m)
 {
-  struct mmem *n;
-
-  if(m->next != NULL) {
-    /* Compact the memory after the allocation that is to be removed
-       by moving it downwards. */
-    memmove(m->ptr, m->next->ptr,
-	    &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr);
-    
-    /* Update all the memory pointers that points to memory that is
-       after the allocation that is to be removed. */
-    for(n = m->next; n != NULL; n = n->next) {
-      n->ptr = (void *)((char *)n->ptr - m->size);
-    }
-  }
+  unsigned offset;
+  unsigned words;
 
-  avail_memory += m->size;
+  offset = (word_t *)m->ptr - heap - 1;
+  words = BLOCK_WORDS(m);
+
+  avail_memory += words * WORD_SIZE;
+
+  if(offset + words == top && !compacting) {
+    /* The highest block is returned to the free space above it. */
+    top = offset;
+  } else {
+    release(offset, words);
+  }
 
-  /* Remove the memory block from the list. */
-  list_remove(mmemlist, m);
+  compact_some();
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Compact the managed memory
+ * \author     Adam Dunkels
+ *
+ *             This function moves all allocated blocks to the start
+ *             of the memory, so that the free memory is contiguous.
+ *
+ */
+void
+mmem_compact(void)
+{
+  if(!compacting) {
+    compact_start();
+  }
+  while(compacting) {
+    compact_step();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Get statistics of the managed memory
+ * \param s    A pointer to the structure that receives the statistics.
+ *
+ */
+void
+mmem_get_stats(struct mmem_stats *s)
+{
+  *s = stats;
+  s->used = HEAP_WORDS * WORD_SIZE - avail_memory;
+  s->fragmented = fragmented();
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -155,8 +398,11 @@ mmem_init(void)
   if(inited) {
     return;
   }
-  list_init(mmemlist);
-  avail_memory = MMEM_SIZE;
+  memset(free_lists, 0, sizeof(free_lists));
+  memset(&stats, 0, sizeof(stats));
+  top = 0;
+  compacting = 0;
+  avail_memory = HEAP_WORDS * WORD_SIZE;
   inited = 1;
 }
 /*---------------------------------------------------------------------------*/
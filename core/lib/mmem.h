@@ -38,11 +38,13 @@
  * \defgroup mmem Managed memory allocator
  *
  * The managed memory allocator is a fragmentation-free memory
- * manager. It keeps the allocated memory free from fragmentation by
- * compacting the memory when blocks are freed. A program that uses
- * the managed memory module cannot be sure that allocated memory
- * stays in place. Therefore, a level of indirection is used: access
- * to allocated memory must always be done using a special macro.
+ * manager. Freed blocks are reused through size-class free lists, and
+ * the memory is compacted incrementally once enough of it has been
+ * freed below other blocks. A program that uses the managed memory
+ * module cannot be sure that allocated memory stays in place across
+ * calls to mmem_alloc(), mmem_free() and mmem_compact(). Therefore, a
+ * level of indirection is used: access to allocated memory must
+ * always be done using a special macro.
  *
  * \note This module has not been heavily tested.
  * @{
@@ -83,8 +85,19 @@ struct mmem {
 /* XXX: tagga minne med "interrupt usage", vilke gr att man r
    speciellt varsam under free(). */
 
+struct mmem_stats {
+  unsigned int used;        /* Bytes allocated, including headers. */
+  unsigned int high_water;  /* The highest number of used bytes. */
+  unsigned int fragmented;  /* Free bytes below the highest block. */
+  unsigned int compactions; /* Completed compactions. */
+  unsigned long moved;      /* Bytes moved by compactions. */
+  unsigned int failures;    /* Failed allocations. */
+};
+
 int  mmem_alloc(struct mmem *m, unsigned int size);
 void mmem_free(struct mmem *);
+void mmem_compact(void);
+void mmem_get_stats(struct mmem_stats *);
 void mmem_init(void);
 
 #endif /* MMEM_H_ */
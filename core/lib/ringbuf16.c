@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Ring buffer library with 16-bit indices
+ */
+
+#include "lib/ringbuf16.h"
+
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+static uint16_t
+load_index(volatile uint16_t *p)
+{
+  uint16_t i;
+
+  RINGBUF16_ATOMIC_BEGIN();
+  i = *p;
+  RINGBUF16_ATOMIC_END();
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+static void
+store_index(volatile uint16_t *p, uint16_t i)
+{
+  RINGBUF16_ATOMIC_BEGIN();
+  *p = i;
+  RINGBUF16_ATOMIC_END();
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+advance(struct ringbuf16 *r, uint16_t i, uint16_t len)
+{
+  i += len;
+  if(i >= r->size) {
+    i -= r->size;
+  }
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+void
+ringbuf16_init(struct ringbuf16 *r, uint8_t *dataptr, uint16_t size)
+{
+  r->data = dataptr;
+  r->size = size;
+  r->put_ptr = 0;
+  r->get_ptr = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbuf16_put(struct ringbuf16 *r, uint8_t c)
+{
+  uint16_t put, next;
+
+  /* Only the producer writes ->put_ptr, so it can be read directly. */
+  put = r->put_ptr;
+  next = advance(r, put, 1);
+  if(next == load_index(&r->get_ptr)) {
+    return 0;
+  }
+  r->data[put] = c;
+  store_index(&r->put_ptr, next);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbuf16_get(struct ringbuf16 *r)
+{
+  uint16_t get;
+  uint8_t c;
+
+  get = r->get_ptr;
+  if(get == load_index(&r->put_ptr)) {
+    return -1;
+  }
+  c = r->data[get];
+  store_index(&r->get_ptr, advance(r, get, 1));
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_peek(struct ringbuf16 *r, uint8_t **ptr)
+{
+  uint16_t get, put;
+
+  get = r->get_ptr;
+  put = load_index(&r->put_ptr);
+  *ptr = &r->data[get];
+  if(put >= get) {
+    return put - get;
+  }
+  return r->size - get;
+}
+/*---------------------------------------------------------------------------*/
+void
+ringbuf16_consume(struct ringbuf16 *r, uint16_t len)
+{
+  store_index(&r->get_ptr, advance(r, r->get_ptr, len));
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_reserve(struct ringbuf16 *r, uint8_t **ptr)
+{
+  uint16_t get, put;
+
+  put = r->put_ptr;
+  get = load_index(&r->get_ptr);
+  *ptr = &r->data[put];
+  if(get > put) {
+    return get - put - 1;
+  }
+  /* The free space runs to the end of the array, except for the byte
+     that must stay free when the consumer is at the start. */
+  return r->size - put - (get == 0 ? 1 : 0);
+}
+/*---------------------------------------------------------------------------*/
+void
+ringbuf16_commit(struct ringbuf16 *r, uint16_t len)
+{
+  store_index(&r->put_ptr, advance(r, r->put_ptr, len));
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_write(struct ringbuf16 *r, const uint8_t *buf, uint16_t len)
+{
+  uint16_t done, n;
+  uint8_t *ptr;
+
+  /* At most two rounds: up to the end of the array, then from its
+     start. */
+  for(done = 0; done < len; done += n) {
+    n = ringbuf16_reserve(r, &ptr);
+    if(n == 0) {
+      break;
+    }
+    if(n > len - done) {
+      n = len - done;
+    }
+    memcpy(ptr, buf + done, n);
+    ringbuf16_commit(r, n);
+  }
+  return done;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_read(struct ringbuf16 *r, uint8_t *buf, uint16_t len)
+{
+  uint16_t done, n;
+  uint8_t *ptr;
+
+  for(done = 0; done < len; done += n) {
+    n = ringbuf16_peek(r, &ptr);
+    if(n == 0) {
+      break;
+    }
+    if(n > len - done) {
+      n = len - done;
+    }
+    memcpy(buf + done, ptr, n);
+    ringbuf16_consume(r, n);
+  }
+  return done;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_size(struct ringbuf16 *r)
+{
+  return r->size - 1;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_elements(struct ringbuf16 *r)
+{
+  uint16_t get, put;
+
+  get = load_index(&r->get_ptr);
+  put = load_index(&r->put_ptr);
+  if(put >= get) {
+    return put - get;
+  }
+  return r->size - get + put;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+ringbuf16_space(struct ringbuf16 *r)
+{
+  return ringbuf16_size(r) - ringbuf16_elements(r);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for the 16-bit ring buffer library
+ */
+
+/** \addtogroup lib
+ * @{ */
+
+/**
+ * \defgroup ringbuf16 Ring buffer library with 16-bit indices
+ * @{
+ *
+ * The 16-bit ring buffer library is a variant of the \ref ringbuf
+ * "ring buffer library" for buffers larger than 128 bytes. Any size
+ * up to 65535 bytes can be used, of which one byte is always kept
+ * free to tell a full buffer from an empty one.
+ *
+ * Besides single bytes, data can be written and read in blocks, and
+ * the contiguous part of the buffer that is ready to be read or
+ * written can be accessed directly, which lets device drivers and
+ * protocol decoders work on the data without copying it.
+ *
+ * One producer and one consumer may use a ring buffer concurrently,
+ * for instance an interrupt handler and a process. The producer only
+ * writes the put index and the consumer only writes the get index.
+ * On CPUs that cannot load and store 16 bits in a single instruction,
+ * RINGBUF16_CONF_ATOMIC_BEGIN() and RINGBUF16_CONF_ATOMIC_END() must
+ * be defined to protect index accesses, for instance by disabling
+ * interrupts.
+ *
+ */
+
+#ifndef RINGBUF16_H_
+#define RINGBUF16_H_
+
+#include "contiki-conf.h"
+
+#ifdef RINGBUF16_CONF_ATOMIC_BEGIN
+#define RINGBUF16_ATOMIC_BEGIN() RINGBUF16_CONF_ATOMIC_BEGIN()
+#define RINGBUF16_ATOMIC_END()   RINGBUF16_CONF_ATOMIC_END()
+#else
+#define RINGBUF16_ATOMIC_BEGIN()
+#define RINGBUF16_ATOMIC_END()
+#endif
+
+/**
+ * \brief      Structure that holds the state of a ring buffer.
+ *
+ *             This structure holds the state of a ring buffer. The
+ *             actual buffer needs to be defined separately. This
+ *             struct is an opaque structure with no user-visible
+ *             elements.
+ *
+ */
+struct ringbuf16 {
+  uint8_t *data;
+  uint16_t size;
+  volatile uint16_t put_ptr, get_ptr;
+};
+
+/**
+ * \brief      Initialize a ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param a    A pointer to an array to hold the data in the buffer
+ * \param size The size of the array, at least two bytes
+ *
+ *             The ring buffer holds at most size - 1 bytes.
+ */
+void     ringbuf16_init(struct ringbuf16 *r, uint8_t *a, uint16_t size);
+
+/**
+ * \brief      Insert a byte into the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param c    The byte to be written to the buffer
+ * \return     Non-zero if there data could be written, or zero if the buffer was full.
+ */
+int      ringbuf16_put(struct ringbuf16 *r, uint8_t c);
+
+/**
+ * \brief      Get a byte from the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \return     The data from the buffer, or -1 if the buffer was empty
+ */
+int      ringbuf16_get(struct ringbuf16 *r);
+
+/**
+ * \brief      Insert a block of data into the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param buf  The data to be written
+ * \param len  The number of bytes to write
+ * \return     The number of bytes written, which is less than len if the buffer became full
+ */
+uint16_t ringbuf16_write(struct ringbuf16 *r, const uint8_t *buf, uint16_t len);
+
+/**
+ * \brief      Remove a block of data from the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param buf  Where to store the data
+ * \param len  The largest number of bytes to read
+ * \return     The number of bytes read
+ */
+uint16_t ringbuf16_read(struct ringbuf16 *r, uint8_t *buf, uint16_t len);
+
+/**
+ * \brief      Get the contiguous data at the head of the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param ptr  Set to point to the first byte in the buffer
+ * \return     The number of bytes that can be read from *ptr
+ *
+ *             The data stays in the buffer until it is removed with
+ *             ringbuf16_consume(). If the data wraps around the end
+ *             of the array, only the first part is returned, and the
+ *             rest is returned by the next call after that part has
+ *             been consumed.
+ */
+uint16_t ringbuf16_peek(struct ringbuf16 *r, uint8_t **ptr);
+
+/**
+ * \brief      Remove data from the head of the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param len  The number of bytes to remove, at most ringbuf16_elements()
+ */
+void     ringbuf16_consume(struct ringbuf16 *r, uint16_t len);
+
+/**
+ * \brief      Get the contiguous free space at the tail of the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param ptr  Set to point to the first free byte
+ * \return     The number of bytes that can be written to *ptr
+ *
+ *             Data written to *ptr is added to the buffer with
+ *             ringbuf16_commit().
+ */
+uint16_t ringbuf16_reserve(struct ringbuf16 *r, uint8_t **ptr);
+
+/**
+ * \brief      Add data written after ringbuf16_reserve() to the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \param len  The number of bytes written, at most the value returned by ringbuf16_reserve()
+ */
+void     ringbuf16_commit(struct ringbuf16 *r, uint16_t len);
+
+/**
+ * \brief      Get the capacity of a ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \return     The largest number of bytes the buffer can hold.
+ */
+uint16_t ringbuf16_size(struct ringbuf16 *r);
+
+/**
+ * \brief      Get the number of bytes currently in the ring buffer
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \return     The number of bytes in the buffer.
+ */
+uint16_t ringbuf16_elements(struct ringbuf16 *r);
+
+/**
+ * \brief      Get the number of bytes that can currently be written
+ * \param r    A pointer to a struct ringbuf16 to hold the state of the ring buffer
+ * \return     The free space in the buffer.
+ */
+uint16_t ringbuf16_space(struct ringbuf16 *r);
+
+#endif /* RINGBUF16_H_ */
+
+/** @}*/
+/** @}*/
@@ -69,6 +69,13 @@
 #define MIN(a,b) ((a)<(b)?a:b)
 #endif
 
+#ifdef SETTINGS_CONF_INDEX_SIZE
+/** The number of items whose key and location are kept in RAM. */
+#define SETTINGS_INDEX_SIZE	SETTINGS_CONF_INDEX_SIZE
+#else
+#define SETTINGS_INDEX_SIZE	16
+#endif
+
 typedef struct {
 #if SETTINGS_CONF_SUPPORT_LARGE_VALUES
   uint8_t size_extra;
@@ -78,6 +85,122 @@ typedef struct {
   settings_key_t key;
 } item_header_t;
 
+/*****************************************************************************/
+// MARK: - Index
+/*****************************************************************************/
+
+/* Walking the store costs an EEPROM read per item, so the location of
+ * the first SETTINGS_INDEX_SIZE items and the end of the store are
+ * kept in RAM. The index is built by the first call that needs it and
+ * updated by the functions in this file that change the store.
+ */
+
+enum {
+  INDEX_STALE,
+  INDEX_PARTIAL,                /* More items than index entries. */
+  INDEX_COMPLETE,
+};
+
+#if SETTINGS_INDEX_SIZE
+static struct {
+  settings_key_t key;
+  settings_iter_t iter;
+} index_entries[SETTINGS_INDEX_SIZE];
+#endif
+static uint8_t index_len;
+static uint8_t index_state = INDEX_STALE;
+
+/** Where the header of the next item will be written. */
+static settings_iter_t end_iter;
+
+/*---------------------------------------------------------------------------*/
+static void
+index_invalidate(void)
+{
+  index_state = INDEX_STALE;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+index_append(settings_key_t key, settings_iter_t iter)
+{
+#if SETTINGS_INDEX_SIZE
+  if(index_len < SETTINGS_INDEX_SIZE) {
+    index_entries[index_len].key = key;
+    index_entries[index_len].iter = iter;
+    index_len++;
+    return;
+  }
+#endif
+  index_state = INDEX_PARTIAL;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+index_build(void)
+{
+  settings_iter_t iter;
+  settings_iter_t last = 0;
+
+  index_len = 0;
+  index_state = INDEX_COMPLETE;
+  for(iter = settings_iter_begin(); iter; iter = settings_iter_next(iter)) {
+    index_append(settings_iter_get_key(iter), iter);
+    last = iter;
+  }
+
+  /* Value address of item is the same as the iterator for next item. */
+  end_iter = last ? settings_iter_get_value_addr(last) : SETTINGS_TOP_ADDR;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Returns the iterator for the index'th item with the given key, or
+ * zero if there is none.
+ */
+static settings_iter_t
+index_find(settings_key_t key, uint8_t index)
+{
+  settings_iter_t iter;
+#if SETTINGS_INDEX_SIZE
+  uint8_t i;
+#endif
+
+  if(index_state == INDEX_STALE) {
+    index_build();
+  }
+
+#if SETTINGS_INDEX_SIZE
+  for(i = 0; i < index_len; i++) {
+    if(index_entries[i].key == key) {
+      if(!index) {
+        return index_entries[i].iter;
+      }
+      index--;
+    }
+  }
+#endif
+
+  if(index_state == INDEX_COMPLETE) {
+    return 0;
+  }
+
+  /* Continue in EEPROM after the last indexed item. */
+#if SETTINGS_INDEX_SIZE
+  iter = settings_iter_next(index_entries[index_len - 1].iter);
+#else
+  iter = settings_iter_begin();
+#endif
+  for(; iter; iter = settings_iter_next(iter)) {
+    if(settings_iter_get_key(iter) == key) {
+      if(!index) {
+        return iter;
+      }
+      index--;
+    }
+  }
+  return 0;
+}
+
 /*****************************************************************************/
 // MARK: - Public Travesal Functions
 /*****************************************************************************/
@@ -210,6 +333,7 @@ settings_iter_delete(settings_iter_t iter)
     memset(&header, 0xFF, sizeof(header));
 
     eeprom_write(iter - sizeof(header), (uint8_t *)&header, sizeof(header));
+    index_invalidate();
 
     ret = SETTINGS_STATUS_OK;
   }
@@ -230,49 +354,85 @@ settings_iter_delete(settings_iter_t iter)
 uint8_t
 settings_check(settings_key_t key, uint8_t index)
 {
-  uint8_t ret = 0;
+  return index_find(key, index) != 0;
+}
 
-  settings_iter_t iter;
+/*---------------------------------------------------------------------------*/
+settings_status_t
+settings_get(settings_key_t key, uint8_t index, uint8_t *value,
+             settings_length_t * value_size)
+{
+  settings_iter_t iter = index_find(key, index);
 
-  for(iter = settings_iter_begin(); iter; iter = settings_iter_next(iter)) {
-    if(settings_iter_get_key(iter) == key) {
-      if(!index) {
-        ret = 1;
-        break;
-      } else {
-        index--;
-      }
-    }
+  if(!iter) {
+    return SETTINGS_STATUS_NOT_FOUND;
   }
 
-  return ret;
+  *value_size = settings_iter_get_value_bytes(iter, (void *)value,
+                                              *value_size);
+  return SETTINGS_STATUS_OK;
 }
 
 /*---------------------------------------------------------------------------*/
 settings_status_t
-settings_get(settings_key_t key, uint8_t index, uint8_t *value,
-             settings_length_t * value_size)
+settings_get_batch(settings_request_t *requests, uint8_t count)
 {
-  settings_status_t ret = SETTINGS_STATUS_NOT_FOUND;
+  settings_status_t ret = SETTINGS_STATUS_OK;
 
   settings_iter_t iter;
 
-  for(iter = settings_iter_begin(); iter; iter = settings_iter_next(iter)) {
-    if(settings_iter_get_key(iter) == key) {
-      if(!index) {
-        /* We found it! */
-        *value_size = settings_iter_get_value_bytes(iter,
-                                                    (void *)value,
-                                                    *value_size);
-        ret = SETTINGS_STATUS_OK;
-        break;
-      } else {
-        /* Nope, keep looking */
-        index--;
+  settings_key_t key;
+
+  uint8_t i, pending;
+
+  for(i = 0; i < count; i++) {
+    requests[i].status = SETTINGS_STATUS_NOT_FOUND;
+    requests[i].seen = 0;
+  }
+  pending = count;
+
+  if(index_state == INDEX_STALE) {
+    index_build();
+  }
+
+  if(index_state == INDEX_COMPLETE) {
+    /* Every item is in the index, no headers have to be read. */
+    for(i = 0; i < count; i++) {
+      iter = index_find(requests[i].key, requests[i].index);
+      if(iter) {
+        requests[i].value_size =
+          settings_iter_get_value_bytes(iter, (void *)requests[i].value,
+                                        requests[i].value_size);
+        requests[i].status = SETTINGS_STATUS_OK;
+        pending--;
+      }
+    }
+    return pending ? SETTINGS_STATUS_NOT_FOUND : SETTINGS_STATUS_OK;
+  }
+
+  /* Walk the store once, and read each value as its item is found. */
+  for(iter = settings_iter_begin(); iter && pending;
+      iter = settings_iter_next(iter)) {
+    key = settings_iter_get_key(iter);
+    for(i = 0; i < count; i++) {
+      if(requests[i].status != SETTINGS_STATUS_NOT_FOUND
+         || requests[i].key != key) {
+        continue;
+      }
+      if(requests[i].seen++ == requests[i].index) {
+        requests[i].value_size =
+          settings_iter_get_value_bytes(iter, (void *)requests[i].value,
+                                        requests[i].value_size);
+        requests[i].status = SETTINGS_STATUS_OK;
+        pending--;
       }
     }
   }
 
+  if(pending) {
+    ret = SETTINGS_STATUS_NOT_FOUND;
+  }
+
   return ret;
 }
 
@@ -287,19 +447,12 @@ settings_add(settings_key_t key, const uint8_t *value,
 
   item_header_t header;
 
-  /* Find the last item. */
-  for(iter = settings_iter_begin(); settings_iter_next(iter);
-      iter = settings_iter_next(iter)) {
-    /* This block intentionally left blank. */
-  }
+  settings_iter_t next;
 
-  if(iter) {
-    /* Value address of item is the same as the iterator for next item. */
-    iter = settings_iter_get_value_addr(iter);
-  } else {
-    /* This will be the first setting! */
-    iter = SETTINGS_TOP_ADDR;
+  if(index_state == INDEX_STALE) {
+    index_build();
   }
+  iter = end_iter;
 
   if(iter < SETTINGS_BOTTOM_ADDR + value_size + sizeof(header)) {
     /* This value is too big to store. */
@@ -342,6 +495,7 @@ settings_add(settings_key_t key, const uint8_t *value,
 
   /* Sanity check, remove once confident */
   if(settings_iter_get_value_length(iter) != value_size) {
+    index_invalidate();
     goto bail;
   }
 
@@ -351,12 +505,15 @@ settings_add(settings_key_t key, const uint8_t *value,
   /* This should be the last item. If this is not the case,
    * then we need to clear out the phantom setting.
    */
-  if((iter = settings_iter_next(iter))) {
+  if((next = settings_iter_next(iter))) {
     memset(&header, 0xFF, sizeof(header));
 
-    eeprom_write(iter - sizeof(header),(uint8_t *)&header, sizeof(header));
+    eeprom_write(next - sizeof(header),(uint8_t *)&header, sizeof(header));
   }
 
+  index_append(key, iter);
+  end_iter = settings_iter_get_value_addr(iter);
+
   ret = SETTINGS_STATUS_OK;
 
 bail:
@@ -370,13 +527,7 @@ settings_set(settings_key_t key, const uint8_t *value,
 {
   settings_status_t ret = SETTINGS_STATUS_FAILURE;
 
-  settings_iter_t iter;
-
-  for(iter = settings_iter_begin(); iter; iter = settings_iter_next(iter)) {
-    if(settings_iter_get_key(iter) == key) {
-      break;
-    }
-  }
+  settings_iter_t iter = index_find(key, 0);
 
   if((iter == EEPROM_NULL) || !settings_iter_is_valid(iter)) {
     ret = settings_add(key, value, value_size);
@@ -403,24 +554,13 @@ bail:
 settings_status_t
 settings_delete(settings_key_t key, uint8_t index)
 {
-  settings_status_t ret = SETTINGS_STATUS_NOT_FOUND;
-
-  settings_iter_t iter;
+  settings_iter_t iter = index_find(key, index);
 
-  for(iter = settings_iter_begin(); iter; iter = settings_iter_next(iter)) {
-    if(settings_iter_get_key(iter) == key) {
-      if(!index) {
-        /* We found it! */
-        ret = settings_iter_delete(iter);
-        break;
-      } else {
-        /* Nope, keep looking */
-        index--;
-      }
-    }
+  if(!iter) {
+    return SETTINGS_STATUS_NOT_FOUND;
   }
 
-  return ret;
+  return settings_iter_delete(iter);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -433,6 +573,7 @@ settings_wipe(void)
   const uint32_t x = 0xFFFFFF;
 
   eeprom_write(SETTINGS_TOP_ADDR - sizeof(x), (uint8_t *)&x, sizeof(x));
+  index_invalidate();
 }
 
 /*****************************************************************************/
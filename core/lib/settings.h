@@ -107,6 +107,19 @@ typedef uint16_t settings_key_t;
 
 typedef uint16_t settings_length_t;
 
+/** A value to be fetched by settings_get_batch(). */
+typedef struct {
+  settings_key_t key;
+  uint8_t index;
+  uint8_t *value;
+  /** The size of value, set to the length of the value that was read. */
+  settings_length_t value_size;
+  /** Set to SETTINGS_STATUS_OK if the value was found. */
+  settings_status_t status;
+  /** Used internally. */
+  uint8_t seen;
+} settings_request_t;
+
 /*****************************************************************************/
 // MARK: - Settings Keys
 
@@ -159,6 +172,13 @@ extern settings_status_t settings_get(settings_key_t key, uint8_t index,
                                       uint8_t *value,
                                       settings_length_t * value_size);
 
+/** Fetches the values of several keys, reading the settings store only
+ *  once. Returns SETTINGS_STATUS_OK if all of them were found; the
+ *  status of each request tells which ones were.
+ */
+extern settings_status_t settings_get_batch(settings_request_t *requests,
+                                            uint8_t count);
+
 /** Adds the given key-value pair to the end of the settings store. */
 extern settings_status_t settings_add(settings_key_t key,
                                       const uint8_t *value,
@@ -67,6 +67,7 @@
 #include "net/ip/uip-udp-packet.h"
 #include "net/ip/uip-nameserver.h"
 #include "lib/random.h"
+#include "lib/list.h"
 
 #ifndef DEBUG
 #define DEBUG CONTIKI_TARGET_COOJA
@@ -244,14 +245,17 @@ struct dns_answer {
 };
 
 struct namemap {
+  /* Link in the deadline-ordered list of pending queries. */
+  struct namemap *next;
 #define STATE_UNUSED 0
 #define STATE_ERROR  1
 #define STATE_NEW    2
 #define STATE_ASKING 3
 #define STATE_DONE   4
   uint8_t state;
-  uint8_t tmr;
   uint16_t id;
+  uint16_t hash;
+  clock_time_t deadline;
   uint8_t retries;
   uint8_t seqno;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
@@ -278,8 +282,16 @@ static uint8_t seqno;
 
 static struct uip_udp_conn *resolv_conn = NULL;
 
+/* Entries in state NEW or ASKING, ordered by the time their next
+   query is due. Only the head of the list drives the retry timer, so
+   cached and idle entries never wake the resolver. */
+LIST(pending);
+
 static struct etimer retry;
 
+/* The base unit of the query retransmission back-off. */
+#define RETRY_TICK (CLOCK_SECOND / 4)
+
 process_event_t resolv_event_found;
 
 PROCESS(resolv_process, "DNS resolver");
@@ -628,6 +640,147 @@ mdns_prep_host_announce_packet(void)
 }
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * Computes the case-insensitive hash that is stored with each entry,
+ * so that lookups only compare the names of entries whose hash match.
+ */
+static uint16_t
+name_hash(const char *name)
+{
+  uint16_t h = 5381;
+
+  for(; *name; name++) {
+    h = (h * 33) ^ (uint8_t)tolower((unsigned char)*name);
+  }
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ */
+static struct namemap *
+find_name(const char *name)
+{
+  uint16_t h;
+  uint8_t i;
+
+  if(*name == 0) {
+    return NULL;
+  }
+
+  h = name_hash(name);
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    if(names[i].state != STATE_UNUSED && names[i].hash == h &&
+       strcasecmp(names[i].name, name) == 0) {
+      return &names[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns an entry that may be reused: an unused or expired one or,
+ * if `evict` is set, the least recently queried one.
+ */
+static struct namemap *
+free_entry(uint8_t evict)
+{
+  uint8_t i;
+  uint8_t lseq = 0;
+  struct namemap *nameptr;
+  struct namemap *oldest = evict ? &names[0] : NULL;
+
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    nameptr = &names[i];
+    if((nameptr->state == STATE_UNUSED)
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+      || ((nameptr->state == STATE_DONE || nameptr->state == STATE_ERROR) &&
+          clock_seconds() > nameptr->expiration)
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+    ) {
+      return nameptr;
+    }
+    if(evict && (uint8_t)(seqno - nameptr->seqno) > lseq) {
+      lseq = seqno - nameptr->seqno;
+      oldest = nameptr;
+    }
+  }
+  return oldest;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the number of clock ticks until the entry is due, or zero if
+ * it is already due.
+ */
+static clock_time_t
+time_left(const struct namemap *nameptr)
+{
+  clock_time_t left = nameptr->deadline - clock_time();
+
+  if(left > ((clock_time_t)~0 >> 1)) {
+    return 0;
+  }
+  return left;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * (Re)inserts an entry in the pending list, ordered by its deadline.
+ */
+static void
+schedule(struct namemap *nameptr, clock_time_t delay)
+{
+  struct namemap *prev, *n;
+
+  list_remove(pending, nameptr);
+  nameptr->deadline = clock_time() + delay;
+
+  prev = NULL;
+  for(n = list_head(pending); n != NULL; n = list_item_next(n)) {
+    if(time_left(n) > delay) {
+      break;
+    }
+    prev = n;
+  }
+  if(prev == NULL) {
+    list_push(pending, nameptr);
+  } else {
+    list_insert(pending, prev, nameptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Takes an entry out of the pending list and reports the result.
+ */
+static void
+finish(struct namemap *nameptr, uint8_t state, unsigned long ttl)
+{
+  list_remove(pending, nameptr);
+  nameptr->state = state;
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  nameptr->expiration = clock_seconds() + ttl;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  resolv_found(nameptr->name, state == STATE_DONE ? &nameptr->ipaddr : NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Arms the retry timer for the earliest pending query, or polls right
+ * away if one is already due.
+ */
+static void
+reschedule(void)
+{
+  struct namemap *head = list_head(pending);
+
+  if(head == NULL) {
+    etimer_stop(&retry);
+  } else if(time_left(head) == 0) {
+    tcpip_poll_udp(resolv_conn);
+  } else {
+    PROCESS_CONTEXT_BEGIN(&resolv_process);
+    etimer_set(&retry, time_left(head));
+    PROCESS_CONTEXT_END(&resolv_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
 static char
 try_next_server(struct namemap *namemapptr)
 {
@@ -644,68 +797,60 @@ try_next_server(struct namemap *namemapptr)
 }
 /*---------------------------------------------------------------------------*/
 /** \internal
- * Runs through the list of names to see if there are any that have
- * not yet been queried and, if so, sends out a query.
+ * Sends out the query of the first pending entry that is due, if any,
+ * and rearms the retry timer for the next one.
  */
 static void
 check_entries(void)
 {
-  volatile uint8_t i;
-
   uint8_t *query;
 
   register struct dns_hdr *hdr;
 
   register struct namemap *namemapptr;
 
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    namemapptr = &names[i];
-    if(namemapptr->state == STATE_NEW || namemapptr->state == STATE_ASKING) {
-      etimer_set(&retry, CLOCK_SECOND / 4);
-      if(namemapptr->state == STATE_ASKING) {
-        if(--namemapptr->tmr == 0) {
-#if RESOLV_CONF_SUPPORTS_MDNS
-          if(++namemapptr->retries ==
-             (namemapptr->is_mdns ? RESOLV_CONF_MAX_MDNS_RETRIES :
-              RESOLV_CONF_MAX_RETRIES))
-#else /* RESOLV_CONF_SUPPORTS_MDNS */
-          if(++namemapptr->retries == RESOLV_CONF_MAX_RETRIES)
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-          {
-            /* Try the next server (if possible) before failing. Otherwise
-               simply mark the entry as failed. */
-            if(try_next_server(namemapptr) == 0) {
-              /* STATE_ERROR basically means "not found". */
-              namemapptr->state = STATE_ERROR;
-
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-              /* Keep the "not found" error valid for 30 seconds */
-              namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-              resolv_found(namemapptr->name, NULL);
-              continue;
-            }
-          }
-          namemapptr->tmr = namemapptr->retries * namemapptr->retries * 3;
+  clock_time_t delay;
 
+  while((namemapptr = list_head(pending)) != NULL &&
+        time_left(namemapptr) == 0) {
+    if(namemapptr->state == STATE_ASKING) {
 #if RESOLV_CONF_SUPPORTS_MDNS
-          if(namemapptr->is_probe) {
-            /* Probing retries are much more aggressive, 250ms */
-            namemapptr->tmr = 2;
-          }
+      if(++namemapptr->retries ==
+         (namemapptr->is_mdns ? RESOLV_CONF_MAX_MDNS_RETRIES :
+          RESOLV_CONF_MAX_RETRIES))
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+      if(++namemapptr->retries == RESOLV_CONF_MAX_RETRIES)
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
-        } else {
-          /* Its timer has not run out, so we move on to next
-           * entry.
-           */
+      {
+        /* Try the next server (if possible) before failing. Otherwise
+           simply mark the entry as failed. */
+        if(try_next_server(namemapptr) == 0) {
+          /* STATE_ERROR basically means "not found". Keep the "not
+             found" error valid for 30 seconds. */
+          finish(namemapptr, STATE_ERROR, 30);
           continue;
         }
-      } else {
-        namemapptr->state = STATE_ASKING;
-        namemapptr->tmr = 1;
-        namemapptr->retries = 0;
       }
+      delay = namemapptr->retries * namemapptr->retries * 3 * RETRY_TICK;
+      if(delay == 0) {
+        /* First query to the next server. */
+        delay = RETRY_TICK;
+      }
+
+#if RESOLV_CONF_SUPPORTS_MDNS
+      if(namemapptr->is_probe) {
+        /* Probing retries are much more aggressive, 500ms */
+        delay = 2 * RETRY_TICK;
+      }
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+    } else {
+      namemapptr->state = STATE_ASKING;
+      namemapptr->retries = 0;
+      delay = RETRY_TICK;
+    }
+    schedule(namemapptr, delay);
+
+    {
       hdr = (struct dns_hdr *)uip_appdata;
       memset(hdr, 0, sizeof(struct dns_hdr));
       hdr->id = random_rand();
@@ -752,7 +897,7 @@ check_entries(void)
                               (query - (uint8_t *) uip_appdata),
                               &resolv_mdns_addr, UIP_HTONS(MDNS_PORT));
 
-        PRINTF("resolver: (i=%d) Sent MDNS %s for \"%s\".\n", i,
+        PRINTF("resolver: Sent MDNS %s for \"%s\".\n",
                namemapptr->is_probe?"probe":"request",namemapptr->name);
       } else {
         uip_udp_packet_sendto(resolv_conn, uip_appdata,
@@ -761,7 +906,7 @@ check_entries(void)
                                 uip_nameserver_get(namemapptr->server), 
                               UIP_HTONS(DNS_PORT));
 
-        PRINTF("resolver: (i=%d) Sent DNS request for \"%s\".\n", i,
+        PRINTF("resolver: Sent DNS request for \"%s\".\n",
                namemapptr->name);
       }
 #else /* RESOLV_CONF_SUPPORTS_MDNS */
@@ -769,12 +914,15 @@ check_entries(void)
                             (query - (uint8_t *) uip_appdata),
                             uip_nameserver_get(namemapptr->server), 
                             UIP_HTONS(DNS_PORT));
-      PRINTF("resolver: (i=%d) Sent DNS request for \"%s\".\n", i,
+      PRINTF("resolver: Sent DNS request for \"%s\".\n",
              namemapptr->name);
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      break;
     }
+    /* Only one query fits in the buffer; the rest wait for the next
+       poll, which reschedule() requests if they are already due. */
+    break;
   }
+  reschedule();
 }
 /*---------------------------------------------------------------------------*/
 /** \internal
@@ -785,7 +933,9 @@ newdata(void)
 {
   static uint8_t nquestions, nanswers;
 
+#if VERBOSE_DEBUG
   static int8_t i;
+#endif /* VERBOSE_DEBUG */
 
   register struct namemap *namemapptr = NULL;
 
@@ -804,7 +954,9 @@ newdata(void)
   nanswers = (uint8_t) uip_ntohs(hdr->numanswers);
 
   queryptr = (unsigned char *)hdr + sizeof(*hdr);
+#if VERBOSE_DEBUG
   i = 0;
+#endif /* VERBOSE_DEBUG */
 
   DEBUG_PRINTF
     ("resolver: flags1=0x%02X flags2=0x%02X nquestions=%d, nanswers=%d, nauthrr=%d, nextrarr=%d\n",
@@ -895,8 +1047,14 @@ newdata(void)
 
 /** ANSWER HANDLING SECTION **************************************************/
 
-  if(nanswers == 0) {
-    /* Skip responses with no answers. */
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(nanswers == 0 &&
+     (is_request || UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT))) {
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+  if(nanswers == 0 && is_request) {
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+    /* Skip requests and MDNS responses with no answers. Unicast
+       responses without answers (e.g. NXDOMAIN) complete their query. */
     return;
   }
 
@@ -907,45 +1065,40 @@ newdata(void)
      * because we can't use the `id` field. We will look up the
      * appropriate request in a later step. */
 
-    i = -1;
     namemapptr = NULL;
   } else
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
   {
-    for(i = 0; i < RESOLV_ENTRIES; ++i) {
-      namemapptr = &names[i];
+    /* Only entries that are still asking can match the ID. */
+    for(namemapptr = list_head(pending); namemapptr != NULL;
+        namemapptr = list_item_next(namemapptr)) {
       if(namemapptr->state == STATE_ASKING &&
          namemapptr->id == hdr->id) {
         break;
       }
     }
 
-    if(i >= RESOLV_ENTRIES || i < 0 || namemapptr->state != STATE_ASKING) {
+    if(namemapptr == NULL) {
       PRINTF("resolver: DNS response has bad ID (%04X) \n", uip_ntohs(hdr->id));
       return;
     }
 
     PRINTF("resolver: Incoming response for \"%s\".\n", namemapptr->name);
 
-    /* We'll change this to DONE when we find the record. */
-    namemapptr->state = STATE_ERROR;
-
     namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    /* If we remain in the error state, keep it cached for 30 seconds. */
-    namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-    /* Check for error. If so, call callback to inform. */
+    /* Check for error. If so, call callback to inform. The error is
+       kept cached for 30 seconds. */
     if(namemapptr->err != 0) {
-      namemapptr->state = STATE_ERROR;
-      resolv_found(namemapptr->name, NULL);
+      finish(namemapptr, STATE_ERROR, 30);
+      reschedule();
       return;
     }
   }
 
+#if VERBOSE_DEBUG
   i = 0;
+#endif /* VERBOSE_DEBUG */
 
   /* Answer parsing loop */
   while(nanswers > 0) {
@@ -984,49 +1137,37 @@ newdata(void)
 #if RESOLV_CONF_SUPPORTS_MDNS
     if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
        hdr->id == 0) {
-      int8_t available_i = RESOLV_ENTRIES;
+      static char answer_name[RESOLV_CONF_MAX_DOMAIN_NAME_SIZE + 1];
 
       DEBUG_PRINTF("resolver: MDNS query.\n");
 
       /* For MDNS, we need to actually look up the name we
        * are looking for.
        */
-      for(i = 0; i < RESOLV_ENTRIES; ++i) {
-        namemapptr = &names[i];
-        if(dns_name_isequal(queryptr, namemapptr->name, uip_appdata)) {
-          break;
-        }
-        if((namemapptr->state == STATE_UNUSED)
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-          || (namemapptr->state == STATE_DONE && clock_seconds() > namemapptr->expiration)
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        ) {
-          available_i = i;
-        }
+      if(!decode_name(queryptr, answer_name, uip_appdata)) {
+        DEBUG_PRINTF("resolver: MDNS name too big to cache.\n");
+        namemapptr = NULL;
+        goto skip_to_next_answer;
       }
-      if(i == RESOLV_ENTRIES) {
+      namemapptr = find_name(answer_name);
+      if(namemapptr == NULL) {
         DEBUG_PRINTF("resolver: Unsolicited MDNS response.\n");
-        i = available_i;
-        namemapptr = &names[i];
-        if(!decode_name(queryptr, namemapptr->name, uip_appdata)) {
-          DEBUG_PRINTF("resolver: MDNS name too big to cache.\n");
-          namemapptr = NULL;
+        namemapptr = free_entry(0);
+        if(namemapptr == NULL) {
+          DEBUG_PRINTF
+            ("resolver: Not enough room to keep track of unsolicited MDNS answer.\n");
+
+          if(strcasecmp(answer_name, resolv_hostname) == 0) {
+            /* Oh snap, they say they are us! We had better report them... */
+            resolv_found(resolv_hostname, (uip_ipaddr_t *) ans->ipaddr);
+          }
           goto skip_to_next_answer;
         }
+        memset(namemapptr, 0, sizeof(*namemapptr));
+        strcpy(namemapptr->name, answer_name);
+        namemapptr->hash = name_hash(answer_name);
+        namemapptr->is_mdns = 1;
       }
-      if(i == RESOLV_ENTRIES) {
-        DEBUG_PRINTF
-          ("resolver: Not enough room to keep track of unsolicited MDNS answer.\n");
-
-        if(dns_name_isequal(queryptr, resolv_hostname, uip_appdata)) {
-          /* Oh snap, they say they are us! We had better report them... */
-          resolv_found(resolv_hostname, (uip_ipaddr_t *) ans->ipaddr);
-        }
-        namemapptr = NULL;
-        goto skip_to_next_answer;
-      }
-      namemapptr = &names[i];
-
     } else
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
     {
@@ -1045,15 +1186,20 @@ newdata(void)
 
     DEBUG_PRINTF("resolver: Answer for \"%s\" is usable.\n", namemapptr->name);
 
-    namemapptr->state = STATE_DONE;
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    namemapptr->expiration = ans->ttl[1] + (ans->ttl[0] << 8);
-    namemapptr->expiration += clock_seconds();
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
     uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
 
-    resolv_found(namemapptr->name, &namemapptr->ipaddr);
+    {
+      uint32_t ttl = ((uint32_t)uip_ntohs(ans->ttl[0]) << 16) |
+                     uip_ntohs(ans->ttl[1]);
+
+      /* RFC 2181, section 8: a TTL with the most significant bit set
+         is treated as zero. */
+      if(ttl & 0x80000000UL) {
+        ttl = 0;
+      }
+      finish(namemapptr, STATE_DONE, ttl);
+    }
+    reschedule();
     break;
 
   skip_to_next_answer:
@@ -1071,9 +1217,12 @@ newdata(void)
 #endif
   {
     if(try_next_server(namemapptr)) {
-      namemapptr->state = STATE_ASKING;
-      process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
+      namemapptr->state = STATE_NEW;
+      schedule(namemapptr, 0);
+    } else {
+      finish(namemapptr, STATE_ERROR, 30);
     }
+    reschedule();
   }
 
 }
@@ -1159,6 +1308,7 @@ PROCESS_THREAD(resolv_process, ev, data)
   PROCESS_BEGIN();
 
   memset(names, 0, sizeof(names));
+  list_init(pending);
 
   resolv_event_found = process_alloc_event();
 
@@ -1266,47 +1416,46 @@ remove_trailing_dots(const char *name) {
 void
 resolv_query(const char *name)
 {
-  static uint8_t i;
-
-  static uint8_t lseq, lseqi;
+  register struct namemap *nameptr;
 
-  register struct namemap *nameptr = 0;
+#if RESOLV_CONF_SUPPORTS_MDNS
+  uint8_t is_probe;
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
 
   init();
-  
-  lseq = lseqi = 0;
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
 
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-    if(0 == strcasecmp(nameptr->name, name)) {
-      break;
-    }
-    if((nameptr->state == STATE_UNUSED)
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-      || (nameptr->state == STATE_DONE && clock_seconds() > nameptr->expiration)
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+#if RESOLV_CONF_SUPPORTS_MDNS
+  is_probe = (mdns_state == MDNS_STATE_PROBING) &&
+             (0 == strcmp(name, resolv_hostname));
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+
+  nameptr = find_name(name);
+  if(nameptr != NULL &&
+     (nameptr->state == STATE_NEW || nameptr->state == STATE_ASKING)
+#if RESOLV_CONF_SUPPORTS_MDNS
+     && nameptr->is_probe == is_probe
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
     ) {
-      lseqi = i;
-      lseq = 255;
-    } else if(seqno - nameptr->seqno > lseq) {
-      lseq = seqno - nameptr->seqno;
-      lseqi = i;
-    }
+    /* A query for the name is already in flight; its answer will be
+       posted to everyone waiting for resolv_event_found. */
+    PRINTF("resolver: Query for \"%s\" already pending.\n", name);
+    return;
   }
 
-  if(i == RESOLV_ENTRIES) {
-    i = lseqi;
-    nameptr = &names[i];
+  if(nameptr == NULL) {
+    nameptr = free_entry(1);
   }
 
   PRINTF("resolver: Starting query for \"%s\".\n", name);
 
+  list_remove(pending, nameptr);
   memset(nameptr, 0, sizeof(*nameptr));
 
-  strncpy(nameptr->name, name, sizeof(nameptr->name));
+  strncpy(nameptr->name, name, sizeof(nameptr->name) - 1);
+  nameptr->hash = name_hash(nameptr->name);
   nameptr->state = STATE_NEW;
   nameptr->seqno = seqno;
   ++seqno;
@@ -1325,10 +1474,11 @@ resolv_query(const char *name)
       nameptr->is_mdns = 0;
     }
   }
-  nameptr->is_probe = (mdns_state == MDNS_STATE_PROBING) &&
-                      (0 == strcmp(nameptr->name, resolv_hostname));
+  nameptr->is_probe = is_probe;
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
 
+  schedule(nameptr, 0);
+
   /* Force check_entires() to run on our process. */
   process_post(&resolv_process, PROCESS_EVENT_TIMER, 0);
 }
@@ -1347,15 +1497,13 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
 {
   resolv_status_t ret = RESOLV_STATUS_UNCACHED;
 
-  static uint8_t i;
-
   struct namemap *nameptr;
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
 
 #if UIP_CONF_LOOPBACK_INTERFACE
-  if(strcmp(name, "localhost")) {
+  if(strcmp(name, "localhost") == 0) {
     static uip_ipaddr_t loopback =
 #if NETSTACK_CONF_WITH_IPV6
     { { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -1370,42 +1518,35 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
   }
 #endif /* UIP_CONF_LOOPBACK_INTERFACE */
 
-  /* Walk through the list to see if the name is in there. */
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-
-    if(strcasecmp(name, nameptr->name) == 0) {
-      switch (nameptr->state) {
-      case STATE_DONE:
-        ret = RESOLV_STATUS_CACHED;
+  nameptr = find_name(name);
+  if(nameptr != NULL) {
+    switch (nameptr->state) {
+    case STATE_DONE:
+      ret = RESOLV_STATUS_CACHED;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_EXPIRED;
-        }
+      if(clock_seconds() > nameptr->expiration) {
+        ret = RESOLV_STATUS_EXPIRED;
+      }
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
-      case STATE_NEW:
-      case STATE_ASKING:
-        ret = RESOLV_STATUS_RESOLVING;
-        break;
-      /* Almost certainly a not-found error from server */
-      case STATE_ERROR:
-        ret = RESOLV_STATUS_NOT_FOUND;
+      break;
+    case STATE_NEW:
+    case STATE_ASKING:
+      ret = RESOLV_STATUS_RESOLVING;
+      break;
+    /* Almost certainly a not-found error from server */
+    case STATE_ERROR:
+      ret = RESOLV_STATUS_NOT_FOUND;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_UNCACHED;
-        }
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
-      }
-
-      if(ipaddr) {
-        *ipaddr = &nameptr->ipaddr;
+      if(clock_seconds() > nameptr->expiration) {
+        ret = RESOLV_STATUS_UNCACHED;
       }
-
-      /* Break out of for loop. */
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
       break;
     }
+
+    if(ipaddr) {
+      *ipaddr = &nameptr->ipaddr;
+    }
   }
 
 #if VERBOSE_DEBUG
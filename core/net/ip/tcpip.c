@@ -41,6 +41,8 @@
 #include "contiki-net.h"
 #include "net/ip/uip-split.h"
 #include "net/ip/uip-packetqueue.h"
+#include "net/ip/uip-pkt.h"
+#include "sys/trace.h"
 
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-nd6.h"
@@ -80,6 +82,14 @@ process_event_t tcpip_icmp6_event;
 /* Periodic check of active connections. */
 static struct etimer periodic;
 
+#if NETSTACK_CONF_WITH_IPV6
+/* Packets handed to tcpip_ipv6_output() while it was already sending
+   one, e.g. from a MAC callback or by a protocol reacting to the
+   packet being sent. They are sent when the outer call is done. */
+LIST(output_queue);
+static uint8_t output_busy;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
 #if NETSTACK_CONF_WITH_IPV6 && UIP_CONF_IPV6_REASSEMBLY
 /* Timer for reassembly. */
 extern struct etimer uip_reass_timer;
@@ -528,6 +538,7 @@ eventhandler(process_event_t ev, process_data_t data)
 void
 tcpip_input(void)
 {
+  TRACE(TRACE_MODULE_IP, TRACE_EVENT_IN, uip_len);
   process_post_synch(&tcpip_process, PACKET_INPUT, NULL);
   uip_len = 0;
 #if NETSTACK_CONF_WITH_IPV6
@@ -536,15 +547,41 @@ tcpip_input(void)
 }
 /*---------------------------------------------------------------------------*/
 #if NETSTACK_CONF_WITH_IPV6
-void
-tcpip_ipv6_output(void)
+#if UIP_CONF_IPV6_QUEUE_PKT
+/* Copies the packet in uip_buf to the back of the neighbor's queue,
+   to be sent once address resolution is done. */
+static int
+queue_packet(uip_ds6_nbr_t *nbr)
+{
+  struct uip_packetqueue_packet *p;
+
+  if(uip_len > sizeof(p->queue_buf)) {
+    return 0;
+  }
+  p = uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
+  if(p == NULL) {
+    PRINTF("tcpip_ipv6_output: neighbor queue full, dropping\n");
+    return 0;
+  }
+  memcpy(p->queue_buf, UIP_IP_BUF, uip_len);
+  p->queue_buf_len = uip_len;
+  UIP_STAT(++uip_stat.nd6.queued);
+  return 1;
+}
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends the packet in uip_buf. On return, uip_buf is either empty or
+ * holds a packet that was generated in place of the one sent, such
+ * as a neighbor solicitation for an unresolved next hop.
+ */
+static void
+output_packet(void)
 {
   uip_ds6_nbr_t *nbr = NULL;
   uip_ipaddr_t *nexthop;
 
-  if(uip_len == 0) {
-    return;
-  }
+  TRACE(TRACE_MODULE_IP, TRACE_EVENT_OUT, uip_len);
 
   if(uip_len > UIP_LINK_MTU) {
     UIP_LOG("tcpip_ipv6_output: Packet to big");
@@ -621,6 +658,7 @@ tcpip_ipv6_output(void)
 
           /* We don't have a nexthop to send the packet to, so we drop
              it. */
+          uip_len = 0;
           return;
         }
       }
@@ -656,10 +694,7 @@ tcpip_ipv6_output(void)
       } else {
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        queue_packet(nbr);
 #endif
       /* RFC4861, 7.2.2:
        * "If the source address of the packet prompting the solicitation is the
@@ -675,8 +710,14 @@ tcpip_ipv6_output(void)
 
         stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
         nbr->nscount = 1;
+        uip_ds6_wakeup_stimer(&nbr->sendns);
+        /* The solicitation has replaced the packet in uip_buf and is
+           sent by tcpip_ipv6_output() on its next round. */
+        return;
       }
 #endif /* UIP_ND6_SEND_NA */
+      uip_len = 0;
+      return;
     } else {
 #if UIP_ND6_SEND_NA
       if(nbr->state == NBR_INCOMPLETE) {
@@ -684,10 +725,7 @@ tcpip_ipv6_output(void)
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* Copy outgoing pkt in the queuing buffer for later transmit and set
            the destination nbr to nbr. */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        queue_packet(nbr);
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
         uip_len = 0;
         return;
@@ -698,37 +736,77 @@ tcpip_ipv6_output(void)
         nbr->state = NBR_DELAY;
         stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
         nbr->nscount = 0;
+        uip_ds6_wakeup_stimer(&nbr->reachable);
         PRINTF("tcpip_ipv6_output: nbr cache entry stale moving to delay\n");
       }
 #endif /* UIP_ND6_SEND_NA */
 
-      tcpip_output(uip_ds6_nbr_get_ll(nbr));
-
 #if UIP_CONF_IPV6_QUEUE_PKT
       /*
-       * Send the queued packets from here, may not be 100% perfect though.
-       * This happens in a few cases, for example when instead of receiving a
-       * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
-       * to STALE, and you must both send a NA and the queued packet.
+       * Packets can still be queued here, for example when instead of
+       * receiving a NA after sending a NS, you receive a NS with SLLAO:
+       * the entry moves to STALE, and you must both send a NA and the
+       * queued packets. The queued packets are older, so this one goes
+       * to the back of the queue if there is room for it.
        */
-      if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-        uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-        memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-        uip_packetqueue_free(&nbr->packethandle);
-        tcpip_output(uip_ds6_nbr_get_ll(nbr));
+      if(uip_packetqueue_buflen(&nbr->packethandle) != 0 &&
+         queue_packet(nbr)) {
+        uip_ds6_nbr_send_queued(nbr);
+        return;
       }
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
 
+      tcpip_output(uip_ds6_nbr_get_ll(nbr));
+
+#if UIP_CONF_IPV6_QUEUE_PKT
+      uip_ds6_nbr_send_queued(nbr);
+#endif /*UIP_CONF_IPV6_QUEUE_PKT*/
+
       uip_len = 0;
       return;
     }
-    return;
   }
   /* Multicast IP destination address. */
   tcpip_output(NULL);
   uip_len = 0;
   uip_ext_len = 0;
 }
+/*---------------------------------------------------------------------------*/
+void
+tcpip_ipv6_output(void)
+{
+  struct uip_pkt *pkt;
+
+  if(uip_len == 0) {
+    return;
+  }
+
+  if(output_busy) {
+    /* We are called from within the sending of another packet. Park
+       this one rather than overwrite the buffers still in use. */
+    pkt = uip_pkt_save();
+    if(pkt == NULL) {
+      UIP_LOG("tcpip_ipv6_output: no packet buffer, dropping");
+      uip_len = 0;
+      uip_ext_len = 0;
+      return;
+    }
+    list_add(output_queue, pkt);
+    return;
+  }
+
+  output_busy = 1;
+  do {
+    output_packet();
+    if(uip_len == 0) {
+      pkt = list_pop(output_queue);
+      if(pkt != NULL) {
+        uip_pkt_restore(pkt);
+      }
+    }
+  } while(uip_len > 0);
+  output_busy = 0;
+}
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 /*---------------------------------------------------------------------------*/
 #if UIP_UDP
@@ -812,6 +890,9 @@ PROCESS_THREAD(tcpip_process, ev, data)
   tcpip_icmp6_event = process_alloc_event();
 #endif /* UIP_CONF_ICMP6 */
   etimer_set(&periodic, CLOCK_SECOND / 2);
+#if NETSTACK_CONF_WITH_IPV6
+  list_init(output_queue);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
 
   uip_init();
 #ifdef UIP_FALLBACK_INTERFACE
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         The Internet checksum accumulator shared by uIP and IP64,
+ *         and RFC 1624 incremental checksum updates.
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+#include "net/ip/uip.h"
+
+/* Use SSE2 or NEON to sum the bulk of a buffer when the compiler
+   targets a little-endian host that has them. */
+#ifdef UIP_CONF_CHKSUM_SIMD
+#define UIP_CHKSUM_SIMD UIP_CONF_CHKSUM_SIMD
+#else
+#define UIP_CHKSUM_SIMD 1
+#endif
+
+#if UIP_CHKSUM_SIMD && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CHKSUM_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CHKSUM_NEON 1
+#endif
+#endif
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+fold(uint32_t sum)
+{
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)sum;
+}
+/*---------------------------------------------------------------------------*/
+#if CHKSUM_SSE2 || CHKSUM_NEON
+/*
+ * Sums the 16-byte blocks at the start of the buffer as little-endian
+ * words. Each 32-bit lane receives two words per block, so the lanes
+ * cannot overflow for buffers up to 64 kbytes. Returns the folded sum
+ * in network byte order, which the caller adds to its own big-endian
+ * sum after swapping the bytes (RFC 1071, section 2).
+ */
+static uint16_t
+sum_blocks(const uint8_t *data, uint16_t blocks)
+{
+  uint32_t lanes[4];
+  uint32_t sum;
+#if CHKSUM_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  __m128i v;
+
+  for(; blocks > 0; blocks--, data += 16) {
+    v = _mm_loadu_si128((const __m128i *)data);
+    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+    acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+  }
+  _mm_storeu_si128((__m128i *)lanes, acc);
+#else /* CHKSUM_SSE2 */
+  uint32x4_t acc = vdupq_n_u32(0);
+
+  for(; blocks > 0; blocks--, data += 16) {
+    acc = vpadalq_u16(acc, vreinterpretq_u16_u8(vld1q_u8(data)));
+  }
+  vst1q_u32(lanes, acc);
+#endif /* CHKSUM_SSE2 */
+
+  sum = fold(lanes[0]) + fold(lanes[1]) + fold(lanes[2]) + fold(lanes[3]);
+  return fold(sum);
+}
+#endif /* CHKSUM_SSE2 || CHKSUM_NEON */
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_add(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  /* At most 32768 words of 16 bits each are added, so a 32-bit
+     accumulator needs no carry handling inside the loops. */
+  uint32_t acc = sum;
+
+#if CHKSUM_SSE2 || CHKSUM_NEON
+  if(len >= 64) {
+    uint16_t s = sum_blocks(data, len >> 4);
+
+    acc += (uint16_t)((s << 8) | (s >> 8));
+    data += len & ~15;
+    len &= 15;
+  }
+#endif /* CHKSUM_SSE2 || CHKSUM_NEON */
+
+  while(len >= 8) {
+    acc += ((uint16_t)data[0] << 8) + data[1];
+    acc += ((uint16_t)data[2] << 8) + data[3];
+    acc += ((uint16_t)data[4] << 8) + data[5];
+    acc += ((uint16_t)data[6] << 8) + data[7];
+    data += 8;
+    len -= 8;
+  }
+  while(len >= 2) {
+    acc += ((uint16_t)data[0] << 8) + data[1];
+    data += 2;
+    len -= 2;
+  }
+  if(len > 0) {
+    acc += (uint16_t)data[0] << 8;
+  }
+
+  /* Return sum in host byte order. */
+  return fold(acc);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_update(uint16_t chksum, uint16_t old_sum, uint16_t new_sum)
+{
+  uint32_t acc;
+
+  /* RFC 1624, equation 3: HC' = ~(~HC + ~m + m'). */
+  acc = (uint16_t)~uip_ntohs(chksum);
+  acc += (uint16_t)~old_sum;
+  acc += new_sum;
+
+  return uip_htons((uint16_t)~fold(acc));
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -1,13 +1,13 @@
 #include <stdio.h>
 
+#include "contiki.h"
 #include "net/ip/uip.h"
 
 #include "lib/memb.h"
 
 #include "net/ip/uip-packetqueue.h"
 
-#define MAX_NUM_QUEUED_PACKETS 2
-MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
+MEMB(packets_memb, struct uip_packetqueue_packet, UIP_PACKETQUEUE_BUFFERS);
 
 #define DEBUG 0
 #if DEBUG
@@ -21,66 +21,77 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue_free timed out %p\n", p->handle);
+  list_remove(p->handle->packets, p);
+  memb_free(&packets_memb, p);
+#if NETSTACK_CONF_WITH_IPV6
+  UIP_STAT(++uip_stat.nd6.expired);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_new(struct uip_packetqueue_handle *handle)
 {
   PRINTF("uip_packetqueue_new %p\n", handle);
-  handle->packet = NULL;
+  LIST_STRUCT_INIT(handle, packets);
 }
 /*---------------------------------------------------------------------------*/
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
 {
+  struct uip_packetqueue_packet *p;
+
   PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
+  if(list_length(handle->packets) >= UIP_PACKETQUEUE_MAX_PER_HANDLE) {
+    PRINTF("queue full\n");
     return NULL;
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
-  } else {
+  p = memb_alloc(&packets_memb);
+  if(p == NULL) {
     PRINTF("uip_packetqueue_alloc failed\n");
+    return NULL;
   }
-  return handle->packet;
+  p->handle = handle;
+  p->queue_buf_len = 0;
+  ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+  list_add(handle->packets, p);
+  return p;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
+  struct uip_packetqueue_packet *p;
+
   PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  p = list_pop(handle->packets);
+  if(p != NULL) {
+    ctimer_stop(&p->lifetimer);
+    memb_free(&packets_memb, p);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_packetqueue_flush(struct uip_packetqueue_handle *handle)
+{
+  while(list_head(handle->packets) != NULL) {
+    uip_packetqueue_free(handle);
   }
 }
 /*---------------------------------------------------------------------------*/
 uint8_t *
 uip_packetqueue_buf(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf: NULL;
+  struct uip_packetqueue_packet *p = list_head(h->packets);
+  return p != NULL? p->queue_buf: NULL;
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
 uip_packetqueue_buflen(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf_len: 0;
-}
-/*---------------------------------------------------------------------------*/
-void
-uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
-{
-  if(h->packet != NULL) {
-    h->packet->queue_buf_len = len;
-  }
+  struct uip_packetqueue_packet *p = list_head(h->packets);
+  return p != NULL? p->queue_buf_len: 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -2,34 +2,56 @@
 #define UIP_PACKETQUEUE_H
 
 #include "sys/ctimer.h"
+#include "lib/list.h"
+
+/* Number of packet buffers shared by all queues. */
+#ifdef UIP_CONF_PACKETQUEUE_BUFFERS
+#define UIP_PACKETQUEUE_BUFFERS UIP_CONF_PACKETQUEUE_BUFFERS
+#else /* UIP_CONF_PACKETQUEUE_BUFFERS */
+#define UIP_PACKETQUEUE_BUFFERS 2
+#endif /* UIP_CONF_PACKETQUEUE_BUFFERS */
+
+/* Maximum number of packets a single queue may hold, so that one
+   unresponsive neighbor cannot take the whole pool. */
+#ifdef UIP_CONF_PACKETQUEUE_MAX_PER_HANDLE
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE UIP_CONF_PACKETQUEUE_MAX_PER_HANDLE
+#else /* UIP_CONF_PACKETQUEUE_MAX_PER_HANDLE */
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE 2
+#endif /* UIP_CONF_PACKETQUEUE_MAX_PER_HANDLE */
 
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
+  struct uip_packetqueue_packet *next;
   uint8_t queue_buf[UIP_BUFSIZE - UIP_LLH_LEN];
   uint16_t queue_buf_len;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
+/* A FIFO of packets, oldest first. */
 struct uip_packetqueue_handle {
-  struct uip_packetqueue_packet *packet;
+  LIST_STRUCT(packets);
 };
 
 void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
-
+/* Appends an empty packet to the queue. Returns NULL if the queue is
+   full or the pool is exhausted. The packet is dropped if it is still
+   queued when the lifetime expires. */
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
 
-
+/* Frees the oldest packet in the queue. */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/* Frees all packets in the queue. */
+void uip_packetqueue_flush(struct uip_packetqueue_handle *handle);
+
+/* The oldest packet in the queue. */
 uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
-void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
 
 
 #endif /* UIP_PACKETQUEUE_H */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Packet descriptors for parking packets outside uip_buf.
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+#include "contiki.h"
+#include "net/ip/uip-pkt.h"
+#include "lib/memb.h"
+
+#include <string.h>
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+#if UIP_PKT_BUFFERS > 0
+MEMB(pkt_memb, struct uip_pkt, UIP_PKT_BUFFERS);
+#endif /* UIP_PKT_BUFFERS > 0 */
+
+/*---------------------------------------------------------------------------*/
+struct uip_pkt *
+uip_pkt_save(void)
+{
+#if UIP_PKT_BUFFERS > 0
+  struct uip_pkt *pkt;
+
+  if(uip_len > sizeof(pkt->buf)) {
+    return NULL;
+  }
+  pkt = memb_alloc(&pkt_memb);
+  if(pkt == NULL) {
+    PRINTF("uip-pkt: no free descriptor for %u bytes\n", uip_len);
+    return NULL;
+  }
+  pkt->len = uip_len;
+#if NETSTACK_CONF_WITH_IPV6
+  pkt->ext_len = uip_ext_len;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  memcpy(pkt->buf, &uip_buf[UIP_LLH_LEN], uip_len);
+  uip_len = 0;
+#if NETSTACK_CONF_WITH_IPV6
+  uip_ext_len = 0;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  return pkt;
+#else /* UIP_PKT_BUFFERS > 0 */
+  return NULL;
+#endif /* UIP_PKT_BUFFERS > 0 */
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_pkt_restore(struct uip_pkt *pkt)
+{
+  uip_len = pkt->len;
+#if NETSTACK_CONF_WITH_IPV6
+  uip_ext_len = pkt->ext_len;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  memcpy(&uip_buf[UIP_LLH_LEN], pkt->buf, pkt->len);
+  uip_pkt_free(pkt);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_pkt_free(struct uip_pkt *pkt)
+{
+#if UIP_PKT_BUFFERS > 0
+  memb_free(&pkt_memb, pkt);
+#endif /* UIP_PKT_BUFFERS > 0 */
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
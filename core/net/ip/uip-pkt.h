@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Packet descriptors: a small pool of packet buffers that a
+ *         packet can be parked in while uip_buf is used for something
+ *         else.
+ */
+
+/**
+ * \addtogroup uip
+ * @{
+ */
+
+#ifndef UIP_PKT_H_
+#define UIP_PKT_H_
+
+#include "net/ip/uip.h"
+
+/**
+ * Number of packet descriptors. Each one holds a full uIP packet, so
+ * the pool is disabled by default. Without it, tcpip_ipv6_output()
+ * drops a packet that is sent while another one is being sent. A
+ * border router that forwards and originates traffic at the same
+ * time benefits from one or a few.
+ */
+#ifdef UIP_CONF_PKT_BUFFERS
+#define UIP_PKT_BUFFERS UIP_CONF_PKT_BUFFERS
+#else /* UIP_CONF_PKT_BUFFERS */
+#define UIP_PKT_BUFFERS 0
+#endif /* UIP_CONF_PKT_BUFFERS */
+
+/**
+ * A packet that has been moved out of uip_buf. The descriptor
+ * belongs to whoever holds the pointer; handing the pointer to
+ * another layer hands over the packet with it.
+ */
+struct uip_pkt {
+  struct uip_pkt *next;
+  uint16_t len;
+  uint8_t ext_len;
+  uint8_t buf[UIP_BUFSIZE - UIP_LLH_LEN];
+};
+
+/**
+ * \brief      Move the packet in uip_buf into a descriptor
+ * \return     The descriptor, or NULL if the pool is exhausted
+ *
+ *             On success, uip_len and uip_ext_len are cleared so that
+ *             uip_buf can be used for the next packet. On failure,
+ *             uip_buf is left untouched.
+ */
+struct uip_pkt *uip_pkt_save(void);
+
+/**
+ * \brief      Move a packet back into uip_buf and free its descriptor
+ * \param pkt  The descriptor, as returned by uip_pkt_save()
+ *
+ *             Whatever uip_buf held before is overwritten.
+ */
+void uip_pkt_restore(struct uip_pkt *pkt);
+
+/**
+ * \brief      Drop a packet and return its descriptor to the pool
+ * \param pkt  The descriptor, as returned by uip_pkt_save()
+ */
+void uip_pkt_free(struct uip_pkt *pkt);
+
+#endif /* UIP_PKT_H_ */
+
+/** @} */
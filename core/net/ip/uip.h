@@ -1503,6 +1503,12 @@ struct uip_stats {
     uip_stats_t drop;     /**< Number of dropped ND6 packets. */
     uip_stats_t recv;     /**< Number of recived ND6 packets */
     uip_stats_t sent;     /**< Number of sent ND6 packets */
+    uip_stats_t queued;   /**< Number of packets queued during
+			     address resolution */
+    uip_stats_t flushed;  /**< Number of queued packets sent once
+			     the neighbor was resolved */
+    uip_stats_t expired;  /**< Number of queued packets dropped
+			     because resolution took too long */
   } nd6;
 #endif /*NETSTACK_CONF_WITH_IPV6*/
 };
@@ -2186,6 +2192,39 @@ CCIF extern uip_lladdr_t uip_lladdr;
  */
 uint16_t uip_chksum(uint16_t *data, uint16_t len);
 
+/**
+ * Add a buffer to a partial Internet checksum.
+ *
+ * The buffer is summed as big-endian 16-bit words, and an odd
+ * trailing byte is padded with zero. Only the last buffer added to
+ * a sum may have an odd length.
+ *
+ * \param sum The partial sum so far, in host byte order.
+ *
+ * \param data A pointer to the buffer.
+ *
+ * \param len The length of the buffer.
+ *
+ * \return The one's complement sum, in host byte order.
+ */
+uint16_t uip_chksum_add(uint16_t sum, const uint8_t *data, uint16_t len);
+
+/**
+ * Incrementally update a checksum after part of the data it covers
+ * has changed (RFC 1624).
+ *
+ * \param chksum The checksum field as found in the packet, in
+ * network byte order.
+ *
+ * \param old_sum The uip_chksum_add() sum of the old contents of the
+ * changed fields.
+ *
+ * \param new_sum The uip_chksum_add() sum of their new contents.
+ *
+ * \return The new value of the checksum field, in network byte order.
+ */
+uint16_t uip_chksum_update(uint16_t chksum, uint16_t old_sum, uint16_t new_sum);
+
 /**
  * Calculate the IP header checksum of the packet header in uip_buf.
  *
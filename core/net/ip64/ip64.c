@@ -269,42 +269,11 @@ ip64_set_ipv6_address(const uip_ip6addr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 static uint16_t
-chksum(uint16_t sum, const uint8_t *data, uint16_t len)
-{
-  uint16_t t;
-  const uint8_t *dataptr;
-  const uint8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-
-  while(dataptr < last_byte) {	/* At least two more bytes */
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-    dataptr += 2;
-  }
-
-  if(dataptr == last_byte) {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-  }
-
-  /* Return sum in host byte order. */
-  return sum;
-}
-/*---------------------------------------------------------------------------*/
-static uint16_t
 ipv4_checksum(struct ipv4_hdr *hdr)
 {
   uint16_t sum;
 
-  sum = chksum(0, (uint8_t *)hdr, IPV4_HDRLEN);
+  sum = uip_chksum_add(0, (uint8_t *)hdr, IPV4_HDRLEN);
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
@@ -323,14 +292,14 @@ ipv4_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
     /* IP protocol and length fields. This addition cannot carry. */
     sum = transport_layer_len + proto;
     /* Sum IP source and destination addresses. */
-    sum = chksum(sum, (uint8_t *)&v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
+    sum = uip_chksum_add(sum, (uint8_t *)&v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t));
   } else {
     /* ping replies' checksums are calculated over the icmp-part only */
     sum = 0;
   }
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV4_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV4_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
@@ -349,15 +318,39 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   /* IP protocol and length fields. This addition cannot carry. */
   sum = transport_layer_len + proto;
   /* Sum IP source and destination addresses. */
-  sum = chksum(sum, (uint8_t *)&v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
-  sum = chksum(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, (uint8_t *)&v6hdr->srcipaddr, sizeof(uip_ip6addr_t));
+  sum = uip_chksum_add(sum, (uint8_t *)&v6hdr->destipaddr, sizeof(uip_ip6addr_t));
 
   /* Sum transport layer header and data. */
-  sum = chksum(sum, &packet[IPV6_HDRLEN], transport_layer_len);
+  sum = uip_chksum_add(sum, &packet[IPV6_HDRLEN], transport_layer_len);
 
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Updates a TCP or UDP checksum that was computed over the original
+ * packet. Translation replaces the addresses of the pseudo-header and
+ * may rewrite one port number, but leaves the protocol, length and
+ * payload as they were, so the checksum can be adjusted for the
+ * changed words instead of being recomputed (RFC 1624).
+ */
+static uint16_t
+translate_transport_checksum(uint16_t chksum,
+                             const void *old_addrs, uint16_t old_len,
+                             const void *new_addrs, uint16_t new_len,
+                             uint16_t old_port, uint16_t new_port)
+{
+  uint16_t old_sum, new_sum;
+
+  old_sum = uip_chksum_add(uip_ntohs(old_port), old_addrs, old_len);
+  new_sum = uip_chksum_add(uip_ntohs(new_port), new_addrs, new_len);
+  chksum = uip_chksum_update(chksum, old_sum, new_sum);
+
+  /* Zero means "no checksum" for UDP over IPv4 and is not allowed for
+     UDP over IPv6. It is the same one's complement value as 0xffff. */
+  return (chksum == 0) ? 0xffff : chksum;
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
@@ -369,6 +362,7 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv6len, ipv4len;
+  uint16_t ipv6port;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)ipv6packet;
@@ -391,6 +385,7 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   tcphdr = (struct tcp_hdr *)&resultpacket[IPV4_HDRLEN];
   icmpv4hdr = (struct icmpv4_hdr *)&resultpacket[IPV4_HDRLEN];
   icmpv6hdr = (struct icmpv6_hdr *)&ipv6packet[IPV6_HDRLEN];
+  ipv6port = udphdr->srcport;
 
   /* Translate the IPv6 header into an IPv4 header. */
 
@@ -425,13 +420,14 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
 
-    /* Compute and check the TCP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if DEBUG
+    /* The checksum is updated incrementally below, which keeps a bad
+       checksum bad, so this check is only informative. */
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_TCP) != 0xffff) {
-      PRINTF("Bad TCP checksum, dropping packet\n");
+      PRINTF("Bad TCP checksum\n");
     }
+#endif /* DEBUG */
 
     break;
 
@@ -447,13 +443,12 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
                       (uint8_t *)udphdr + sizeof(struct udp_hdr),
                       BUFSIZE - IPV4_HDRLEN - sizeof(struct udp_hdr));
     }
-    /* Compute and check the UDP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if DEBUG
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_UDP) != 0xffff) {
-      PRINTF("Bad UDP checksum, dropping packet\n");
+      PRINTF("Bad UDP checksum\n");
     }
+#endif /* DEBUG */
     break;
 
   case IP_PROTO_ICMPV6:
@@ -619,16 +614,27 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
      field. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_checksum(tcphdr->tcpchksum,
+                                   &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                   &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                   ipv6port, tcphdr->srcport);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_UDP));
-    if(udphdr->udpchksum == 0) {
-      udphdr->udpchksum = 0xffff;
+    if(udphdr->destport == UIP_HTONS(DNS_PORT)) {
+      /* The DNS64 module has rewritten the payload. */
+      udphdr->udpchksum = 0;
+      udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
+                                                    IP_PROTO_UDP));
+      if(udphdr->udpchksum == 0) {
+        udphdr->udpchksum = 0xffff;
+      }
+    } else {
+      udphdr->udpchksum =
+        translate_transport_checksum(udphdr->udpchksum,
+                                     &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                     &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                     ipv6port, udphdr->srcport);
     }
     break;
   case IP_PROTO_ICMPV4:
@@ -658,6 +664,7 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv4len, ipv6len, ipv6_packet_len;
+  uint16_t ipv4port;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)resultpacket;
@@ -689,6 +696,7 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   tcphdr = (struct tcp_hdr *)&resultpacket[IPV6_HDRLEN];
   icmpv4hdr = (struct icmpv4_hdr *)&ipv4packet[IPV4_HDRLEN];
   icmpv6hdr = (struct icmpv6_hdr *)&resultpacket[IPV6_HDRLEN];
+  ipv4port = udphdr->destport;
 
   ipv6len = ipv4len - IPV4_HDRLEN + IPV6_HDRLEN;
   ipv6_packet_len = ipv6len - IPV6_HDRLEN;
@@ -854,18 +862,29 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_TCP));
+    tcphdr->tcpchksum =
+      translate_transport_checksum(tcphdr->tcpchksum,
+                                   &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                   &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                   ipv4port, tcphdr->destport);
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_UDP));
-    if(udphdr->udpchksum == 0) {
-      udphdr->udpchksum = 0xffff;
+    if(udphdr->srcport == UIP_HTONS(DNS_PORT) || udphdr->udpchksum == 0) {
+      /* The DNS64 module has rewritten the payload, or the sender did
+         not compute a checksum, which IPv6 requires. */
+      udphdr->udpchksum = 0;
+      udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
+                                                    ipv6len,
+                                                    IP_PROTO_UDP));
+      if(udphdr->udpchksum == 0) {
+        udphdr->udpchksum = 0xffff;
+      }
+    } else {
+      udphdr->udpchksum =
+        translate_transport_checksum(udphdr->udpchksum,
+                                     &v4hdr->srcipaddr, 2 * sizeof(uip_ip4addr_t),
+                                     &v6hdr->srcipaddr, 2 * sizeof(uip_ip6addr_t),
+                                     ipv4port, udphdr->destport);
     }
     break;
 
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Generic Header Compression (RFC 7400)
+ *
+ *         GHC is a small LZ77 style compressor. The compressed data
+ *         is a bytecode that appends literal bytes, runs of zeros, or
+ *         copies of data that was output before. The output is
+ *         preceded by a dictionary made of the IPv6 pseudo-header,
+ *         so addresses and prefixes that are repeated in the payload
+ *         (e.g. in RPL or ND options) compress well.
+ */
+
+/**
+ * \addtogroup sicslowpan
+ * @{
+ */
+
+#include "net/ipv6/sicslowpan-ghc.h"
+
+#include <string.h>
+
+/* 0kkkkkkk: append the next k bytes, k < 96 */
+#define GHC_APPEND_MAX      95
+/* 1000nnnn: append n + 2 zeros */
+#define GHC_ZEROS           0x80
+#define GHC_ZEROS_MAX       17
+/* 10010000: end of the compressed data */
+#define GHC_STOP            0x90
+/* 101nssss: extend the next backreference, na += n << 3, sa += s << 3 */
+#define GHC_EXTEND          0xa0
+#define GHC_EXTEND_N        0x10
+#define GHC_EXTEND_S_MAX    15
+/* 11nnnkkk: copy na + n + 2 bytes from sa + k + n bytes back */
+#define GHC_BACKREF         0xc0
+
+#define DICT_LEN            SICSLOWPAN_GHC_DICT_LEN
+#define DICT_HOLE_START     SICSLOWPAN_GHC_DICT_LEN_OFFSET
+#define DICT_HOLE_END       (SICSLOWPAN_GHC_DICT_LEN_OFFSET + \
+                             SICSLOWPAN_GHC_DICT_LEN_SIZE)
+
+/* Static part of the dictionary, mostly DTLS record headers */
+static const uint8_t static_dict[16] = {
+  0x16, 0xfe, 0xfd, 0x17, 0xfe, 0xfd, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00
+};
+
+/* Byte i of the dictionary followed by the data */
+#define WINDOW(dict, data, i) \
+  ((i) < DICT_LEN ? (dict)[i] : (data)[(i) - DICT_LEN])
+/*---------------------------------------------------------------------------*/
+void
+sicslowpan_ghc_dict(uint8_t *dict, const uip_ipaddr_t *src,
+                    const uip_ipaddr_t *dest, uint8_t next_header)
+{
+  memcpy(dict, src, sizeof(uip_ipaddr_t));
+  memcpy(dict + 16, dest, sizeof(uip_ipaddr_t));
+  memset(dict + DICT_HOLE_START, 0, 7);
+  dict[39] = next_header;
+  memcpy(dict + 40, static_dict, sizeof(static_dict));
+}
+/*---------------------------------------------------------------------------*/
+/* Number of extension codes needed by a backreference */
+static uint16_t
+extensions(uint16_t n, uint16_t s)
+{
+  uint16_t na, sa;
+
+  na = (n - 2) >> 3;
+  sa = (((s - n) >> 3) + GHC_EXTEND_S_MAX - 1) / GHC_EXTEND_S_MAX;
+  return na > sa ? na : sa;
+}
+/*---------------------------------------------------------------------------*/
+int
+sicslowpan_ghc_compress(const uint8_t *dict, const uint8_t *data,
+                        uint16_t len, uint8_t *out, uint16_t out_max)
+{
+  uint16_t pos, lit, o, end, j, n, limit;
+  uint16_t best_len, best_cost, best_s, cost;
+  uint16_t na, sa, k;
+
+  o = 0;
+  lit = 0;
+  pos = 0;
+  while(pos < len) {
+    /* A run of zeros */
+    best_len = 0;
+    best_cost = 0;
+    best_s = 0;
+    while(pos + best_len < len && best_len < GHC_ZEROS_MAX &&
+          data[pos + best_len] == 0) {
+      best_len++;
+    }
+    if(best_len >= 2) {
+      best_cost = 1;
+    } else {
+      best_len = 0;
+    }
+
+    /* The longest earlier occurrence, payload length excepted */
+    end = DICT_LEN + pos;
+    for(j = 0; j + 2 <= end && pos + 2 <= len; j++) {
+      if(j >= DICT_HOLE_START && j < DICT_HOLE_END) {
+        continue;
+      }
+      limit = len - pos;
+      if(limit > end - j) {
+        limit = end - j;
+      }
+      if(j < DICT_HOLE_START && limit > DICT_HOLE_START - j) {
+        limit = DICT_HOLE_START - j;
+      }
+      if(limit < 2 ||
+         WINDOW(dict, data, j) != data[pos] ||
+         WINDOW(dict, data, j + 1) != data[pos + 1]) {
+        continue;
+      }
+      for(n = 2; n < limit && WINDOW(dict, data, j + n) == data[pos + n]; n++);
+      cost = 1 + extensions(n, end - j);
+      if((int)n - (int)cost > (int)best_len - (int)best_cost) {
+        best_len = n;
+        best_cost = cost;
+        best_s = end - j;
+      }
+    }
+
+    if(best_len <= best_cost) {
+      /* Nothing better than a literal byte */
+      pos++;
+      if(pos - lit < GHC_APPEND_MAX && pos < len) {
+        continue;
+      }
+    }
+
+    /* Flush the pending literal bytes */
+    if(pos > lit) {
+      k = pos - lit;
+      if(o + 1 + k > out_max) {
+        return -1;
+      }
+      out[o++] = k;
+      memcpy(out + o, data + lit, k);
+      o += k;
+      lit = pos;
+    }
+    if(best_len <= best_cost) {
+      continue;
+    }
+
+    if(o + best_cost > out_max) {
+      return -1;
+    }
+    if(best_s == 0) {
+      out[o++] = GHC_ZEROS | (best_len - 2);
+    } else {
+      na = (best_len - 2) >> 3;
+      sa = (best_s - best_len) >> 3;
+      while(na > 0 || sa > 0) {
+        k = sa > GHC_EXTEND_S_MAX ? GHC_EXTEND_S_MAX : sa;
+        out[o++] = GHC_EXTEND | (na > 0 ? GHC_EXTEND_N : 0) | k;
+        sa -= k;
+        if(na > 0) {
+          na--;
+        }
+      }
+      out[o++] = GHC_BACKREF | (((best_len - 2) & 7) << 3) |
+        ((best_s - best_len) & 7);
+    }
+    pos += best_len;
+    lit = pos;
+  }
+  return o;
+}
+/*---------------------------------------------------------------------------*/
+int
+sicslowpan_ghc_uncompress(const uint8_t *dict, const uint8_t *code,
+                          uint16_t code_len, uint8_t *out, uint16_t out_max)
+{
+  uint16_t i, o, n, s, na, sa, from;
+  uint8_t c;
+
+  o = 0;
+  na = 0;
+  sa = 0;
+  for(i = 0; i < code_len;) {
+    c = code[i++];
+    if(c <= GHC_APPEND_MAX) {
+      if(i + c > code_len || o + c > out_max) {
+        return -1;
+      }
+      memcpy(out + o, code + i, c);
+      i += c;
+      o += c;
+    } else if((c & 0xf0) == GHC_ZEROS) {
+      n = (c & 0x0f) + 2;
+      if(o + n > out_max) {
+        return -1;
+      }
+      memset(out + o, 0, n);
+      o += n;
+    } else if(c == GHC_STOP) {
+      break;
+    } else if((c & 0xe0) == GHC_EXTEND) {
+      if(c & GHC_EXTEND_N) {
+        na += 8;
+      }
+      sa += (c & 0x0f) << 3;
+    } else if((c & 0xc0) == GHC_BACKREF) {
+      n = na + ((c >> 3) & 7) + 2;
+      s = sa + (c & 7) + n;
+      if(s > DICT_LEN + o || o + n > out_max) {
+        return -1;
+      }
+      /* s >= n: the copy never overlaps what it writes */
+      from = DICT_LEN + o - s;
+      /* The payload length is not known until the data is
+         decompressed, so it cannot be copied */
+      if(from < DICT_HOLE_END && from + n > DICT_HOLE_START) {
+        return -1;
+      }
+      while(n-- > 0) {
+        out[o++] = WINDOW(dict, out, from);
+        from++;
+      }
+      na = 0;
+      sa = 0;
+    } else {
+      /* Reserved */
+      return -1;
+    }
+  }
+  return o;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
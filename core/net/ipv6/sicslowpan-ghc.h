@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for Generic Header Compression (RFC 7400)
+ */
+
+/**
+ * \addtogroup sicslowpan
+ * @{
+ */
+
+#ifndef SICSLOWPAN_GHC_H_
+#define SICSLOWPAN_GHC_H_
+
+#include "net/ip/uip.h"
+
+/**
+ * \name GHC dictionary
+ *
+ * The pre-set dictionary is the IPv6 pseudo-header of the packet
+ * followed by a static dictionary of 16 bytes. The payload length in
+ * the pseudo-header is not known to the decompressor until it is
+ * done, so it is left zero and never referred to by the compressor.
+ * Bytecode that copies any of its bytes is rejected.
+ * @{
+ */
+#define SICSLOWPAN_GHC_DICT_LEN         56
+#define SICSLOWPAN_GHC_DICT_LEN_OFFSET  32
+#define SICSLOWPAN_GHC_DICT_LEN_SIZE    4
+/** @} */
+
+/**
+ * \brief Set up the GHC dictionary of a packet
+ * \param dict Buffer of SICSLOWPAN_GHC_DICT_LEN bytes
+ * \param src The IPv6 source address of the packet
+ * \param dest The IPv6 destination address of the packet
+ * \param next_header The protocol of the compressed data
+ */
+void sicslowpan_ghc_dict(uint8_t *dict, const uip_ipaddr_t *src,
+                         const uip_ipaddr_t *dest, uint8_t next_header);
+
+/**
+ * \brief Compress data with GHC
+ * \param dict The dictionary, see sicslowpan_ghc_dict()
+ * \param data The data to compress
+ * \param len The length of the data
+ * \param out Where to write the GHC bytecode
+ * \param out_max The space available at out
+ * \return The length of the bytecode, or -1 if it needs more than
+ * out_max bytes
+ */
+int sicslowpan_ghc_compress(const uint8_t *dict, const uint8_t *data,
+                            uint16_t len, uint8_t *out, uint16_t out_max);
+
+/**
+ * \brief Decompress GHC bytecode
+ * \param dict The dictionary, see sicslowpan_ghc_dict()
+ * \param code The GHC bytecode
+ * \param code_len The length of the bytecode, up to a STOP code
+ * \param out Where to write the decompressed data
+ * \param out_max The space available at out
+ * \return The length of the decompressed data, or -1 if the bytecode
+ * is invalid or the data needs more than out_max bytes
+ */
+int sicslowpan_ghc_uncompress(const uint8_t *dict, const uint8_t *code,
+                              uint16_t code_len, uint8_t *out,
+                              uint16_t out_max);
+
+#endif /* SICSLOWPAN_GHC_H_ */
+/** @} */
@@ -62,13 +62,19 @@
 
 #include "contiki.h"
 #include "dev/watchdog.h"
+#include "sys/trace.h"
 #include "net/ip/tcpip.h"
 #include "net/ip/uip.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/rime/rime.h"
 #include "net/ipv6/sicslowpan.h"
+#include "net/ipv6/sicslowpan-ghc.h"
 #include "net/netstack.h"
 
+#if UIP_CONF_IPV6_RPL
+#include "net/rpl/rpl-private.h"
+#endif /* UIP_CONF_IPV6_RPL */
+
 #include <stdio.h>
 
 #define DEBUG DEBUG_NONE
@@ -174,6 +180,37 @@ void uip_log(char *msg);
 #define COMPRESSION_THRESHOLD 0
 #endif
 
+/** Compress ICMPv6 messages with Generic Header Compression (RFC
+    7400), and also UDP payloads if SICSLOWPAN_CONF_GHC_UDP is set.
+    All nodes of the network must then support GHC. GHC is only used
+    when the compressed packet fits in a single frame. */
+#if defined(SICSLOWPAN_CONF_GHC) && \
+  SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+#define SICSLOWPAN_GHC SICSLOWPAN_CONF_GHC
+#else
+#define SICSLOWPAN_GHC 0
+#endif
+
+#ifdef SICSLOWPAN_CONF_GHC_UDP
+#define SICSLOWPAN_GHC_UDP (SICSLOWPAN_GHC && SICSLOWPAN_CONF_GHC_UDP)
+#else
+#define SICSLOWPAN_GHC_UDP 0
+#endif
+
+/** Forward unfragmented packets that are routed through this node
+    without handing them to the IP stack, see forward_fast(). */
+#ifdef SICSLOWPAN_CONF_FAST_FORWARD
+#define SICSLOWPAN_FAST_FORWARD SICSLOWPAN_CONF_FAST_FORWARD
+#else
+#define SICSLOWPAN_FAST_FORWARD 1
+#endif
+
+#if !UIP_CONF_ROUTER || defined(SICSLOWPAN_NH_COMPRESSOR) || \
+  SICSLOWPAN_COMPRESSION != SICSLOWPAN_COMPRESSION_HC06
+#undef SICSLOWPAN_FAST_FORWARD
+#define SICSLOWPAN_FAST_FORWARD 0
+#endif
+
 /** \name General variables
  *  @{
  */
@@ -315,10 +352,26 @@ set_packet_attrs()
  *  @{
  */
 
-/** Addresses contexts for IPHC. */
+/** Addresses contexts for IPHC, indexed by context number. */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
 static struct sicslowpan_addr_context 
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+
+/*
+ * How long a context whose lifetime has run out is still used to
+ * decompress packets from nodes that have not noticed yet, in
+ * seconds.
+ */
+#ifdef SICSLOWPAN_CONF_CONTEXT_GRACE_PERIOD
+#define CONTEXT_GRACE_PERIOD SICSLOWPAN_CONF_CONTEXT_GRACE_PERIOD
+#else
+#define CONTEXT_GRACE_PERIOD (2 * (UIP_ND6_ROUTER_LIFETIME))
+#endif
+
+/** Nonzero if some context has a finite lifetime */
+static uint8_t addr_contexts_timed;
+/** When the next context expires, if addr_contexts_timed */
+static unsigned long addr_contexts_expiration;
 #endif
 
 /** pointer to an address context. */
@@ -327,6 +380,12 @@ static struct sicslowpan_addr_context *context;
 /** pointer to the byte where to write next inline field. */
 static uint8_t *hc06_ptr;
 
+#if SICSLOWPAN_GHC
+/** Offset of the next header, or of its NHC, that GHC would replace,
+    zero if none. */
+static uint8_t ghc_offset;
+#endif
+
 /* Uncompression of linklocal */
 /*   0 -> 16 bytes from packet  */
 /*   1 -> 2 bytes from prefix - bunch of zeroes and 8 from packet */
@@ -356,11 +415,64 @@ const uint8_t llprefix[] = {0xfe, 0x80};
 /* TTL uncompression values */
 static const uint8_t ttl_values[] = {0, 1, 64, 255};
 
+/*
+ * Cache of compressed headers for recently sent flows. Besides the
+ * contexts and our link-layer address, which are set up at
+ * initialization, the IPHC header only depends on the IPv6 header
+ * (payload length excepted), the UDP ports and the link-layer
+ * destination. Packets of the same flow thus get the same header,
+ * apart from the inline UDP checksum. An external next header
+ * compressor may depend on more, so the cache is not used with one.
+ */
+#ifdef SICSLOWPAN_CONF_IPHC_CACHE_SIZE
+#define IPHC_CACHE_SIZE SICSLOWPAN_CONF_IPHC_CACHE_SIZE
+#else
+#define IPHC_CACHE_SIZE 2
+#endif
+
+#ifdef SICSLOWPAN_NH_COMPRESSOR
+#undef IPHC_CACHE_SIZE
+#define IPHC_CACHE_SIZE 0
+#endif
+
+/* Longest IPHC header: dispatch, CID, TF, NH, HLIM, two full addresses
+   and LOWPAN_UDP with full ports and checksum. */
+#define IPHC_MAX_HDR_LEN (2 + 1 + 4 + 1 + 1 + 16 + 16 + 7)
+
+#if IPHC_CACHE_SIZE > 0
+
+/* Bytes of the IPv6 header before and after the payload length. */
+#define IPHC_CACHE_KEY_TF_LEN   4
+#define IPHC_CACHE_KEY_ADDR_LEN (UIP_IPH_LEN - 6)
+
+struct iphc_flow {
+  /* Key */
+  uint8_t tf[IPHC_CACHE_KEY_TF_LEN];
+  uint8_t nh_addr[IPHC_CACHE_KEY_ADDR_LEN];
+  uint8_t ports[4];
+  linkaddr_t link_destaddr;
+  /* Compressed header */
+  uint8_t hdr[IPHC_MAX_HDR_LEN];
+  uint8_t hdr_len;
+  uint8_t uncomp_hdr_len;
+  /* Where the UDP checksum goes in hdr, zero if not UDP. */
+  uint8_t chksum_offset;
+#if SICSLOWPAN_GHC
+  uint8_t ghc_offset;
+#endif
+  /* Zero if unused, higher for more recently used entries. */
+  uint8_t age;
+};
+
+static struct iphc_flow iphc_cache[IPHC_CACHE_SIZE];
+static uint8_t iphc_cache_clock;
+#endif /* IPHC_CACHE_SIZE > 0 */
+
 /*--------------------------------------------------------------------*/
 /** \name HC06 related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
-/** \brief find the context corresponding to prefix ipaddr */
+/** \brief find the compression context corresponding to prefix ipaddr */
 static struct sicslowpan_addr_context*
 addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
 {
@@ -369,6 +481,7 @@ addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
   int i;
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
     if((addr_contexts[i].used == 1) &&
+       (addr_contexts[i].flags & SICSLOWPAN_CONTEXT_COMPRESS) &&
        uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
       return &addr_contexts[i];
     }
@@ -383,12 +496,9 @@ addr_context_lookup_by_number(uint8_t number)
 {
 /* Remove code to avoid warnings and save flash if no context is used */ 
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
-      return &addr_contexts[i];
-    }
+  if(number < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS &&
+     addr_contexts[number].used == 1) {
+    return &addr_contexts[number];
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
   return NULL;
@@ -412,6 +522,160 @@ compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
   }
 }
 
+/*--------------------------------------------------------------------*/
+#if IPHC_CACHE_SIZE > 0
+/** \brief Forget all cached headers, e.g. when a context changes */
+static void
+iphc_cache_flush(void)
+{
+  memset(iphc_cache, 0, sizeof(iphc_cache));
+  iphc_cache_clock = 0;
+}
+/*--------------------------------------------------------------------*/
+static void
+iphc_cache_touch(struct iphc_flow *flow)
+{
+  int i;
+
+  if(++iphc_cache_clock == 0) {
+    /* Wrapped: restart the ages while keeping their order. */
+    for(i = 0; i < IPHC_CACHE_SIZE; i++) {
+      if(iphc_cache[i].age > 0) {
+        iphc_cache[i].age = (iphc_cache[i].age >> 1) | 1;
+      }
+    }
+    iphc_cache_clock = 0x80;
+  }
+  flow->age = iphc_cache_clock;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Find the cached flow of the packet in uip_buf */
+static struct iphc_flow *
+iphc_cache_lookup(linkaddr_t *link_destaddr)
+{
+  uint8_t *ip = (uint8_t *)UIP_IP_BUF;
+  struct iphc_flow *flow;
+
+  for(flow = iphc_cache; flow < iphc_cache + IPHC_CACHE_SIZE; flow++) {
+    if(flow->age != 0 &&
+       memcmp(flow->nh_addr, ip + 6, IPHC_CACHE_KEY_ADDR_LEN) == 0 &&
+       memcmp(flow->tf, ip, IPHC_CACHE_KEY_TF_LEN) == 0 &&
+       linkaddr_cmp(&flow->link_destaddr, link_destaddr) &&
+       (flow->chksum_offset == 0 ||
+        memcmp(flow->ports, &UIP_UDP_BUF->srcport, 4) == 0)) {
+      return flow;
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Remember the header just compressed into the packetbuf */
+static void
+iphc_cache_store(linkaddr_t *link_destaddr)
+{
+  uint8_t *ip = (uint8_t *)UIP_IP_BUF;
+  struct iphc_flow *flow, *oldest;
+
+  if(packetbuf_hdr_len > IPHC_MAX_HDR_LEN) {
+    return;
+  }
+
+  oldest = iphc_cache;
+  for(flow = iphc_cache + 1; flow < iphc_cache + IPHC_CACHE_SIZE; flow++) {
+    if(flow->age < oldest->age) {
+      oldest = flow;
+    }
+  }
+  flow = oldest;
+
+  memcpy(flow->tf, ip, IPHC_CACHE_KEY_TF_LEN);
+  memcpy(flow->nh_addr, ip + 6, IPHC_CACHE_KEY_ADDR_LEN);
+  linkaddr_copy(&flow->link_destaddr, link_destaddr);
+  memcpy(flow->hdr, packetbuf_ptr, packetbuf_hdr_len);
+  flow->hdr_len = packetbuf_hdr_len;
+  flow->uncomp_hdr_len = uncomp_hdr_len;
+  flow->chksum_offset = 0;
+#if SICSLOWPAN_GHC
+  flow->ghc_offset = ghc_offset;
+#endif
+#if UIP_CONF_UDP || UIP_CONF_ROUTER
+  if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+    memcpy(flow->ports, &UIP_UDP_BUF->srcport, 4);
+    /* The checksum is the last inline field. */
+    flow->chksum_offset = packetbuf_hdr_len - 2;
+  }
+#endif /* UIP_CONF_UDP || UIP_CONF_ROUTER */
+  iphc_cache_touch(flow);
+}
+#endif /* IPHC_CACHE_SIZE > 0 */
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+/** \brief The cached headers depend on the contexts; drop them */
+static void
+addr_contexts_changed(void)
+{
+#if IPHC_CACHE_SIZE > 0
+  iphc_cache_flush();
+#endif
+}
+/*--------------------------------------------------------------------*/
+/** \brief Find when the next context expires */
+static void
+addr_contexts_schedule(void)
+{
+  struct sicslowpan_addr_context *c;
+
+  addr_contexts_timed = 0;
+  for(c = addr_contexts;
+      c < addr_contexts + SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; c++) {
+    if(c->used == 1 && !(c->flags & SICSLOWPAN_CONTEXT_INFINITE)) {
+      if(!addr_contexts_timed ||
+         (long)(c->expiration - addr_contexts_expiration) < 0) {
+        addr_contexts_expiration = c->expiration;
+      }
+      addr_contexts_timed = 1;
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Age out contexts whose lifetime has run out
+ *
+ * A compression context first becomes decompression only for
+ * CONTEXT_GRACE_PERIOD, and is then removed.
+ */
+static void
+addr_contexts_expire(void)
+{
+  struct sicslowpan_addr_context *c;
+  unsigned long now;
+
+  if(!addr_contexts_timed) {
+    return;
+  }
+  now = clock_seconds();
+  if((long)(now - addr_contexts_expiration) < 0) {
+    return;
+  }
+
+  for(c = addr_contexts;
+      c < addr_contexts + SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; c++) {
+    if(c->used == 1 && !(c->flags & SICSLOWPAN_CONTEXT_INFINITE) &&
+       (long)(now - c->expiration) >= 0) {
+      if(c->flags & SICSLOWPAN_CONTEXT_COMPRESS) {
+        PRINTF("IPHC: context %u decompression only\n", c->number);
+        c->flags &= ~SICSLOWPAN_CONTEXT_COMPRESS;
+        c->expiration = now + CONTEXT_GRACE_PERIOD;
+      } else {
+        PRINTF("IPHC: context %u expired\n", c->number);
+        c->used = 0;
+      }
+    }
+  }
+  addr_contexts_schedule();
+  addr_contexts_changed();
+}
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
 /*-------------------------------------------------------------------- */
 /* Uncompress addresses based on a prefix and a postfix with zeroes in
  * between. If the postfix is zero in length it will use the link address
@@ -493,6 +757,10 @@ static void
 compress_hdr_hc06(linkaddr_t *link_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  struct sicslowpan_addr_context *src_context, *dest_context;
+#if IPHC_CACHE_SIZE > 0
+  struct iphc_flow *flow;
+#endif
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -504,6 +772,31 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
   }
 #endif
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  addr_contexts_expire();
+#endif
+#if SICSLOWPAN_GHC
+  ghc_offset = 0;
+#endif
+
+#if IPHC_CACHE_SIZE > 0
+  if((flow = iphc_cache_lookup(link_destaddr)) != NULL) {
+    /* Same flow as before: only the UDP checksum differs. */
+    memcpy(packetbuf_ptr, flow->hdr, flow->hdr_len);
+    if(flow->chksum_offset != 0) {
+      memcpy(packetbuf_ptr + flow->chksum_offset,
+             &UIP_UDP_BUF->udpchksum, 2);
+    }
+    packetbuf_hdr_len = flow->hdr_len;
+    uncomp_hdr_len = flow->uncomp_hdr_len;
+#if SICSLOWPAN_GHC
+    ghc_offset = flow->ghc_offset;
+#endif
+    iphc_cache_touch(flow);
+    return;
+  }
+#endif /* IPHC_CACHE_SIZE > 0 */
+
   hc06_ptr = packetbuf_ptr + 2;
   /*
    * As we copy some bit-length fields, in the IPHC encoding bytes,
@@ -523,11 +816,16 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
    */
 
 
-  /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  /* check if src or dest context exists (for allocating third byte) */
+  src_context = NULL;
+  if(!uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    src_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr);
+  }
+  dest_context = NULL;
+  if(!uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    dest_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr);
+  }
+  if(src_context != NULL || dest_context != NULL) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -591,6 +889,11 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
   }
 #endif
   if ((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
+#if SICSLOWPAN_GHC
+    if(UIP_IP_BUF->proto == UIP_PROTO_ICMP6) {
+      ghc_offset = hc06_ptr - packetbuf_ptr;
+    }
+#endif
     *hc06_ptr = UIP_IP_BUF->proto;
     hc06_ptr += 1;
   }
@@ -623,8 +926,7 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if((context = src_context) != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
 	   context->number);
@@ -677,7 +979,7 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if((context = dest_context) != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
       PACKETBUF_IPHC_BUF[2] |= context->number;
@@ -707,6 +1009,9 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
   if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
     PRINTF("IPHC: Uncompressed UDP ports on send side: %x, %x\n",
 	   UIP_HTONS(UIP_UDP_BUF->srcport), UIP_HTONS(UIP_UDP_BUF->destport));
+#if SICSLOWPAN_GHC_UDP
+    ghc_offset = hc06_ptr - packetbuf_ptr;
+#endif
     /* Mask out the last 4 bits can be used as a mask */
     if(((UIP_HTONS(UIP_UDP_BUF->srcport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN) &&
        ((UIP_HTONS(UIP_UDP_BUF->destport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN)) {
@@ -763,9 +1068,67 @@ compress_hdr_hc06(linkaddr_t *link_destaddr)
   PACKETBUF_IPHC_BUF[1] = iphc1;
 
   packetbuf_hdr_len = hc06_ptr - packetbuf_ptr;
+#if IPHC_CACHE_SIZE > 0
+  iphc_cache_store(link_destaddr);
+#endif
   return;
 }
 
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_GHC
+/**
+ * \brief Compress the rest of the packet with GHC, if it then fits
+ * in a single frame
+ *
+ * compress_hdr_hc06() must have been called first. For ICMPv6, the
+ * inline next header is replaced by the LOWPAN_NHC for ICMPv6 GHC at
+ * the end of the IPHC header; for UDP, the LOWPAN_NHC for UDP is
+ * turned into the one for UDP GHC. The GHC bytecode follows.
+ *
+ * \param max_payload The space available in the frame
+ */
+static void
+compress_ghc(int max_payload)
+{
+  uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+  uint8_t *nh;
+  int len, out_max;
+
+  if(ghc_offset == 0 || uip_len > 0xff) {
+    return;
+  }
+
+  /* Must both fit in the frame and be shorter than the data itself */
+  out_max = max_payload - packetbuf_hdr_len;
+  if(out_max > (int)uip_len - (int)uncomp_hdr_len - 1) {
+    out_max = (int)uip_len - (int)uncomp_hdr_len - 1;
+  }
+  if(out_max <= 0) {
+    return;
+  }
+
+  sicslowpan_ghc_dict(dict, &UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr,
+                      UIP_IP_BUF->proto);
+  len = sicslowpan_ghc_compress(dict, (uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+                                uip_len - uncomp_hdr_len,
+                                packetbuf_ptr + packetbuf_hdr_len, out_max);
+  if(len < 0) {
+    return;
+  }
+  PRINTF("IPHC: GHC %d -> %d bytes\n", uip_len - uncomp_hdr_len, len);
+
+  nh = packetbuf_ptr + ghc_offset;
+  if(UIP_IP_BUF->proto == UIP_PROTO_ICMP6) {
+    memmove(nh, nh + 1, packetbuf_hdr_len - ghc_offset - 1);
+    packetbuf_ptr[packetbuf_hdr_len - 1] = SICSLOWPAN_NHC_ICMP6_GHC;
+    packetbuf_ptr[0] |= SICSLOWPAN_IPHC_NH_C;
+  } else {
+    *nh = SICSLOWPAN_NHC_UDP_GHC_ID | (*nh & ~SICSLOWPAN_NHC_UDP_MASK);
+  }
+  packetbuf_hdr_len += len;
+  uncomp_hdr_len = uip_len;
+}
+#endif /* SICSLOWPAN_GHC */
 /*--------------------------------------------------------------------*/
 /**
  * \brief Uncompress HC06 (i.e., IPHC and LOWPAN_UDP) headers and put
@@ -786,12 +1149,21 @@ static void
 uncompress_hdr_hc06(uint16_t ip_len)
 {
   uint8_t tmp, iphc0, iphc1;
+#if SICSLOWPAN_GHC
+  uint8_t ghc = 0;
+#endif
   /* at least two byte will be used for the encoding */
   hc06_ptr = packetbuf_ptr + packetbuf_hdr_len + 2;
 
   iphc0 = PACKETBUF_IPHC_BUF[0];
   iphc1 = PACKETBUF_IPHC_BUF[1];
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(iphc1 & (SICSLOWPAN_IPHC_SAC | SICSLOWPAN_IPHC_DAC)) {
+    addr_contexts_expire();
+  }
+#endif
+
   /* another if the CID flag is set */
   if(iphc1 & SICSLOWPAN_IPHC_CID) {
     PRINTF("IPHC: CID flag set - increase header with one\n");
@@ -932,12 +1304,25 @@ uncompress_hdr_hc06(uint16_t ip_len)
   /* Next header processing - continued */
   if((iphc0 & SICSLOWPAN_IPHC_NH_C)) {
     /* The next header is compressed, NHC is following */
+#if SICSLOWPAN_GHC
+    if(*hc06_ptr == SICSLOWPAN_NHC_ICMP6_GHC) {
+      /* The GHC data follows */
+      SICSLOWPAN_IP_BUF->proto = UIP_PROTO_ICMP6;
+      hc06_ptr++;
+      ghc = 1;
+    } else if((*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID ||
+              (*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) ==
+              SICSLOWPAN_NHC_UDP_GHC_ID) {
+      ghc = (*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_GHC_ID;
+#else /* SICSLOWPAN_GHC */
     if((*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID) {
+#endif /* SICSLOWPAN_GHC */
       uint8_t checksum_compressed;
       SICSLOWPAN_IP_BUF->proto = UIP_PROTO_UDP;
       checksum_compressed = *hc06_ptr & SICSLOWPAN_NHC_UDP_CHECKSUMC;
       PRINTF("IPHC: Incoming header value: %i\n", *hc06_ptr);
-      switch(*hc06_ptr & SICSLOWPAN_NHC_UDP_CS_P_11) {
+      /* The UDP GHC NHC only differs from the UDP one in the ID */
+      switch((*hc06_ptr | SICSLOWPAN_NHC_UDP_ID) & SICSLOWPAN_NHC_UDP_CS_P_11) {
       case SICSLOWPAN_NHC_UDP_CS_P_00:
 	/* 1 byte for NHC, 4 byte for ports, 2 bytes chksum */
 	memcpy(&SICSLOWPAN_UDP_BUF->srcport, hc06_ptr + 1, 2);
@@ -999,6 +1384,36 @@ uncompress_hdr_hc06(uint16_t ip_len)
 #endif
   }
 
+#if SICSLOWPAN_GHC
+  /* GHC data runs to the end of the packet, which is never fragmented */
+  if(ghc) {
+    uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+    uint8_t *end = packetbuf_ptr + packetbuf_datalen();
+    int len, out_max;
+
+    if(ip_len != 0 || hc06_ptr > end) {
+      PRINTF("sicslowpan uncompress_hdr: error bad GHC packet\n");
+      return;
+    }
+    out_max = sizeof(sicslowpan_buf) - UIP_LLH_LEN - uncomp_hdr_len;
+    if(out_max > 0xff - uncomp_hdr_len) {
+      out_max = 0xff - uncomp_hdr_len;
+    }
+    sicslowpan_ghc_dict(dict, &SICSLOWPAN_IP_BUF->srcipaddr,
+                        &SICSLOWPAN_IP_BUF->destipaddr,
+                        SICSLOWPAN_IP_BUF->proto);
+    len = sicslowpan_ghc_uncompress(dict, hc06_ptr, end - hc06_ptr,
+                                    (uint8_t *)SICSLOWPAN_IP_BUF +
+                                    uncomp_hdr_len, out_max);
+    if(len < 0) {
+      PRINTF("sicslowpan uncompress_hdr: error bad GHC data\n");
+      return;
+    }
+    uncomp_hdr_len += len;
+    hc06_ptr = end;
+  }
+#endif /* SICSLOWPAN_GHC */
+
   packetbuf_hdr_len = hc06_ptr - packetbuf_ptr;
   
   /* IP length field. */
@@ -1309,6 +1724,7 @@ compress_hdr_ipv6(linkaddr_t *link_destaddr)
 static void
 packet_sent(void *ptr, int status, int transmissions)
 {
+  TRACE(TRACE_MODULE_SICSLOWPAN, TRACE_EVENT_DONE, status);
   uip_ds6_link_neighbor_callback(status, transmissions);
 
   if(callback != NULL) {
@@ -1366,6 +1782,8 @@ output(const uip_lladdr_t *localdest)
   /* Number of bytes processed. */
   uint16_t processed_ip_out_len;
 
+  TRACE(TRACE_MODULE_SICSLOWPAN, TRACE_EVENT_OUT, uip_len);
+
   /* init */
   uncomp_hdr_len = 0;
   packetbuf_hdr_len = 0;
@@ -1445,6 +1863,12 @@ output(const uip_lladdr_t *localdest)
 #endif /* USE_FRAMER_HDRLEN */
   max_payload = MAC_MAX_PAYLOAD - framer_hdrlen - NETSTACK_LLSEC.get_overhead();
 
+#if SICSLOWPAN_GHC
+  if(uip_len >= COMPRESSION_THRESHOLD) {
+    compress_ghc(max_payload);
+  }
+#endif /* SICSLOWPAN_GHC */
+
   if((int)uip_len - (int)uncomp_hdr_len > max_payload - (int)packetbuf_hdr_len) {
 #if SICSLOWPAN_CONF_FRAG
     struct queuebuf *q;
@@ -1573,6 +1997,178 @@ output(const uip_lladdr_t *localdest)
   return 1;
 }
 
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_FAST_FORWARD
+/**
+ * \brief Forward a received packet that is only routed through us
+ * \return 1 if the packet was forwarded or dropped, 0 if it must go
+ * through uip_process() and tcpip_ipv6_output() as usual
+ *
+ * Called by input() once the IPHC header of an unfragmented packet
+ * is uncompressed. Only the headers move to uip_buf, where the RPL
+ * option and the hop limit are updated as uip_process() would do.
+ * The next hop is chosen as in tcpip_ipv6_output(), and the header
+ * is compressed again for it (usually a hit in the IPHC cache). The
+ * rest of the payload stays in packetbuf. Packets for us, multicast,
+ * other extension headers or next hops that are not reachable are
+ * left to the normal path.
+ */
+static int
+forward_fast(void)
+{
+  uint8_t hdr[IPHC_MAX_HDR_LEN];
+  uip_ipaddr_t *nexthop;
+  uip_ds6_route_t *route;
+  uip_ds6_nbr_t *nbr;
+  linkaddr_t dest;
+  uint8_t *payload, *ptr;
+  uint8_t ext_len, head_len;
+  int payload_len, framer_hdrlen, max_payload;
+
+  if(packetbuf_hdr_len == 0 || callback != NULL) {
+    return 0;
+  }
+
+  if(uip_is_addr_mcast(&SICSLOWPAN_IP_BUF->destipaddr) ||
+     uip_is_addr_link_local(&SICSLOWPAN_IP_BUF->destipaddr) ||
+     uip_is_addr_loopback(&SICSLOWPAN_IP_BUF->destipaddr) ||
+     uip_is_addr_mcast(&SICSLOWPAN_IP_BUF->srcipaddr) ||
+     uip_is_addr_link_local(&SICSLOWPAN_IP_BUF->srcipaddr) ||
+     uip_is_addr_unspecified(&SICSLOWPAN_IP_BUF->srcipaddr) ||
+     SICSLOWPAN_IP_BUF->ttl <= 1 ||
+     uip_ds6_is_my_addr(&SICSLOWPAN_IP_BUF->destipaddr)) {
+    return 0;
+  }
+
+  /* Inline headers that are needed in uip_buf as well */
+  ext_len = 0;
+#if UIP_CONF_IPV6_RPL
+  /* A hop-by-hop header with only the RPL option */
+  payload = packetbuf_ptr + packetbuf_hdr_len;
+  if(SICSLOWPAN_IP_BUF->proto != UIP_PROTO_HBHO ||
+     uncomp_hdr_len != UIP_IPH_LEN ||
+     packetbuf_datalen() < packetbuf_hdr_len + RPL_HOP_BY_HOP_LEN ||
+     ((struct uip_hbho_hdr *)payload)->len != RPL_HOP_BY_HOP_LEN - 8 ||
+     payload[2] != UIP_EXT_HDR_OPT_RPL || payload[3] != RPL_HDR_OPT_LEN) {
+    return 0;
+  }
+  ext_len = RPL_HOP_BY_HOP_LEN;
+#else /* UIP_CONF_IPV6_RPL */
+  if(SICSLOWPAN_IP_BUF->proto == UIP_PROTO_HBHO) {
+    return 0;
+  }
+  if(SICSLOWPAN_IP_BUF->proto == UIP_PROTO_UDP &&
+     uncomp_hdr_len < UIP_IPUDPH_LEN) {
+    /* Inline UDP header, needed to compress it */
+    if(packetbuf_datalen() < packetbuf_hdr_len + UIP_UDPH_LEN) {
+      return 0;
+    }
+    ext_len = UIP_UDPH_LEN;
+  }
+#endif /* UIP_CONF_IPV6_RPL */
+
+  /* A truncated frame is dropped by input() */
+  if(packetbuf_datalen() < packetbuf_hdr_len + ext_len) {
+    return 0;
+  }
+
+  head_len = uncomp_hdr_len + ext_len;
+  payload = packetbuf_ptr + packetbuf_hdr_len + ext_len;
+  payload_len = packetbuf_datalen() - packetbuf_hdr_len - ext_len;
+#if SICSLOWPAN_CONF_FRAG
+  memcpy(UIP_IP_BUF, SICSLOWPAN_IP_BUF, uncomp_hdr_len);
+#endif /* SICSLOWPAN_CONF_FRAG */
+  memcpy((uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+         packetbuf_ptr + packetbuf_hdr_len, ext_len);
+
+  /* Next hop, as chosen by tcpip_ipv6_output() */
+  if(uip_ds6_is_addr_onlink(&UIP_IP_BUF->destipaddr)) {
+    nexthop = &UIP_IP_BUF->destipaddr;
+  } else if((route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr)) != NULL) {
+    nexthop = uip_ds6_route_nexthop(route);
+  } else {
+    nexthop = uip_ds6_defrt_choose();
+  }
+  if(nexthop == NULL || (nbr = uip_ds6_nbr_lookup(nexthop)) == NULL) {
+    return 0;
+  }
+#if UIP_ND6_SEND_NA
+  if(nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+#endif /* UIP_ND6_SEND_NA */
+#if UIP_CONF_IPV6_QUEUE_PKT
+  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
+    return 0;
+  }
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+  linkaddr_copy(&dest, (const linkaddr_t *)uip_ds6_nbr_get_ll(nbr));
+
+  UIP_STAT(++uip_stat.ip.recv);
+  uip_len = head_len + payload_len;
+#if UIP_CONF_IPV6_RPL
+  /* The option follows the two bytes of the hop-by-hop header */
+  uip_ext_len = 0;
+  if(rpl_verify_header(2) || rpl_update_header_empty()) {
+    PRINTFI("sicslowpan forward: dropped by RPL\n");
+    UIP_STAT(++uip_stat.ip.drop);
+    uip_len = 0;
+    return 1;
+  }
+#endif /* UIP_CONF_IPV6_RPL */
+  UIP_IP_BUF->ttl--;
+#if UIP_CONF_IPV6_RPL
+  if(rpl_update_header_final(nexthop)) {
+    uip_len = 0;
+    return 1;
+  }
+#endif /* UIP_CONF_IPV6_RPL */
+  UIP_STAT(++uip_stat.ip.forwarded);
+  UIP_STAT(++uip_stat.ip.sent);
+
+  /* Compress the header for the next hop */
+  ptr = packetbuf_ptr;
+  packetbuf_ptr = hdr;
+  packetbuf_hdr_len = 0;
+  uncomp_hdr_len = 0;
+  compress_hdr_hc06(&dest);
+  packetbuf_ptr = ptr;
+
+  /* The data is still in the buffer after this */
+  packetbuf_clear();
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     SICSLOWPAN_MAX_MAC_TRANSMISSIONS);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
+  framer_hdrlen = NETSTACK_FRAMER.length();
+  if(framer_hdrlen < 0) {
+    framer_hdrlen = 21;
+  }
+  max_payload = MAC_MAX_PAYLOAD - framer_hdrlen - NETSTACK_LLSEC.get_overhead();
+
+  if(packetbuf_hdr_len + head_len - uncomp_hdr_len + payload_len >
+     max_payload) {
+    /* Needs fragmentation or GHC: leave it to output() */
+    PRINTFI("sicslowpan forward: %d bytes through output()\n", uip_len);
+    memcpy((uint8_t *)UIP_IP_BUF + head_len, payload, payload_len);
+    output((const uip_lladdr_t *)&dest);
+  } else {
+    PRINTFI("sicslowpan forward: %d bytes\n", uip_len);
+    TRACE(TRACE_MODULE_SICSLOWPAN, TRACE_EVENT_OUT, uip_len);
+    packetbuf_ptr = packetbuf_dataptr();
+    memmove(packetbuf_ptr + packetbuf_hdr_len + head_len - uncomp_hdr_len,
+            payload, payload_len);
+    memcpy(packetbuf_ptr, hdr, packetbuf_hdr_len);
+    memcpy(packetbuf_ptr + packetbuf_hdr_len,
+           (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, head_len - uncomp_hdr_len);
+    packetbuf_set_datalen(packetbuf_hdr_len + head_len - uncomp_hdr_len +
+                          payload_len);
+    send_packet(&dest);
+  }
+  uip_len = 0;
+  uip_ext_len = 0;
+  return 1;
+}
+#endif /* SICSLOWPAN_FAST_FORWARD */
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
  *  \param r The MAC layer
@@ -1600,6 +2196,8 @@ input(void)
   uint8_t first_fragment = 0, last_fragment = 0;
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
+  TRACE(TRACE_MODULE_SICSLOWPAN, TRACE_EVENT_IN, packetbuf_datalen());
+
   /* init */
   uncomp_hdr_len = 0;
   packetbuf_hdr_len = 0;
@@ -1731,6 +2329,11 @@ input(void)
   if((PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH] & 0xe0) == SICSLOWPAN_DISPATCH_IPHC) {
     PRINTFI("sicslowpan input: IPHC\n");
     uncompress_hdr_hc06(frag_size);
+#if SICSLOWPAN_FAST_FORWARD
+    if(!is_fragment && forward_fast()) {
+      return;
+    }
+#endif /* SICSLOWPAN_FAST_FORWARD */
   } else
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
     switch(PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH]) {
@@ -1908,6 +2511,22 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  /* The preinitialized contexts are /64 and never expire */
+  {
+    int i;
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      addr_contexts[i].length = 64;
+      addr_contexts[i].flags = SICSLOWPAN_CONTEXT_COMPRESS |
+        SICSLOWPAN_CONTEXT_INFINITE;
+    }
+  }
+  addr_contexts_timed = 0;
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
+#if IPHC_CACHE_SIZE > 0
+  iphc_cache_flush();
+#endif
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 }
 /*--------------------------------------------------------------------*/
@@ -1917,6 +2536,79 @@ sicslowpan_get_last_rssi(void)
   return last_rssi;
 }
 /*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                       uint8_t length, uint8_t compress, uint32_t lifetime)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+  SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+  uint8_t new_prefix[8];
+  uint8_t flags;
+
+  if(number >= SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS || length > 64) {
+    return 0;
+  }
+
+  /* Zero-pad the prefix to 64 bits */
+  memset(new_prefix, 0, sizeof(new_prefix));
+  memcpy(new_prefix, prefix, (length + 7) >> 3);
+  if(length & 7) {
+    new_prefix[length >> 3] &= 0xff << (8 - (length & 7));
+  }
+
+  flags = compress ? SICSLOWPAN_CONTEXT_COMPRESS : 0;
+  if(lifetime == SICSLOWPAN_CONTEXT_INFINITE_LIFETIME) {
+    flags |= SICSLOWPAN_CONTEXT_INFINITE;
+  }
+
+  c = &addr_contexts[number];
+  if(c->used != 1 || c->length != length ||
+     memcmp(c->prefix, new_prefix, sizeof(new_prefix)) != 0 ||
+     ((c->flags ^ flags) & SICSLOWPAN_CONTEXT_COMPRESS)) {
+    PRINTF("IPHC: context %u set, length %u, compress %u\n",
+           number, length, compress != 0);
+    addr_contexts_changed();
+  }
+  c->used = 1;
+  c->number = number;
+  c->length = length;
+  memcpy(c->prefix, new_prefix, sizeof(new_prefix));
+  c->flags = flags;
+  c->expiration = clock_seconds() + lifetime;
+  addr_contexts_schedule();
+  return 1;
+#else
+  return 0;
+#endif
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_context_remove(uint8_t number)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+  SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(addr_context_lookup_by_number(number) != NULL) {
+    PRINTF("IPHC: context %u removed\n", number);
+    addr_contexts[number].used = 0;
+    addr_contexts_schedule();
+    addr_contexts_changed();
+  }
+#endif
+}
+/*--------------------------------------------------------------------*/
+const struct sicslowpan_addr_context *
+sicslowpan_context_get(uint8_t number)
+{
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 && \
+  SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  addr_contexts_expire();
+  return addr_context_lookup_by_number(number);
+#else
+  return NULL;
+#endif
+}
+/*--------------------------------------------------------------------*/
 const struct network_driver sicslowpan_driver = {
   "sicslowpan",
   sicslowpan_init,
@@ -162,6 +162,10 @@
 #define SICSLOWPAN_NHC_UDP_CS_P_01  0xF1 /* source 16bit inline, dest = 0xF0 + 8 bit inline */
 #define SICSLOWPAN_NHC_UDP_CS_P_10  0xF2 /* source = 0xF0 + 8bit inline, dest = 16 bit inline */
 #define SICSLOWPAN_NHC_UDP_CS_P_11  0xF3 /* source & dest = 0xF0B + 4bit inline */
+
+/* GHC (RFC 7400) */
+#define SICSLOWPAN_NHC_UDP_GHC_ID                   0xD0
+#define SICSLOWPAN_NHC_ICMP6_GHC                    0xDF
 /** @} */
 
 
@@ -218,13 +222,30 @@
 /**
  * \brief An address context for IPHC address compression
  * each context can have upto 8 bytes
+ *
+ * Contexts are stored by number (CID). The prefix is kept zero-padded
+ * to 64 bits, so contexts shorter than 64 bits work as well.
  */
 struct sicslowpan_addr_context {
   uint8_t used; /* possibly use as prefix-length */
   uint8_t number;
   uint8_t prefix[8];
+  uint8_t length;   /* prefix length in bits, at most 64 */
+  uint8_t flags;    /* SICSLOWPAN_CONTEXT_* */
+  unsigned long expiration; /* in clock_seconds(), unless infinite */
 };
 
+/** \name Address context flags
+ * @{
+ */
+/** The context may be used for compression (C flag of the 6CO) */
+#define SICSLOWPAN_CONTEXT_COMPRESS          0x01
+/** The context does not expire */
+#define SICSLOWPAN_CONTEXT_INFINITE          0x02
+/** @} */
+
+#define SICSLOWPAN_CONTEXT_INFINITE_LIFETIME 0xFFFFFFFF
+
 /**
  * \name Address compressibility test functions
  * @{
@@ -321,6 +342,33 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+/**
+ * \brief Install or update an IPHC address context
+ * \param number The context number (CID)
+ * \param prefix The context prefix, (length + 7) / 8 bytes long
+ * \param length The prefix length in bits, at most 64
+ * \param compress Nonzero if the context may be used for compression
+ * \param lifetime The valid lifetime in seconds, or
+ * SICSLOWPAN_CONTEXT_INFINITE_LIFETIME
+ * \retval 1 The context was stored
+ * \retval 0 No room for this context number, or unsupported length
+ *
+ * When the lifetime of a compression context runs out, the context
+ * is kept for decompression only for a while before it is removed.
+ */
+int sicslowpan_context_set(uint8_t number, const uint8_t *prefix,
+                           uint8_t length, uint8_t compress,
+                           uint32_t lifetime);
+
+/** \brief Remove the IPHC address context with the given number */
+void sicslowpan_context_remove(uint8_t number);
+
+/**
+ * \brief Get the IPHC address context with the given number
+ * \return The context, or NULL if there is no such context
+ */
+const struct sicslowpan_addr_context *sicslowpan_context_get(uint8_t number);
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
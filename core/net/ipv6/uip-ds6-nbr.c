@@ -50,10 +50,13 @@
 #include "net/linkaddr.h"
 #include "net/packetbuf.h"
 #include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ip/tcpip.h"
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
 #ifdef UIP_CONF_DS6_NEIGHBOR_STATE_CHANGED
 #define NEIGHBOR_STATE_CHANGED(n) UIP_CONF_DS6_NEIGHBOR_STATE_CHANGED(n)
 void NEIGHBOR_STATE_CHANGED(uip_ds6_nbr_t *n);
@@ -93,6 +96,9 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     stimer_set(&nbr->reachable, 0);
     stimer_set(&nbr->sendns, 0);
     nbr->nscount = 0;
+    if(state != NBR_STALE) {
+      uip_ds6_wakeup(0);
+    }
     PRINTF("Adding neighbor with ip addr ");
     PRINT6ADDR(ipaddr);
     PRINTF(" link addr ");
@@ -110,13 +116,32 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
   }
 }
 
+/*---------------------------------------------------------------------------*/
+#if UIP_CONF_IPV6_QUEUE_PKT
+void
+uip_ds6_nbr_send_queued(uip_ds6_nbr_t *nbr)
+{
+  if(nbr->state == NBR_INCOMPLETE) {
+    return;
+  }
+  while(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
+    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
+    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
+    uip_packetqueue_free(&nbr->packethandle);
+    UIP_STAT(++uip_stat.nd6.flushed);
+    tcpip_output(uip_ds6_nbr_get_ll(nbr));
+  }
+  uip_len = 0;
+  uip_ext_len = 0;
+}
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 {
   if(nbr != NULL) {
 #if UIP_CONF_IPV6_QUEUE_PKT
-    uip_packetqueue_free(&nbr->packethandle);
+    uip_packetqueue_flush(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
     NEIGHBOR_STATE_CHANGED(nbr);
     nbr_table_remove(ds6_neighbors, nbr);
@@ -222,6 +247,7 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
     if(nbr != NULL && nbr->state != NBR_INCOMPLETE) {
       nbr->state = NBR_REACHABLE;
       stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+      uip_ds6_wakeup_stimer(&nbr->reachable);
       PRINTF("uip-ds6-neighbor : received a link layer ACK : ");
       PRINTLLADDR((uip_lladdr_t *)dest);
       PRINTF(" is reachable.\n");
@@ -229,6 +255,37 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
   }
 #endif /* UIP_DS6_LL_NUD */
 
+}
+/*---------------------------------------------------------------------------*/
+/* Makes sure uip_ds6_periodic() runs when the timer of the state the
+   neighbor is in expires. */
+static void
+wakeup_for(uip_ds6_nbr_t *nbr)
+{
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+  case NBR_DELAY:
+    uip_ds6_wakeup_stimer(&nbr->reachable);
+    break;
+#if UIP_ND6_SEND_NA
+  case NBR_INCOMPLETE:
+    if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
+      uip_ds6_wakeup(0);
+    } else {
+      uip_ds6_wakeup_stimer(&nbr->sendns);
+    }
+    break;
+  case NBR_PROBE:
+    if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
+      uip_ds6_wakeup(0);
+    } else {
+      uip_ds6_wakeup_stimer(&nbr->sendns);
+    }
+    break;
+#endif /* UIP_ND6_SEND_NA */
+  default:
+    break;
+  }
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -267,16 +324,20 @@ uip_ds6_neighbor_periodic(void)
         nbr->state = NBR_STALE;
 #endif /* UIP_CONF_IPV6_RPL */
       }
+      wakeup_for(nbr);
       break;
 #if UIP_ND6_SEND_NA
     case NBR_INCOMPLETE:
       if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
         uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+      } else {
+        if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
+          nbr->nscount++;
+          PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
+          uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
+          stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        }
+        wakeup_for(nbr);
       }
       break;
     case NBR_DELAY:
@@ -286,6 +347,7 @@ uip_ds6_neighbor_periodic(void)
         PRINTF("DELAY: moving to PROBE\n");
         stimer_set(&nbr->sendns, 0);
       }
+      wakeup_for(nbr);
       break;
     case NBR_PROBE:
       if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
@@ -297,11 +359,14 @@ uip_ds6_neighbor_periodic(void)
           }
         }
         uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("PROBE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+      } else {
+        if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
+          nbr->nscount++;
+          PRINTF("PROBE: NS %u\n", nbr->nscount);
+          uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
+          stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        }
+        wakeup_for(nbr);
       }
       break;
 #endif /* UIP_ND6_SEND_NA */
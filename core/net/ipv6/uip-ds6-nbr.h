@@ -94,6 +94,16 @@ uip_ds6_nbr_t *uip_ds6_nbr_ll_lookup(const uip_lladdr_t *lladdr);
 uip_ipaddr_t *uip_ds6_nbr_ipaddr_from_lladdr(const uip_lladdr_t *lladdr);
 const uip_lladdr_t *uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ipaddr);
 void uip_ds6_link_neighbor_callback(int status, int numtx);
+#if UIP_CONF_IPV6_QUEUE_PKT
+/**
+ * \brief Send the packets queued for a neighbor during address
+ *        resolution, oldest first
+ *
+ *        Does nothing while the neighbor is still incomplete.
+ *        Overwrites uip_buf and leaves it empty.
+ */
+void uip_ds6_nbr_send_queued(uip_ds6_nbr_t *nbr);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
 void uip_ds6_neighbor_periodic(void);
 int uip_ds6_nbr_num(void);
 
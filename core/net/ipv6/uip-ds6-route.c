@@ -42,6 +42,7 @@
 #include "net/ip/uip.h"
 
 #include "lib/list.h"
+#include "lib/dlist.h"
 #include "lib/memb.h"
 #include "net/nbr-table.h"
 
@@ -58,7 +59,7 @@ MEMB(neighborroutememb, struct uip_ds6_route_neighbor_route, UIP_DS6_ROUTE_NB);
 /* Each route is repressented by a uip_ds6_route_t structure and
    memory for each route is allocated from the routememb memory
    block. These routes are maintained on the routelist. */
-LIST(routelist);
+DLIST(routelist);
 MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 
 /* Default routes are held on the defaultrouterlist and their
@@ -147,7 +148,7 @@ void
 uip_ds6_route_init(void)
 {
   memb_init(&routememb);
-  list_init(routelist);
+  dlist_init(routelist);
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 
@@ -183,14 +184,14 @@ uip_ds6_route_nexthop(uip_ds6_route_t *route)
 uip_ds6_route_t *
 uip_ds6_route_head(void)
 {
-  return list_head(routelist);
+  return dlist_head(routelist);
 }
 /*---------------------------------------------------------------------------*/
 uip_ds6_route_t *
 uip_ds6_route_next(uip_ds6_route_t *r)
 {
   if(r != NULL) {
-    uip_ds6_route_t *n = list_item_next(r);
+    uip_ds6_route_t *n = dlist_item_next(r);
     return n;
   }
   return NULL;
@@ -240,14 +241,13 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     PRINTF("uip-ds6-route: No route found\n");
   }
 
-  if(found_route != NULL && found_route != list_head(routelist)) {
+  if(found_route != NULL && found_route != dlist_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
        the least recently used route will be at the end of the
        list - for fast lookups (assuming multiple packets to the same node). */
 
-    list_remove(routelist, found_route);
-    list_push(routelist, found_route);
+    dlist_push(routelist, found_route);
   }
 
   return found_route;
@@ -301,7 +301,7 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
          least recently used route is the first route on the list. */
       uip_ds6_route_t *oldest;
 
-      oldest = list_tail(routelist); /* uip_ds6_route_head(); */
+      oldest = dlist_tail(routelist); /* uip_ds6_route_head(); */
       PRINTF("uip_ds6_route_add: dropping route to ");
       PRINT6ADDR(&oldest->ipaddr);
       PRINTF("\n");
@@ -334,7 +334,7 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
         PRINTF("uip_ds6_route_add: could not allocate neighbor table entry\n");
         return NULL;
       }
-      LIST_STRUCT_INIT(routes, route_list);
+      DLIST_STRUCT_INIT(routes, route_list);
     }
 
     /* Allocate a routing entry and populate it. */
@@ -349,20 +349,21 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 
     /* add new routes first - assuming that there is a reason to add this
        and that there is a packet coming soon. */
-    list_push(routelist, r);
+    dlist_push(routelist, r);
 
     nbrr = memb_alloc(&neighborroutememb);
     if(nbrr == NULL) {
       /* This should not happen, as we explicitly deallocated one
          route table entry above. */
       PRINTF("uip_ds6_route_add: could not allocate neighbor route list entry\n");
+      dlist_remove(routelist, r);
       memb_free(&routememb, r);
       return NULL;
     }
 
     nbrr->route = r;
     /* Add the route to this neighbor */
-    list_add(routes->route_list, nbrr);
+    dlist_add(routes->route_list, nbrr);
     r->neighbor_routes = routes;
     num_routes++;
 
@@ -408,20 +409,20 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
     PRINTF("\n");
 
     /* Remove the route from the route list */
-    list_remove(routelist, route);
+    dlist_remove(routelist, route);
 
     /* Find the corresponding neighbor_route and remove it. */
-    for(neighbor_route = list_head(route->neighbor_routes->route_list);
+    for(neighbor_route = dlist_head(route->neighbor_routes->route_list);
         neighbor_route != NULL && neighbor_route->route != route;
-        neighbor_route = list_item_next(neighbor_route));
+        neighbor_route = dlist_item_next(neighbor_route));
 
     if(neighbor_route == NULL) {
       PRINTF("uip_ds6_route_rm: neighbor_route was NULL for ");
       uip_debug_ipaddr_print(&route->ipaddr);
       PRINTF("\n");
     }
-    list_remove(route->neighbor_routes->route_list, neighbor_route);
-    if(list_head(route->neighbor_routes->route_list) == NULL) {
+    dlist_remove(route->neighbor_routes->route_list, neighbor_route);
+    if(dlist_head(route->neighbor_routes->route_list) == NULL) {
       /* If this was the only route using this neighbor, remove the
          neibhor from the table */
       PRINTF("uip_ds6_route_rm: removing neighbor too\n");
@@ -474,10 +475,10 @@ rm_routelist(struct uip_ds6_route_neighbor_routes *routes)
   PRINTF("uip_ds6_route_rm_routelist\n");
   if(routes != NULL && routes->route_list != NULL) {
     struct uip_ds6_route_neighbor_route *r;
-    r = list_head(routes->route_list);
+    r = dlist_head(routes->route_list);
     while(r != NULL) {
       uip_ds6_route_rm(r->route);
-      r = list_head(routes->route_list);
+      r = dlist_head(routes->route_list);
     }
     nbr_table_remove(nbr_routes, routes);
   }
@@ -536,6 +537,7 @@ uip_ds6_defrt_add(uip_ipaddr_t *ipaddr, unsigned long interval)
   if(interval != 0) {
     stimer_set(&d->lifetime, interval);
     d->isinfinite = 0;
+    uip_ds6_wakeup_stimer(&d->lifetime);
   } else {
     d->isinfinite = 1;
   }
@@ -640,6 +642,9 @@ uip_ds6_defrt_periodic(void)
       uip_ds6_defrt_rm(d);
       d = list_head(defaultrouterlist);
     } else {
+      if(!d->isinfinite) {
+        uip_ds6_wakeup_stimer(&d->lifetime);
+      }
       d = list_item_next(d);
     }
   }
@@ -42,6 +42,7 @@
 
 #include "sys/stimer.h"
 #include "lib/list.h"
+#include "lib/dlist.h"
 
 void uip_ds6_route_init(void);
 
@@ -104,12 +105,13 @@ typedef struct rpl_route_entry {
 /** \brief The neighbor routes hold a list of routing table entries
     that are attached to a specific neihbor. */
 struct uip_ds6_route_neighbor_routes {
-  LIST_STRUCT(route_list);
+  DLIST_STRUCT(route_list);
 };
 
 /** \brief An entry in the routing table */
 typedef struct uip_ds6_route {
   struct uip_ds6_route *next;
+  struct uip_ds6_route *prev;
   /* Each route entry belongs to a specific neighbor. That neighbor
      holds a list of all routing entries that go through it. The
      routes field point to the uip_ds6_route_neighbor_routes that
@@ -127,6 +129,7 @@ typedef struct uip_ds6_route {
     uip_ds6_route->neighbor_routes->route_list list. */
 struct uip_ds6_route_neighbor_route {
   struct uip_ds6_route_neighbor_route *next;
+  struct uip_ds6_route_neighbor_route *prev;
   struct uip_ds6_route *route;
 };
 
@@ -49,12 +49,22 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ip/uip-packetqueue.h"
+#include "net/ip/tcpip.h"
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 
 struct etimer uip_ds6_timer_periodic;                           /** \brief Timer for maintenance of data structures */
 
+/* Longest interval an etimer can safely be set to. */
+#define MAX_INTERVAL ((clock_time_t)~0 / 2)
+#define NO_WAKEUP ((clock_time_t)~0)
+
+/* While uip_ds6_periodic() runs, the interval until the earliest
+   deadline reported so far. */
+static clock_time_t next_wakeup;
+static uint8_t in_periodic;
+
 #if UIP_CONF_ROUTER
 struct stimer uip_ds6_timer_ra;                                 /** \brief RA timer, to schedule RA sending */
 #if UIP_ND6_SEND_RA
@@ -140,10 +150,58 @@ uip_ds6_init(void)
 }
 
 
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_wakeup(clock_time_t interval)
+{
+  clock_time_t left;
+
+  if(interval < UIP_DS6_PERIOD) {
+    interval = UIP_DS6_PERIOD;
+  }
+  if(in_periodic) {
+    /* The timer is set once the run is over. */
+    if(interval < next_wakeup) {
+      next_wakeup = interval;
+    }
+    return;
+  }
+  if(!etimer_expired(&uip_ds6_timer_periodic)) {
+    left = etimer_expiration_time(&uip_ds6_timer_periodic) - clock_time();
+    if(left <= interval || left > MAX_INTERVAL) {
+      /* Due sooner anyway, or already overdue. */
+      return;
+    }
+  }
+  PROCESS_CONTEXT_BEGIN(&tcpip_process);
+  etimer_set(&uip_ds6_timer_periodic, interval);
+  PROCESS_CONTEXT_END(&tcpip_process);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_wakeup_stimer(struct stimer *t)
+{
+  unsigned long left;
+
+  if(stimer_expired(t)) {
+    uip_ds6_wakeup(0);
+    return;
+  }
+  /* An stimer only expires on a second boundary, which cannot be
+     mapped onto clock ticks exactly. Wake up a second early and poll
+     every UIP_DS6_PERIOD from there, as before. */
+  left = stimer_remaining(t) - 1;
+  if(left > MAX_INTERVAL / CLOCK_SECOND) {
+    left = MAX_INTERVAL / CLOCK_SECOND;
+  }
+  uip_ds6_wakeup(left * CLOCK_SECOND);
+}
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_periodic(void)
 {
+  in_periodic = 1;
+  next_wakeup = NO_WAKEUP;
 
   /* Periodic processing on unicast addresses */
   for(locaddr = uip_ds6_if.addr_list;
@@ -160,6 +218,18 @@ uip_ds6_periodic(void)
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
       }
     }
+    if(locaddr->isused) {
+      if(!locaddr->isinfinite) {
+        uip_ds6_wakeup_stimer(&locaddr->vlifetime);
+      }
+#if UIP_ND6_DEF_MAXDADNS > 0
+      if((locaddr->state == ADDR_TENTATIVE)
+         && (locaddr->dadnscount <= uip_ds6_if.maxdadns)) {
+        uip_ds6_wakeup(timer_expired(&locaddr->dadtimer) ? 0 :
+                       timer_remaining(&locaddr->dadtimer));
+      }
+#endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+    }
   }
 
   /* Periodic processing on default routers */
@@ -177,9 +247,12 @@ uip_ds6_periodic(void)
   for(locprefix = uip_ds6_prefix_list;
       locprefix < uip_ds6_prefix_list + UIP_DS6_PREFIX_NB;
       locprefix++) {
-    if(locprefix->isused && !locprefix->isinfinite
-       && stimer_expired(&(locprefix->vlifetime))) {
-      uip_ds6_prefix_rm(locprefix);
+    if(locprefix->isused && !locprefix->isinfinite) {
+      if(stimer_expired(&(locprefix->vlifetime))) {
+        uip_ds6_prefix_rm(locprefix);
+      } else {
+        uip_ds6_wakeup_stimer(&locprefix->vlifetime);
+      }
     }
   }
 #endif /* !UIP_CONF_ROUTER */
@@ -191,8 +264,14 @@ uip_ds6_periodic(void)
   if(stimer_expired(&uip_ds6_timer_ra) && (uip_len == 0)) {
     uip_ds6_send_ra_periodic();
   }
+  uip_ds6_wakeup_stimer(&uip_ds6_timer_ra);
 #endif /* UIP_CONF_ROUTER && UIP_ND6_SEND_RA */
-  etimer_reset(&uip_ds6_timer_periodic);
+
+  /* Sleep until the earliest deadline instead of polling. */
+  in_periodic = 0;
+  if(next_wakeup != NO_WAKEUP) {
+    etimer_set(&uip_ds6_timer_periodic, next_wakeup);
+  }
   return;
 }
 
@@ -269,6 +348,7 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     if(interval != 0) {
       stimer_set(&(locprefix->vlifetime), interval);
       locprefix->isinfinite = 0;
+      uip_ds6_wakeup_stimer(&locprefix->vlifetime);
     } else {
       locprefix->isinfinite = 1;
     }
@@ -342,6 +422,8 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
 #else /* UIP_ND6_DEF_MAXDADNS > 0 */
     locaddr->state = ADDR_PREFERRED;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+    /* Let the next run schedule the lifetime and DAD timers. */
+    uip_ds6_wakeup(0);
     uip_create_solicited_node(ipaddr, &loc_fipaddr);
     uip_ds6_maddr_add(&loc_fipaddr);
     return locaddr;
@@ -639,6 +721,7 @@ uip_ds6_send_ra_sollicited(void)
                  stimer_elapsed(&uip_ds6_timer_ra));
   */ } else {
       stimer_set(&uip_ds6_timer_ra, rand_time);
+      uip_ds6_wakeup_stimer(&uip_ds6_timer_ra);
     }
   }
 }
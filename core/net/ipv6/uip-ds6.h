@@ -131,7 +131,8 @@
 #define  ADDR_MANUAL 3
 
 /** \brief General DS6 definitions */
-/** Period for uip-ds6 periodic task*/
+/** Shortest interval between two runs of the uip-ds6 periodic task.
+    The task otherwise only runs when a timer is due. */
 #ifndef UIP_DS6_CONF_PERIOD
 #define UIP_DS6_PERIOD   (CLOCK_SECOND/10)
 #else
@@ -246,6 +247,19 @@ void uip_ds6_init(void);
 /** \brief Periodic processing of data structures */
 void uip_ds6_periodic(void);
 
+/**
+ * \brief Make sure uip_ds6_periodic() runs within interval ticks
+ *
+ * uip_ds6_periodic() is only scheduled for the earliest lifetime or
+ * ND timer it knows about. Code that starts or shortens such a timer
+ * outside of uip_ds6_periodic() must call this, or
+ * uip_ds6_wakeup_stimer(), for the change to be noticed in time.
+ */
+void uip_ds6_wakeup(clock_time_t interval);
+
+/** \brief Make sure uip_ds6_periodic() runs when a stimer expires */
+void uip_ds6_wakeup_stimer(struct stimer *t);
+
 /** \brief Generic loop routine on an abstract data structure, which generalizes
  * all data structures used in DS6 */
 uint8_t uip_ds6_list_loop(uip_ds6_element_t *list, uint8_t size,
@@ -73,6 +73,7 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ip/uip-nameserver.h"
+#include "net/ipv6/sicslowpan.h"
 #include "lib/random.h"
 
 /*------------------------------------------------------------------*/
@@ -114,6 +115,7 @@ void uip_log(char *msg);
 #define UIP_ND6_OPT_PREFIX_BUF ((uip_nd6_opt_prefix_info *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_MTU_BUF ((uip_nd6_opt_mtu *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 #define UIP_ND6_OPT_RDNSS_BUF ((uip_nd6_opt_dns *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
+#define UIP_ND6_OPT_6CO_BUF ((uip_nd6_opt_6co *)&uip_buf[uip_l2_l3_icmp_hdr_len + nd6_opt_offset])
 /** @} */
 
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -501,6 +503,7 @@ na_input(void)
 
         /* reachable time is stored in ms */
         stimer_set(&(nbr->reachable), uip_ds6_if.reachable_time / 1000);
+        uip_ds6_wakeup_stimer(&nbr->reachable);
 
       } else {
         nbr->state = NBR_STALE;
@@ -523,6 +526,7 @@ na_input(void)
             nbr->state = NBR_REACHABLE;
             /* reachable time is stored in ms */
             stimer_set(&(nbr->reachable), uip_ds6_if.reachable_time / 1000);
+            uip_ds6_wakeup_stimer(&nbr->reachable);
           } else {
             if(nd6_opt_llao != 0 && is_llchange) {
               nbr->state = NBR_STALE;
@@ -540,20 +544,8 @@ na_input(void)
     }
   }
 #if UIP_CONF_IPV6_QUEUE_PKT
-  /* The nbr is now reachable, check if we had buffered a pkt for it */
-  /*if(nbr->queue_buf_len != 0) {
-    uip_len = nbr->queue_buf_len;
-    memcpy(UIP_IP_BUF, nbr->queue_buf, uip_len);
-    nbr->queue_buf_len = 0;
-    return;
-    }*/
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
-    return;
-  }
-  
+  /* The nbr is now reachable, send what we had buffered for it */
+  uip_ds6_nbr_send_queued(nbr);
 #endif /*UIP_CONF_IPV6_QUEUE_PKT */
 
 discard:
@@ -722,6 +714,43 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
   uip_len += UIP_ND6_OPT_MTU_LEN;
   nd6_opt_offset += UIP_ND6_OPT_MTU_LEN;
 
+#if UIP_ND6_6CO
+  /* 6LoWPAN contexts, so that hosts compress the same way as we do */
+  {
+    uint8_t cid;
+    const struct sicslowpan_addr_context *context;
+    unsigned long lifetime;
+
+    for(cid = 0; cid <= UIP_ND6_RA_6CO_CID_MASK; cid++) {
+      context = sicslowpan_context_get(cid);
+      if(context == NULL) {
+        continue;
+      }
+      if(context->flags & SICSLOWPAN_CONTEXT_INFINITE) {
+        lifetime = 0xffff;
+      } else {
+        /* In minutes, rounded up */
+        lifetime = (context->expiration - clock_seconds() + 59) / 60;
+        if(lifetime > 0xffff) {
+          lifetime = 0xffff;
+        }
+      }
+      UIP_ND6_OPT_6CO_BUF->type = UIP_ND6_OPT_6CO;
+      UIP_ND6_OPT_6CO_BUF->len = UIP_ND6_OPT_6CO_LEN >> 3;
+      UIP_ND6_OPT_6CO_BUF->context_length = context->length;
+      UIP_ND6_OPT_6CO_BUF->flags_cid = cid;
+      if(context->flags & SICSLOWPAN_CONTEXT_COMPRESS) {
+        UIP_ND6_OPT_6CO_BUF->flags_cid |= UIP_ND6_RA_FLAG_6CO_C;
+      }
+      UIP_ND6_OPT_6CO_BUF->reserved = 0;
+      UIP_ND6_OPT_6CO_BUF->lifetime = uip_htons(lifetime);
+      memcpy(UIP_ND6_OPT_6CO_BUF->prefix, context->prefix, 8);
+      uip_len += UIP_ND6_OPT_6CO_LEN;
+      nd6_opt_offset += UIP_ND6_OPT_6CO_LEN;
+    }
+  }
+#endif /* UIP_ND6_6CO */
+
 #if UIP_ND6_RA_RDNSS
   if(uip_nameserver_count() > 0) {
     uint8_t i = 0;
@@ -919,6 +948,7 @@ ra_input(void)
               stimer_set(&prefix->vlifetime,
                          uip_ntohl(nd6_opt_prefix_info->validlt));
               prefix->isinfinite = 0;
+              uip_ds6_wakeup_stimer(&prefix->vlifetime);
               break;
             }
           }
@@ -951,6 +981,7 @@ ra_input(void)
                 PRINTF("new value %lu\n", (unsigned long)(2 * 60 * 60));
               }
               addr->isinfinite = 0;
+              uip_ds6_wakeup_stimer(&addr->vlifetime);
             } else {
               addr->isinfinite = 1;
             }
@@ -984,6 +1015,26 @@ ra_input(void)
       }
       break;
 #endif /* UIP_ND6_RA_RDNSS */
+#if UIP_ND6_6CO
+    case UIP_ND6_OPT_6CO:
+      PRINTF("Processing 6CO option in RA\n");
+      /* Contexts longer than 64 bits are not supported; skip them */
+      if(UIP_ND6_OPT_6CO_BUF->len >= UIP_ND6_OPT_6CO_LEN >> 3 &&
+         UIP_ND6_OPT_6CO_BUF->context_length <= 64) {
+        uint8_t cid = UIP_ND6_OPT_6CO_BUF->flags_cid & UIP_ND6_RA_6CO_CID_MASK;
+        if(UIP_ND6_OPT_6CO_BUF->lifetime == 0) {
+          sicslowpan_context_remove(cid);
+        } else {
+          sicslowpan_context_set(cid, UIP_ND6_OPT_6CO_BUF->prefix,
+                                 UIP_ND6_OPT_6CO_BUF->context_length,
+                                 UIP_ND6_OPT_6CO_BUF->flags_cid &
+                                 UIP_ND6_RA_FLAG_6CO_C,
+                                 uip_ntohs(UIP_ND6_OPT_6CO_BUF->lifetime) *
+                                 60UL);
+        }
+      }
+      break;
+#endif /* UIP_ND6_6CO */
     default:
       PRINTF("ND option not supported in RA");
       break;
@@ -1003,6 +1054,7 @@ ra_input(void)
     } else {
       stimer_set(&(defrt->lifetime),
                  (unsigned long)(uip_ntohs(UIP_ND6_RA_BUF->router_lifetime)));
+      uip_ds6_wakeup_stimer(&defrt->lifetime);
     }
   } else {
     if(defrt != NULL) {
@@ -1012,18 +1064,9 @@ ra_input(void)
 
 #if UIP_CONF_IPV6_QUEUE_PKT
   /* If the nbr just became reachable (e.g. it was in NBR_INCOMPLETE state
-   * and we got a SLLAO), check if we had buffered a pkt for it */
-  /*  if((nbr != NULL) && (nbr->queue_buf_len != 0)) {
-    uip_len = nbr->queue_buf_len;
-    memcpy(UIP_IP_BUF, nbr->queue_buf, uip_len);
-    nbr->queue_buf_len = 0;
-    return;
-    }*/
-  if(nbr != NULL && uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
-    return;
+   * and we got a SLLAO), send what we had buffered for it */
+  if(nbr != NULL) {
+    uip_ds6_nbr_send_queued(nbr);
   }
 
 #endif /*UIP_CONF_IPV6_QUEUE_PKT */
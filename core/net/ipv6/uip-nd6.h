@@ -155,6 +155,19 @@
 #endif
 /** @} */
 
+/** \name RFC 6775 6LoWPAN Context Option Constants */
+/** @{ */
+/** \brief Advertise and learn 6LoWPAN compression contexts in RAs */
+#ifndef UIP_CONF_ND6_6CO
+#define UIP_ND6_6CO                     UIP_CONF_LL_802154
+#else
+#define UIP_ND6_6CO                     UIP_CONF_ND6_6CO
+#endif
+
+#define UIP_ND6_RA_FLAG_6CO_C           0x10
+#define UIP_ND6_RA_6CO_CID_MASK         0x0F
+/** @} */
+
 
 /** \name ND6 option types */
 /** @{ */
@@ -165,6 +178,7 @@
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_6CO                 34
 /** @} */
 
 /** \name ND6 option types */
@@ -189,6 +203,7 @@
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_6CO_LEN            16
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -320,6 +335,17 @@ typedef struct uip_nd6_opt_dns {
   uip_ipaddr_t ip;
 } uip_nd6_opt_dns;
 
+/** \brief ND option 6LoWPAN context (RFC 6775) */
+typedef struct uip_nd6_opt_6co {
+  uint8_t type;
+  uint8_t len;
+  uint8_t context_length;
+  uint8_t flags_cid;
+  uint16_t reserved;
+  uint16_t lifetime;
+  uint8_t prefix[8];
+} uip_nd6_opt_6co;
+
 /** \struct Redirected header option */
 typedef struct uip_nd6_opt_redirected_hdr {
   uint8_t type;
@@ -43,12 +43,14 @@
 
 #include "sys/ctimer.h"
 #include "sys/clock.h"
+#include "sys/trace.h"
 
 #include "lib/random.h"
 
 #include "net/netstack.h"
+#include "net/nbr-table.h"
 
-#include "lib/list.h"
+#include "lib/dlist.h"
 #include "lib/memb.h"
 
 #include <string.h>
@@ -88,26 +90,31 @@
 struct qbuf_metadata {
   mac_callback_t sent;
   void *cptr;
+#if CSMA_STATS
+  clock_time_t enqueued;
+#endif /* CSMA_STATS */
   uint8_t max_transmissions;
 };
 
-/* Every neighbor has its own packet queue */
+/* Every neighbor has its own packet queue, kept in a neighbor table
+   entry so that it can be found without searching. */
 struct neighbor_queue {
   struct neighbor_queue *next;
-  linkaddr_t addr;
+  struct neighbor_queue *prev;
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions, deferrals;
-  LIST_STRUCT(queued_packet_list);
+  /* Number of packets in queued_packet_list. */
+  uint8_t length;
+  /* Remaining transmission credit in the deficit round-robin
+     scheduler, in bytes. */
+  int16_t deficit;
+#if CSMA_STATS
+  struct csma_queue_stats stats;
+#endif /* CSMA_STATS */
+  DLIST_STRUCT(queued_packet_list);
 };
 
-/* The maximum number of co-existing neighbor queues */
-#ifdef CSMA_CONF_MAX_NEIGHBOR_QUEUES
-#define CSMA_MAX_NEIGHBOR_QUEUES CSMA_CONF_MAX_NEIGHBOR_QUEUES
-#else
-#define CSMA_MAX_NEIGHBOR_QUEUES 2
-#endif /* CSMA_CONF_MAX_NEIGHBOR_QUEUES */
-
 /* The maximum number of pending packet per neighbor */
 #ifdef CSMA_CONF_MAX_PACKET_PER_NEIGHBOR
 #define CSMA_MAX_PACKET_PER_NEIGHBOR CSMA_CONF_MAX_PACKET_PER_NEIGHBOR
@@ -115,28 +122,33 @@ struct neighbor_queue {
 #define CSMA_MAX_PACKET_PER_NEIGHBOR MAX_QUEUED_PACKETS
 #endif /* CSMA_CONF_MAX_PACKET_PER_NEIGHBOR */
 
+/* The number of bytes a neighbor queue may send each time it is
+   visited by the round-robin scheduler. The default allows one
+   full-sized 802.15.4 frame per round. */
+#ifdef CSMA_CONF_DRR_QUANTUM
+#define CSMA_DRR_QUANTUM CSMA_CONF_DRR_QUANTUM
+#else
+#define CSMA_DRR_QUANTUM 127
+#endif /* CSMA_CONF_DRR_QUANTUM */
+
 #define MAX_QUEUED_PACKETS QUEUEBUF_NUM
-MEMB(neighbor_memb, struct neighbor_queue, CSMA_MAX_NEIGHBOR_QUEUES);
+NBR_TABLE(struct neighbor_queue, neighbor_queues);
 MEMB(packet_memb, struct rdc_buf_list, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
-LIST(neighbor_list);
+
+/* Broadcast frames have their own queue. It is kept out of the
+   neighbor table, where linkaddr_null may also be the key of an entry
+   that another layer has not yet bound to an address. */
+static struct neighbor_queue broadcast_queue;
+
+/* Neighbor queues that have a packet ready for transmission, in
+   round-robin order. */
+DLIST(ready_list);
+static struct ctimer scheduler_timer;
 
 static void packet_sent(void *ptr, int status, int num_transmissions);
 static void transmit_packet_list(void *ptr);
 
-/*---------------------------------------------------------------------------*/
-static struct neighbor_queue *
-neighbor_queue_from_addr(const linkaddr_t *addr)
-{
-  struct neighbor_queue *n = list_head(neighbor_list);
-  while(n != NULL) {
-    if(linkaddr_cmp(&n->addr, addr)) {
-      return n;
-    }
-    n = list_item_next(n);
-  }
-  return NULL;
-}
 /*---------------------------------------------------------------------------*/
 static clock_time_t
 default_timebase(void)
@@ -155,34 +167,97 @@ default_timebase(void)
   return time;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Deficit round-robin over the neighbor queues that are ready to
+ * transmit. Every attempt, including retransmissions, is charged to
+ * the neighbor's deficit, so that a neighbor that needs many
+ * retransmissions cannot hold back the others. One packet is handed to
+ * the RDC layer per invocation.
+ */
+static void
+run_scheduler(void *ptr)
+{
+  struct neighbor_queue *n;
+  struct rdc_buf_list *q;
+  int len;
+
+  while((n = dlist_head(ready_list)) != NULL) {
+    q = dlist_head(n->queued_packet_list);
+    if(q == NULL) {
+      dlist_remove(ready_list, n);
+      continue;
+    }
+    len = queuebuf_datalen(q->buf);
+    if(n->deficit < len) {
+      /* Not enough credit: top up and move to the end of the round. */
+      n->deficit += CSMA_DRR_QUANTUM;
+      dlist_add(ready_list, n);
+      if(n->deficit < len || dlist_head(ready_list) != n) {
+        continue;
+      }
+    }
+    n->deficit -= len;
+    dlist_remove(ready_list, n);
+
+    PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
+           n->length);
+    /* Send packets in the neighbor's list */
+    TRACE(TRACE_MODULE_MAC, TRACE_EVENT_DEQUEUE, n->length);
+    NETSTACK_RDC.send_list(packet_sent, n, q);
+    break;
+  }
+
+  if(dlist_head(ready_list) != NULL) {
+    ctimer_set(&scheduler_timer, 0, run_scheduler, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 transmit_packet_list(void *ptr)
 {
   struct neighbor_queue *n = ptr;
   if(n) {
-    struct rdc_buf_list *q = list_head(n->queued_packet_list);
-    if(q != NULL) {
-      PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
-          list_length(n->queued_packet_list));
-      /* Send packets in the neighbor's list */
-      NETSTACK_RDC.send_list(packet_sent, n, q);
+    /* The neighbor's backoff is over: queue it for the scheduler */
+    dlist_add(ready_list, n);
+    if(ctimer_expired(&scheduler_timer)) {
+      ctimer_set(&scheduler_timer, 0, run_scheduler, NULL);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
-free_packet(struct neighbor_queue *n, struct rdc_buf_list *p)
+free_packet(struct neighbor_queue *n, struct rdc_buf_list *p, int status)
 {
+#if CSMA_STATS
+  struct qbuf_metadata *metadata;
+  clock_time_t latency;
+#endif /* CSMA_STATS */
+
   if(p != NULL) {
+#if CSMA_STATS
+    metadata = (struct qbuf_metadata *)p->ptr;
+    if(status == MAC_TX_OK) {
+      n->stats.sent++;
+      latency = clock_time() - metadata->enqueued;
+      n->stats.latency_sum += latency;
+      if(latency > n->stats.latency_max) {
+        n->stats.latency_max = latency;
+      }
+    } else {
+      n->stats.dropped++;
+    }
+#endif /* CSMA_STATS */
+
     /* Remove packet from list and deallocate */
-    list_remove(n->queued_packet_list, p);
+    dlist_remove(n->queued_packet_list, p);
+    n->length--;
 
     queuebuf_free(p->buf);
     memb_free(&metadata_memb, p->ptr);
     memb_free(&packet_memb, p);
     PRINTF("csma: free_queued_packet, queue length %d, free packets %d\n",
-           list_length(n->queued_packet_list), memb_numfree(&packet_memb));
-    if(list_head(n->queued_packet_list) != NULL) {
+           n->length, memb_numfree(&packet_memb));
+    if(dlist_head(n->queued_packet_list) != NULL) {
       /* There is a next packet. We reset current tx information */
       n->transmissions = 0;
       n->collisions = 0;
@@ -191,10 +266,14 @@ free_packet(struct neighbor_queue *n, struct rdc_buf_list *p)
       ctimer_set(&n->transmit_timer, default_timebase(),
                  transmit_packet_list, n);
     } else {
-      /* This was the last packet in the queue, we free the neighbor */
+      /* This was the last packet in the queue. The entry may now be
+         reused by the neighbor table. */
       ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
+      dlist_remove(ready_list, n);
+      n->deficit = 0;
+      if(n != &broadcast_queue) {
+        nbr_table_unlock(neighbor_queues, n);
+      }
     }
   }
 }
@@ -216,6 +295,7 @@ packet_sent(void *ptr, int status, int num_transmissions)
   if(n == NULL) {
     return;
   }
+  TRACE(TRACE_MODULE_MAC, TRACE_EVENT_DONE, status);
   switch(status) {
   case MAC_TX_OK:
   case MAC_TX_NOACK:
@@ -230,8 +310,8 @@ packet_sent(void *ptr, int status, int num_transmissions)
   }
 
   /* Find out what packet this callback refers to */
-  for(q = list_head(n->queued_packet_list);
-      q != NULL; q = list_item_next(q)) {
+  for(q = dlist_head(n->queued_packet_list);
+      q != NULL; q = dlist_item_next(q)) {
     if(queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO) ==
        packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO)) {
       break;
@@ -293,7 +373,8 @@ packet_sent(void *ptr, int status, int num_transmissions)
         } else {
           PRINTF("csma: drop with status %d after %d transmissions, %d collisions\n",
                  status, n->transmissions, n->collisions);
-          free_packet(n, q);
+          TRACE(TRACE_MODULE_MAC, TRACE_EVENT_DROP, status);
+          free_packet(n, q, status);
           mac_call_sent_callback(sent, cptr, status, num_tx);
         }
       } else {
@@ -302,7 +383,7 @@ packet_sent(void *ptr, int status, int num_transmissions)
         } else {
           PRINTF("csma: rexmit failed %d: %d\n", n->transmissions, status);
         }
-        free_packet(n, q);
+        free_packet(n, q, status);
         mac_call_sent_callback(sent, cptr, status, num_tx);
       }
     } else {
@@ -313,6 +394,15 @@ packet_sent(void *ptr, int status, int num_transmissions)
   }
 }
 /*---------------------------------------------------------------------------*/
+static struct neighbor_queue *
+neighbor_queue_lookup(const linkaddr_t *addr)
+{
+  if(linkaddr_cmp(addr, &linkaddr_null)) {
+    return &broadcast_queue;
+  }
+  return nbr_table_get_from_lladdr(neighbor_queues, addr);
+}
+/*---------------------------------------------------------------------------*/
 static void
 send_packet(mac_callback_t sent, void *ptr)
 {
@@ -336,26 +426,20 @@ send_packet(mac_callback_t sent, void *ptr)
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno++);
 
   /* Look for the neighbor entry */
-  n = neighbor_queue_from_addr(addr);
+  n = neighbor_queue_lookup(addr);
   if(n == NULL) {
     /* Allocate a new neighbor entry */
-    n = memb_alloc(&neighbor_memb);
+    n = nbr_table_add_lladdr(neighbor_queues, addr);
     if(n != NULL) {
-      /* Init neighbor entry */
-      linkaddr_copy(&n->addr, addr);
-      n->transmissions = 0;
-      n->collisions = 0;
-      n->deferrals = 0;
-      /* Init packet list for this neighbor */
-      LIST_STRUCT_INIT(n, queued_packet_list);
-      /* Add neighbor to the list */
-      list_add(neighbor_list, n);
+      /* Init packet list for this neighbor. The rest of the entry has
+         been zeroed by the neighbor table. */
+      DLIST_STRUCT_INIT(n, queued_packet_list);
     }
   }
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
-    if(list_length(n->queued_packet_list) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    if(n->length < CSMA_MAX_PACKET_PER_NEIGHBOR) {
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -373,21 +457,37 @@ send_packet(mac_callback_t sent, void *ptr)
             }
             metadata->sent = sent;
             metadata->cptr = ptr;
+#if CSMA_STATS
+            metadata->enqueued = clock_time();
+#endif /* CSMA_STATS */
 #if PACKETBUF_WITH_PACKET_TYPE
             if(packetbuf_attr(PACKETBUF_ATTR_PACKET_TYPE) ==
                PACKETBUF_ATTR_PACKET_TYPE_ACK) {
-              list_push(n->queued_packet_list, q);
+              dlist_push(n->queued_packet_list, q);
             } else
 #endif
             {
-              list_add(n->queued_packet_list, q);
+              dlist_add(n->queued_packet_list, q);
             }
+            n->length++;
+            TRACE(TRACE_MODULE_MAC, TRACE_EVENT_ENQUEUE, n->length);
+#if CSMA_STATS
+            n->stats.enqueued++;
+            if(n->length > n->stats.max_depth) {
+              n->stats.max_depth = n->length;
+            }
+#endif /* CSMA_STATS */
 
             PRINTF("csma: send_packet, queue length %d, free packets %d\n",
-                   list_length(n->queued_packet_list), memb_numfree(&packet_memb));
+                   n->length, memb_numfree(&packet_memb));
             /* If q is the first packet in the neighbor's queue, send asap */
-            if(list_head(n->queued_packet_list) == q) {
-              ctimer_set(&n->transmit_timer, 0, transmit_packet_list, n);
+            if(dlist_head(n->queued_packet_list) == q) {
+              /* The neighbor must not be evicted from the table while
+                 it has packets queued. */
+              if(n != &broadcast_queue) {
+                nbr_table_lock(neighbor_queues, n);
+              }
+              transmit_packet_list(n);
             }
             return;
           }
@@ -397,24 +497,39 @@ send_packet(mac_callback_t sent, void *ptr)
         memb_free(&packet_memb, q);
         PRINTF("csma: could not allocate queuebuf, dropping packet\n");
       }
-      /* The packet allocation failed. Remove and free neighbor entry if empty. */
-      if(list_length(n->queued_packet_list) == 0) {
-        list_remove(neighbor_list, n);
-        memb_free(&neighbor_memb, n);
-      }
     } else {
       PRINTF("csma: Neighbor queue full\n");
     }
+#if CSMA_STATS
+    n->stats.dropped++;
+#endif /* CSMA_STATS */
     PRINTF("csma: could not allocate packet, dropping packet\n");
   } else {
     PRINTF("csma: could not allocate neighbor, dropping packet\n");
   }
+  TRACE(TRACE_MODULE_MAC, TRACE_EVENT_DROP, MAC_TX_ERR);
   mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_STATS
+const struct csma_queue_stats *
+csma_queue_stats(const linkaddr_t *addr)
+{
+  struct neighbor_queue *n;
+
+  n = neighbor_queue_lookup(addr);
+  if(n == NULL) {
+    return NULL;
+  }
+  n->stats.depth = n->length;
+  return &n->stats;
+}
+#endif /* CSMA_STATS */
+/*---------------------------------------------------------------------------*/
 static void
 input_packet(void)
 {
+  TRACE(TRACE_MODULE_MAC, TRACE_EVENT_IN, packetbuf_datalen());
   NETSTACK_LLSEC.input();
 }
 /*---------------------------------------------------------------------------*/
@@ -444,7 +559,8 @@ init(void)
 {
   memb_init(&packet_memb);
   memb_init(&metadata_memb);
-  memb_init(&neighbor_memb);
+  nbr_table_register(neighbor_queues, NULL);
+  DLIST_STRUCT_INIT(&broadcast_queue, queued_packet_list);
 }
 /*---------------------------------------------------------------------------*/
 const struct mac_driver csma_driver = {
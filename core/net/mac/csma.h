@@ -43,9 +43,39 @@
 
 #include "net/mac/mac.h"
 #include "dev/radio.h"
+#include "net/linkaddr.h"
+#include "sys/clock.h"
+
+/* Per-neighbor queue statistics cost RAM in every neighbor table
+   entry, and are off by default. */
+#ifdef CSMA_CONF_STATS
+#define CSMA_STATS CSMA_CONF_STATS
+#else
+#define CSMA_STATS 0
+#endif /* CSMA_CONF_STATS */
 
 extern const struct mac_driver csma_driver;
 
 const struct mac_driver *csma_init(const struct mac_driver *r);
 
+#if CSMA_STATS
+/* Statistics for the packet queue of one neighbor. Latencies are
+   measured from enqueueing to the final ACK, in clock ticks. */
+struct csma_queue_stats {
+  unsigned long enqueued, sent, dropped;
+  unsigned long latency_sum;
+  clock_time_t latency_max;
+  uint8_t depth, max_depth;
+};
+
+/**
+ * \brief      Get the queue statistics of a neighbor
+ * \param addr The link-layer address of the neighbor, or linkaddr_null
+ *             for the broadcast queue
+ * \return     A pointer to the statistics, or NULL if CSMA has no
+ *             queue for the neighbor
+ */
+const struct csma_queue_stats *csma_queue_stats(const linkaddr_t *addr);
+#endif /* CSMA_STATS */
+
 #endif /* CSMA_H_ */
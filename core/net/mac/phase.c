@@ -44,16 +44,46 @@
 #include "net/queuebuf.h"
 #include "net/nbr-table.h"
 
-#if PHASE_CONF_DRIFT_CORRECT
+#include <string.h>
+
+#ifdef PHASE_CONF_DRIFT_CORRECT
 #define PHASE_DRIFT_CORRECT PHASE_CONF_DRIFT_CORRECT
 #else
-#define PHASE_DRIFT_CORRECT 0
+#define PHASE_DRIFT_CORRECT 1
 #endif
 
+/* The drift estimate is kept in fixed point, with PHASE_DRIFT_SHIFT
+   fractional bits, as rtimer ticks per cycle. */
+#define PHASE_DRIFT_SHIFT     8
+#define PHASE_DRIFT_MAX       (64L << PHASE_DRIFT_SHIFT)
+
+/* A new drift sample is only taken when at least this many cycles
+   have passed since the last phase lock, since the jitter of a single
+   encounter otherwise dominates the estimate. */
+#define PHASE_DRIFT_MIN_CYCLES 8
+
+/* The phase is not predicted beyond this age, since the coarse clock
+   used to count rtimer wraps would overflow. The age is measured in
+   clock_time_t, so it is capped at half the range of the clock: about
+   four minutes on platforms with a 16-bit clock at 128 Hz. */
+#define PHASE_MAX_AGE_WANTED  (CLOCK_SECOND * 60UL * 30)
+#define PHASE_CLOCK_HALF_SPAN \
+  ((unsigned long)(clock_time_t)~(clock_time_t)0 / 2)
+#define PHASE_MAX_AGE         (PHASE_MAX_AGE_WANTED < PHASE_CLOCK_HALF_SPAN ? \
+                               PHASE_MAX_AGE_WANTED : PHASE_CLOCK_HALF_SPAN)
+
+#define PHASE_FLAG_PREDICTED  0x01
+#define PHASE_FLAG_DRIFT      0x02
+
 struct phase {
   rtimer_clock_t time;
 #if PHASE_DRIFT_CORRECT
-  rtimer_clock_t drift;
+  clock_time_t clock;
+  rtimer_clock_t predicted;
+  rtimer_clock_t cycle_time;
+  uint16_t error;
+  int32_t drift;
+  uint8_t flags;
 #endif
   uint8_t noacks;
   struct timer noacks_timer;
@@ -77,6 +107,10 @@ struct phase_queueitem {
 MEMB(queued_packets_memb, struct phase_queueitem, PHASE_QUEUESIZE);
 NBR_TABLE(struct phase, nbr_phase);
 
+#if PHASE_STATS
+struct phase_stats phase_stats;
+#endif /* PHASE_STATS */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -87,6 +121,107 @@ NBR_TABLE(struct phase, nbr_phase);
 #define PRINTDEBUG(...)
 #endif
 /*---------------------------------------------------------------------------*/
+#if PHASE_DRIFT_CORRECT
+/*
+ * Compute the number of rtimer ticks since the last phase lock. The
+ * rtimer wraps around every few seconds on most platforms, so the
+ * coarse clock is used to count the number of wraps and the rtimer
+ * provides the fine-grained part. Returns 0 if the entry is too old.
+ */
+static uint32_t
+elapsed_ticks(const struct phase *e, rtimer_clock_t now)
+{
+  clock_time_t diff;
+  uint32_t coarse, span, candidate;
+  rtimer_clock_t fine;
+
+  fine = now - e->time;
+  diff = clock_time() - e->clock;
+  if(diff > PHASE_MAX_AGE) {
+    return 0;
+  }
+  if(sizeof(rtimer_clock_t) >= sizeof(uint32_t)) {
+    return fine;
+  }
+
+  coarse = (uint32_t)(diff / CLOCK_SECOND) * RTIMER_ARCH_SECOND +
+    (uint32_t)(diff % CLOCK_SECOND) * RTIMER_ARCH_SECOND / CLOCK_SECOND;
+
+  /* Snap the coarse estimate onto the closest value that agrees with
+     the rtimer modulo its width. */
+  span = (uint32_t)(rtimer_clock_t)~0 + 1;
+  candidate = (coarse & ~(span - 1)) | fine;
+  if(candidate > coarse + span / 2 && candidate >= span) {
+    candidate -= span;
+  } else if(candidate + span / 2 < coarse) {
+    candidate += span;
+  }
+  return candidate;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_drift(struct phase *e, rtimer_clock_t time)
+{
+  uint32_t elapsed, cycles;
+  int32_t residual, sample;
+  rtimer_clock_t error;
+
+  if(e->flags & PHASE_FLAG_PREDICTED) {
+    /* The ACK time tells us how far off the prediction made in
+       phase_wait() was. */
+    if(RTIMER_CLOCK_LT(time, e->predicted)) {
+      error = e->predicted - time;
+    } else {
+      error = time - e->predicted;
+    }
+    e->error = (3 * (uint32_t)e->error + error) / 4;
+    PHASE_STATS_ADD(hits);
+    PHASE_STATS_ADD_N(error_sum, error);
+#if PHASE_STATS
+    if(error > phase_stats.error_max) {
+      phase_stats.error_max = error;
+    }
+#endif /* PHASE_STATS */
+  }
+
+  if(e->cycle_time == 0) {
+    return;
+  }
+  elapsed = elapsed_ticks(e, time);
+  cycles = (elapsed + e->cycle_time / 2) / e->cycle_time;
+  if(cycles < PHASE_DRIFT_MIN_CYCLES) {
+    return;
+  }
+
+  /* The residual is how far the neighbor's phase has moved relative
+     to ours during the elapsed cycles. */
+  residual = (int32_t)(elapsed - cycles * e->cycle_time);
+  sample = (residual * (1L << PHASE_DRIFT_SHIFT)) / (int32_t)cycles;
+  if(e->flags & PHASE_FLAG_DRIFT) {
+    sample = (3 * e->drift + sample) / 4;
+  }
+  /* Real clock drift is a few ticks per cycle at most; anything beyond
+     PHASE_DRIFT_MAX is a misdetected phase, so we clamp it. */
+  if(sample > PHASE_DRIFT_MAX) {
+    sample = PHASE_DRIFT_MAX;
+  } else if(sample < -PHASE_DRIFT_MAX) {
+    sample = -PHASE_DRIFT_MAX;
+  }
+  e->drift = sample;
+  e->flags |= PHASE_FLAG_DRIFT;
+}
+#endif /* PHASE_DRIFT_CORRECT */
+/*---------------------------------------------------------------------------*/
+static void
+set_phase(struct phase *e, rtimer_clock_t time)
+{
+  e->time = time;
+#if PHASE_DRIFT_CORRECT
+  e->clock = clock_time();
+  e->flags &= ~PHASE_FLAG_PREDICTED;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 void
 phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
              int mac_status)
@@ -98,21 +233,23 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
   if(e != NULL) {
     if(mac_status == MAC_TX_OK) {
 #if PHASE_DRIFT_CORRECT
-      e->drift = time-e->time;
+      update_drift(e, time);
 #endif
-      e->time = time;
+      set_phase(e, time);
     }
     /* If the neighbor didn't reply to us, it may have switched
        phase (rebooted). We try a number of transmissions to it
        before we drop it from the phase list. */
     if(mac_status == MAC_TX_NOACK) {
       PRINTF("phase noacks %d to %d.%d\n", e->noacks, neighbor->u8[0], neighbor->u8[1]);
+      PHASE_STATS_ADD(misses);
       e->noacks++;
       if(e->noacks == 1) {
         timer_set(&e->noacks_timer, MAX_NOACKS_TIME);
       }
       if(e->noacks >= MAX_NOACKS || timer_expired(&e->noacks_timer)) {
         PRINTF("drop %d\n", neighbor->u8[0]);
+        PHASE_STATS_ADD(drops);
         nbr_table_remove(nbr_phase, e);
         return;
       }
@@ -124,16 +261,30 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
     if(mac_status == MAC_TX_OK && e == NULL) {
       e = nbr_table_add_lladdr(nbr_phase, neighbor);
       if(e) {
-        e->time = time;
 #if PHASE_DRIFT_CORRECT
-      e->drift = 0;
+        e->drift = 0;
+        e->error = 0;
+        e->flags = 0;
+        e->cycle_time = 0;
 #endif
-      e->noacks = 0;
+        set_phase(e, time);
+        e->noacks = 0;
       }
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+phase_remove(const linkaddr_t *neighbor)
+{
+  struct phase *e;
+
+  e = nbr_table_get_from_lladdr(nbr_phase, neighbor);
+  if(e != NULL) {
+    nbr_table_remove(nbr_phase, e);
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 send_packet(void *ptr)
 {
@@ -166,6 +317,9 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
   if(e != NULL) {
     rtimer_clock_t wait, now, expected, sync;
     clock_time_t ctimewait;
+#if PHASE_DRIFT_CORRECT
+    uint32_t elapsed;
+#endif
     
     /* We expect phases to happen every CYCLE_TIME time
        units. The next expected phase is at time e->time +
@@ -174,24 +328,25 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
        on the radio within the CYCLE_TIME period, we compute the
        waiting time with modulo CYCLE_TIME. */
     
-    /*      printf("neighbor phase 0x%02x (cycle 0x%02x)\n", e->time & (cycle_time - 1),
-            cycle_time);*/
-
-    /*      if(e->noacks > 0) {
-            printf("additional wait %d\n", additional_wait);
-            }*/
-    
     now = RTIMER_NOW();
 
-    sync = (e == NULL) ? now : e->time;
+    sync = e->time;
 
 #if PHASE_DRIFT_CORRECT
-    {
-      int32_t s;
-      if(e->drift > cycle_time) {
-        s = e->drift % cycle_time / (e->drift / cycle_time);  /* drift per cycle */
-        s = s * (now - sync) / cycle_time;                    /* estimated drift to now */
-        sync += s;                                            /* add it in */
+    e->cycle_time = cycle_time;
+    elapsed = elapsed_ticks(e, now);
+    if((e->flags & PHASE_FLAG_DRIFT) && elapsed > 0) {
+      /* Move the last known phase by the drift that is expected to
+         have accumulated since then. */
+      sync += (rtimer_clock_t)((e->drift * (int32_t)(elapsed / cycle_time)) >>
+                               PHASE_DRIFT_SHIFT);
+
+      /* With a good prediction, we do not need to start strobing as
+         early as we do for an unknown drift. The guard window is
+         shrunk down to a quarter of its size plus twice the average
+         prediction error. */
+      if((uint32_t)guard_time / 4 + 2 * (uint32_t)e->error < guard_time) {
+        guard_time = guard_time / 4 + 2 * e->error;
       }
     }
 #endif
@@ -209,6 +364,12 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
       wait += cycle_time;
     }
 
+    PHASE_STATS_ADD(predictions);
+#if PHASE_DRIFT_CORRECT
+    e->predicted = now + wait;
+    e->flags |= PHASE_FLAG_PREDICTED;
+#endif
+
     ctimewait = (CLOCK_SECOND * (wait - guard_time)) / RTIMER_ARCH_SECOND;
 
     if(ctimewait > PHASE_DEFER_THRESHOLD) {
@@ -239,9 +400,30 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
 }
 /*---------------------------------------------------------------------------*/
 void
+phase_strobes(int is_known_receiver, int strobes)
+{
+  if(is_known_receiver) {
+    PHASE_STATS_ADD(tx_known);
+    PHASE_STATS_ADD_N(strobes_known, strobes);
+  } else {
+    PHASE_STATS_ADD(tx_unknown);
+    PHASE_STATS_ADD_N(strobes_unknown, strobes);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+phase_stats_reset(void)
+{
+#if PHASE_STATS
+  memset(&phase_stats, 0, sizeof(phase_stats));
+#endif /* PHASE_STATS */
+}
+/*---------------------------------------------------------------------------*/
+void
 phase_init(void)
 {
   memb_init(&queued_packets_memb);
   nbr_table_register(nbr_phase, NULL);
+  phase_stats_reset();
 }
 /*---------------------------------------------------------------------------*/
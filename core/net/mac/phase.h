@@ -53,6 +53,39 @@ typedef enum {
   PHASE_DEFERRED,
 } phase_status_t;
 
+#ifdef PHASE_CONF_STATS
+#define PHASE_STATS PHASE_CONF_STATS
+#else /* PHASE_CONF_STATS */
+#define PHASE_STATS 0
+#endif /* PHASE_CONF_STATS */
+
+struct phase_stats {
+  /* Transmissions to neighbors with a known phase, and how many of
+     them got an ACK within the phase window. */
+  unsigned long predictions, hits, misses;
+  /* Sum and maximum of the absolute prediction error, in rtimer ticks. */
+  unsigned long error_sum;
+  unsigned long error_max;
+  /* Number of strobes sent to neighbors with known and unknown phase. */
+  unsigned long strobes_known, strobes_unknown;
+  unsigned long tx_known, tx_unknown;
+  /* Neighbors dropped from the phase table after too many NOACKs. */
+  unsigned long drops;
+};
+
+#if PHASE_STATS
+/* Don't access this variable directly, use PHASE_STATS_ADD and PHASE_STATS_GET */
+extern struct phase_stats phase_stats;
+
+#define PHASE_STATS_ADD(x) phase_stats.x++
+#define PHASE_STATS_ADD_N(x, n) phase_stats.x += (n)
+#define PHASE_STATS_GET(x) phase_stats.x
+#else /* PHASE_STATS */
+#define PHASE_STATS_ADD(x)
+#define PHASE_STATS_ADD_N(x, n)
+#define PHASE_STATS_GET(x) 0
+#endif /* PHASE_STATS */
+
 
 void phase_init(void);
 phase_status_t phase_wait(const linkaddr_t *neighbor,
@@ -62,5 +95,7 @@ phase_status_t phase_wait(const linkaddr_t *neighbor,
 void phase_update(const linkaddr_t *neighbor,
                   rtimer_clock_t time, int mac_status);
 void phase_remove(const linkaddr_t *neighbor);
+void phase_strobes(int is_known_receiver, int strobes);
+void phase_stats_reset(void);
 
 #endif /* PHASE_H */
@@ -62,6 +62,11 @@ static unsigned num_tables;
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
 
+/* The key that was last looked up. The same neighbor is typically
+   looked up by several layers for each packet, so this saves most of
+   the list walks. */
+static nbr_table_key_t *last_key;
+
 /*---------------------------------------------------------------------------*/
 /* Get a key from a neighbor index */
 static nbr_table_key_t *
@@ -115,9 +120,13 @@ index_from_lladdr(const linkaddr_t *lladdr)
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
+  if(last_key != NULL && linkaddr_cmp(lladdr, &last_key->lladdr)) {
+    return index_from_key(last_key);
+  }
   key = list_head(nbr_table_keys);
   while(key != NULL) {
     if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
+      last_key = key;
       return index_from_key(key);
     }
     key = list_item_next(key);
@@ -218,6 +227,9 @@ nbr_table_allocate(void)
       used_map[index_from_key(least_used_key)] = 0;
       /* Remove neighbor from list */
       list_remove(nbr_table_keys, least_used_key);
+      if(last_key == least_used_key) {
+        last_key = NULL;
+      }
       /* Return associated key */
       return least_used_key;
     }
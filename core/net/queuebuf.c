@@ -55,6 +55,7 @@
 struct queuebuf {
 #if QUEUEBUF_DEBUG
   struct queuebuf *next;
+  struct queuebuf *prev;
   const char *file;
   int line;
   clock_time_t time;
@@ -112,8 +113,8 @@ static struct ctimer renew_timer;
 #endif
 
 #if QUEUEBUF_DEBUG
-#include "lib/list.h"
-LIST(queuebuf_list);
+#include "lib/dlist.h"
+DLIST(queuebuf_list);
 #endif /* QUEUEBUF_DEBUG */
 
 #define DEBUG 0
@@ -313,7 +314,7 @@ queuebuf_new_from_packetbuf(void)
   buf = memb_alloc(&bufmem);
   if(buf != NULL) {
 #if QUEUEBUF_DEBUG
-    list_add(queuebuf_list, buf);
+    dlist_add(queuebuf_list, buf);
     buf->file = file;
     buf->line = line;
     buf->time = clock_time();
@@ -410,7 +411,7 @@ queuebuf_free(struct queuebuf *buf)
     PRINTF("#A q=%d\n", queuebuf_len);
 #endif /* QUEUEBUF_STATS */
 #if QUEUEBUF_DEBUG
-    list_remove(queuebuf_list, buf);
+    dlist_remove(queuebuf_list, buf);
 #endif /* QUEUEBUF_DEBUG */
   }
 }
@@ -462,8 +463,8 @@ queuebuf_debug_print(void)
 #if QUEUEBUF_DEBUG
   struct queuebuf *q;
   printf("queuebuf_list: ");
-  for(q = list_head(queuebuf_list); q != NULL;
-      q = list_item_next(q)) {
+  for(q = dlist_head(queuebuf_list); q != NULL;
+      q = dlist_item_next(q)) {
     printf("%s,%d,%lu ", q->file, q->line, q->time);
   }
   printf("\n");
@@ -53,6 +53,7 @@
 #include "net/rpl/rpl-private.h"
 #include "net/packetbuf.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "sys/trace.h"
 
 #include <limits.h>
 #include <string.h>
@@ -153,6 +154,8 @@ dis_input(void)
   rpl_instance_t *instance;
   rpl_instance_t *end;
 
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_IN, RPL_CODE_DIS);
+
   /* DAG Information Solicitation */
   PRINTF("RPL: Received a DIS from ");
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
@@ -205,6 +208,7 @@ dis_output(uip_ipaddr_t *addr)
   PRINT6ADDR(addr);
   PRINTF("\n");
 
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DIS);
   uip_icmp6_send(addr, ICMP6_RPL, RPL_CODE_DIS, 2);
 }
 /*---------------------------------------------------------------------------*/
@@ -220,6 +224,8 @@ dio_input(void)
   uip_ipaddr_t from;
   uip_ds6_nbr_t *nbr;
 
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_IN, RPL_CODE_DIO);
+
   memset(&dio, 0, sizeof(dio));
 
   /* Set default values in case the DIO configuration option is missing. */
@@ -557,6 +563,7 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
       (unsigned)dag->rank);
   PRINT6ADDR(uc_addr);
   PRINTF("\n");
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DIO);
   uip_icmp6_send(uc_addr, ICMP6_RPL, RPL_CODE_DIO, pos);
 #else /* RPL_LEAF_ONLY */
   /* Unicast requests get unicast replies! */
@@ -564,12 +571,14 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
     PRINTF("RPL: Sending a multicast-DIO with rank %u\n",
         (unsigned)instance->current_dag->rank);
     uip_create_linklocal_rplnodes_mcast(&addr);
+    TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DIO);
     uip_icmp6_send(&addr, ICMP6_RPL, RPL_CODE_DIO, pos);
   } else {
     PRINTF("RPL: Sending unicast-DIO with rank %u to ",
         (unsigned)instance->current_dag->rank);
     PRINT6ADDR(uc_addr);
     PRINTF("\n");
+    TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DIO);
     uip_icmp6_send(uc_addr, ICMP6_RPL, RPL_CODE_DIO, pos);
   }
 #endif /* RPL_LEAF_ONLY */
@@ -602,6 +611,8 @@ dao_input(void)
   rpl_parent_t *parent;
   uip_ds6_nbr_t *nbr;
 
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_IN, RPL_CODE_DAO);
+
   prefixlen = 0;
   parent = NULL;
 
@@ -736,6 +747,7 @@ dao_input(void)
         PRINTF("RPL: Forwarding no-path DAO to parent ");
         PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
         PRINTF("\n");
+        TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DAO);
         uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
                        ICMP6_RPL, RPL_CODE_DAO, buffer_length);
       }
@@ -794,6 +806,7 @@ fwd_dao:
       PRINTF("RPL: Forwarding DAO to parent ");
       PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
       PRINTF("\n");
+      TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DAO);
       uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
                      ICMP6_RPL, RPL_CODE_DAO, buffer_length);
     }
@@ -905,6 +918,7 @@ dao_output_target(rpl_parent_t *parent, uip_ipaddr_t *prefix, uint8_t lifetime)
   PRINTF("\n");
 
   if(rpl_get_parent_ipaddr(parent) != NULL) {
+    TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DAO);
     uip_icmp6_send(rpl_get_parent_ipaddr(parent), ICMP6_RPL, RPL_CODE_DAO, pos);
   }
 }
@@ -931,6 +945,7 @@ dao_ack_input(void)
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
   PRINTF("\n");
 #endif /* DEBUG */
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_IN, RPL_CODE_DAO_ACK);
   uip_len = 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -950,6 +965,7 @@ dao_ack_output(rpl_instance_t *instance, uip_ipaddr_t *dest, uint8_t sequence)
   buffer[2] = sequence;
   buffer[3] = 0;
 
+  TRACE(TRACE_MODULE_RPL, TRACE_EVENT_OUT, RPL_CODE_DAO_ACK);
   uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
 }
 /*---------------------------------------------------------------------------*/
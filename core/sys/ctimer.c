@@ -44,9 +44,10 @@
 
 #include "sys/ctimer.h"
 #include "contiki.h"
-#include "lib/list.h"
+#include "lib/dlist.h"
+#include "sys/trace.h"
 
-LIST(ctimer_list);
+DLIST(ctimer_list);
 
 static char initialized;
 
@@ -65,18 +66,19 @@ PROCESS_THREAD(ctimer_process, ev, data)
   struct ctimer *c;
   PROCESS_BEGIN();
 
-  for(c = list_head(ctimer_list); c != NULL; c = c->next) {
+  for(c = dlist_head(ctimer_list); c != NULL; c = c->next) {
     etimer_set(&c->etimer, c->etimer.timer.interval);
   }
   initialized = 1;
 
   while(1) {
     PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_TIMER);
-    for(c = list_head(ctimer_list); c != NULL; c = c->next) {
+    for(c = dlist_head(ctimer_list); c != NULL; c = c->next) {
       if(&c->etimer == data) {
-	list_remove(ctimer_list, c);
+	dlist_remove(ctimer_list, c);
 	PROCESS_CONTEXT_BEGIN(c->p);
 	if(c->f != NULL) {
+	  TRACE(TRACE_MODULE_TIMER, TRACE_EVENT_FIRE, (uintptr_t)c->f);
 	  c->f(c->ptr);
 	}
 	PROCESS_CONTEXT_END(c->p);
@@ -91,7 +93,7 @@ void
 ctimer_init(void)
 {
   initialized = 0;
-  list_init(ctimer_list);
+  dlist_init(ctimer_list);
   process_start(&ctimer_process, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -111,7 +113,7 @@ ctimer_set(struct ctimer *c, clock_time_t t,
     c->etimer.timer.interval = t;
   }
 
-  list_add(ctimer_list, c);
+  dlist_add(ctimer_list, c);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -123,7 +125,7 @@ ctimer_reset(struct ctimer *c)
     PROCESS_CONTEXT_END(&ctimer_process);
   }
 
-  list_add(ctimer_list, c);
+  dlist_add(ctimer_list, c);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -135,7 +137,7 @@ ctimer_restart(struct ctimer *c)
     PROCESS_CONTEXT_END(&ctimer_process);
   }
 
-  list_add(ctimer_list, c);
+  dlist_add(ctimer_list, c);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -147,22 +149,16 @@ ctimer_stop(struct ctimer *c)
     c->etimer.next = NULL;
     c->etimer.p = PROCESS_NONE;
   }
-  list_remove(ctimer_list, c);
+  dlist_remove(ctimer_list, c);
 }
 /*---------------------------------------------------------------------------*/
 int
 ctimer_expired(struct ctimer *c)
 {
-  struct ctimer *t;
   if(initialized) {
     return etimer_expired(&c->etimer);
   }
-  for(t = list_head(ctimer_list); t != NULL; t = t->next) {
-    if(t == c) {
-      return 0;
-    }
-  }
-  return 1;
+  return !dlist_contains(ctimer_list, c);
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -49,6 +49,12 @@
  * The ctimer module provides a timer mechanism that calls a specified
  * C function when a ctimer expires.
  *
+ * Pending ctimers are kept on a doubly linked list, so that they are
+ * set and stopped in constant time. A ctimer must therefore be zeroed
+ * before it is used for the first time, by declaring it static or by
+ * clearing it with memset(). It may be reused after it has expired or
+ * been stopped.
+ *
  */
 
 #ifndef CTIMER_H_
@@ -58,6 +64,7 @@
 
 struct ctimer {
   struct ctimer *next;
+  struct ctimer *prev;
   struct etimer etimer;
   struct process *p;
   void (*f)(void *);
@@ -48,6 +48,7 @@
 
 #include "sys/etimer.h"
 #include "sys/process.h"
+#include "sys/trace.h"
 
 static struct etimer *timerlist;
 static clock_time_t next_expiration;
@@ -116,7 +117,8 @@ PROCESS_THREAD(etimer_process, ev, data)
     for(t = timerlist; t != NULL; t = t->next) {
       if(timer_expired(&t->timer)) {
 	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
-	  
+	  TRACE(TRACE_MODULE_TIMER, TRACE_EVENT_FIRE, (uintptr_t)t->p);
+
 	  /* Reset the process ID of the event timer, to signal that the
 	     etimer has expired. This is later checked in the
 	     etimer_expired() function. */
@@ -47,6 +47,7 @@
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#include "sys/trace.h"
 
 /*
  * Pointer to the currently running process structure.
@@ -187,7 +188,9 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event %d\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+    TRACE(TRACE_MODULE_PROCESS, TRACE_EVENT_DISPATCH, ev);
     ret = p->thread(&p->pt, ev, data);
+    TRACE(TRACE_MODULE_PROCESS, TRACE_EVENT_RETURN, ev);
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Implementation of the binary event trace
+ */
+
+#include "sys/trace.h"
+#include "sys/clock.h"
+#include "sys/rtimer.h"
+#include <stdio.h>
+
+#if TRACE_ON
+
+static struct trace_record ring[TRACE_SIZE];
+static uint16_t head, count;
+static unsigned long lost;
+
+/*---------------------------------------------------------------------------*/
+void
+trace_add(uint8_t module, uint8_t event, uint16_t arg)
+{
+  struct trace_record *r;
+
+  r = &ring[head];
+  r->clock = (uint16_t)clock_time();
+  r->rtimer = RTIMER_NOW();
+  r->module = module;
+  r->event = event;
+  r->arg = arg;
+
+  if(++head == TRACE_SIZE) {
+    head = 0;
+  }
+  if(count < TRACE_SIZE) {
+    count++;
+  } else {
+    lost++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+trace_read(struct trace_record *r)
+{
+  int tail;
+
+  if(count == 0) {
+    return 0;
+  }
+  tail = head - count;
+  if(tail < 0) {
+    tail += TRACE_SIZE;
+  }
+  *r = ring[tail];
+  count--;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+trace_count(void)
+{
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+trace_lost(void)
+{
+  return lost;
+}
+/*---------------------------------------------------------------------------*/
+void
+trace_clear(void)
+{
+  count = 0;
+  lost = 0;
+}
+/*---------------------------------------------------------------------------*/
+static char *
+put_hex(char *p, uint16_t v, int digits)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  while(digits > 0) {
+    digits--;
+    *p++ = hex[(v >> (digits * 4)) & 0xf];
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+int
+trace_format(char *buf, int len)
+{
+  struct trace_record r;
+  char *p;
+  int n;
+
+  if(len < 2) {
+    return 0;
+  }
+  p = buf;
+  *p++ = 'T';
+  len -= 2;
+
+  /* Fields are written most significant digit first, so that the
+     output does not depend on the byte order of the node. */
+  for(n = 0; len >= (int)(2 * sizeof(r)) && trace_read(&r); n++) {
+    p = put_hex(p, r.clock, 4);
+    p = put_hex(p, r.rtimer, 4);
+    p = put_hex(p, r.module, 2);
+    p = put_hex(p, r.event, 2);
+    p = put_hex(p, r.arg, 4);
+    len -= 2 * sizeof(r);
+  }
+  *p = 0;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+trace_dump(void)
+{
+  char line[2 + 6 * 2 * sizeof(struct trace_record)];
+
+  printf("TRACE-START %lu %lu %u %lu\n",
+         (unsigned long)CLOCK_SECOND, (unsigned long)RTIMER_SECOND,
+         trace_count(), lost);
+  while(trace_format(line, sizeof(line)) > 0) {
+    printf("%s\n", line);
+  }
+  printf("TRACE-END\n");
+  lost = 0;
+}
+/*---------------------------------------------------------------------------*/
+#else /* TRACE_ON */
+void trace_add(uint8_t module, uint8_t event, uint16_t arg) {}
+int trace_read(struct trace_record *r) { return 0; }
+int trace_count(void) { return 0; }
+unsigned long trace_lost(void) { return 0; }
+void trace_clear(void) {}
+int trace_format(char *buf, int len) { if(len > 0) { *buf = 0; } return 0; }
+void trace_dump(void) {}
+#endif /* TRACE_ON */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for the binary event trace
+ */
+
+/**
+ * \addtogroup sys
+ * @{
+ */
+
+/**
+ * \defgroup trace Binary event trace
+ * @{
+ *
+ * The trace module records fixed-size binary events into a RAM ring
+ * buffer. It is meant for profiling the network stack without the
+ * timing perturbation of printf debugging: recording an event costs
+ * two timer reads and an 8-byte store.
+ *
+ * Events are recorded with the TRACE() macro. Tracing is compiled in
+ * only when TRACE_CONF_ON is set, and only for the modules whose bit
+ * is set in TRACE_CONF_MODULES, so disabled trace points cost nothing.
+ *
+ * The ring keeps the most recent TRACE_CONF_SIZE events. It can be
+ * dumped with trace_dump(), which prints the records as hex lines
+ * that tools/trace/trace-decode turns into a per-event listing and
+ * per-layer latency statistics.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "contiki-conf.h"
+
+#ifdef TRACE_CONF_ON
+#define TRACE_ON TRACE_CONF_ON
+#else /* TRACE_CONF_ON */
+#define TRACE_ON 0
+#endif /* TRACE_CONF_ON */
+
+/* The number of records in the ring. */
+#ifdef TRACE_CONF_SIZE
+#define TRACE_SIZE TRACE_CONF_SIZE
+#else /* TRACE_CONF_SIZE */
+#define TRACE_SIZE 64
+#endif /* TRACE_CONF_SIZE */
+
+/** Modules that can record events; one bit each in TRACE_CONF_MODULES. */
+enum {
+  TRACE_MODULE_PROCESS,
+  TRACE_MODULE_TIMER,
+  TRACE_MODULE_MAC,
+  TRACE_MODULE_SICSLOWPAN,
+  TRACE_MODULE_IP,
+  TRACE_MODULE_RPL,
+  TRACE_MODULE_APP,
+};
+
+#define TRACE_MASK(module) (1 << (module))
+#define TRACE_MASK_ALL 0xff
+
+/* The modules that are traced. */
+#ifdef TRACE_CONF_MODULES
+#define TRACE_MODULES TRACE_CONF_MODULES
+#else /* TRACE_CONF_MODULES */
+#define TRACE_MODULES (TRACE_MASK_ALL & ~TRACE_MASK(TRACE_MODULE_PROCESS))
+#endif /* TRACE_CONF_MODULES */
+
+/** Event types. The meaning of the argument depends on the event. */
+enum {
+  TRACE_EVENT_IN,       /* Packet received by layer, arg = length */
+  TRACE_EVENT_OUT,      /* Packet sent by layer, arg = length */
+  TRACE_EVENT_ENQUEUE,  /* Packet queued, arg = queue length */
+  TRACE_EVENT_DEQUEUE,  /* Packet handed down, arg = queue length */
+  TRACE_EVENT_DONE,     /* Transmission finished, arg = status */
+  TRACE_EVENT_DROP,     /* Packet dropped, arg = reason */
+  TRACE_EVENT_FIRE,     /* Timer fired, arg = callback or process address */
+  TRACE_EVENT_DISPATCH, /* Process called, arg = event */
+  TRACE_EVENT_RETURN,   /* Process returned, arg = event */
+};
+
+struct trace_record {
+  uint16_t clock;   /* Low 16 bits of clock_time() */
+  uint16_t rtimer;  /* RTIMER_NOW() */
+  uint8_t module;
+  uint8_t event;
+  uint16_t arg;
+};
+
+#if TRACE_ON
+#define TRACE(module, event, arg) do {                         \
+    if(TRACE_MODULES & TRACE_MASK(module)) {                   \
+      trace_add((module), (event), (arg));                     \
+    }                                                          \
+  } while(0)
+#else /* TRACE_ON */
+#define TRACE(module, event, arg)
+#endif /* TRACE_ON */
+
+/**
+ * \brief      Record an event
+ *
+ *             This function is normally called through the TRACE()
+ *             macro. When the ring is full the oldest record is
+ *             overwritten.
+ */
+void trace_add(uint8_t module, uint8_t event, uint16_t arg);
+
+/**
+ * \brief      Remove the oldest record from the ring
+ * \param r    Where the record is stored
+ * \return     Non-zero if a record was read, zero if the ring was empty
+ */
+int trace_read(struct trace_record *r);
+
+/**
+ * \brief      The number of records currently in the ring
+ */
+int trace_count(void);
+
+/**
+ * \brief      The number of records overwritten since the last dump or clear
+ */
+unsigned long trace_lost(void);
+
+/**
+ * \brief      Empty the ring and reset the lost counter
+ */
+void trace_clear(void);
+
+/**
+ * \brief      Encode records as one line of hex text
+ * \param buf  The buffer where the line is written
+ * \param len  The size of the buffer
+ * \return     The number of records encoded
+ *
+ *             The oldest records are removed from the ring and
+ *             written as "T" followed by 16 hex digits per record,
+ *             as many as fit in the buffer. The line is zero
+ *             terminated but has no newline.
+ */
+int trace_format(char *buf, int len);
+
+/**
+ * \brief      Print and empty the ring
+ *
+ *             The dump starts with a "TRACE-START" line that gives
+ *             the clock rates, so that the host-side decoder can
+ *             convert timestamps to seconds, and ends with a
+ *             "TRACE-END" line.
+ */
+void trace_dump(void);
+
+#endif /* TRACE_H_ */
+
+/** @} */
+/** @} */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	Measures the row throughput of Antelope selections, aggregations
+ *	and joins.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "antelope.h"
+
+#ifndef BENCHMARK_ROWS
+#define BENCHMARK_ROWS		20000
+#endif
+
+/* Each query is run this many times to get above the clock resolution. */
+#ifndef BENCHMARK_REPEAT
+#define BENCHMARK_REPEAT	10
+#endif
+
+#ifndef BENCHMARK_NODES
+#define BENCHMARK_NODES		20
+#endif
+
+PROCESS(benchmark_process, "Antelope benchmark");
+AUTOSTART_PROCESSES(&benchmark_process);
+
+/*---------------------------------------------------------------------------*/
+static int
+quiet_output(const char *format, ...)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_query(const char *name, const char *query, unsigned long scanned)
+{
+  static db_handle_t handle;
+  db_result_t result;
+  clock_time_t start, elapsed;
+  unsigned long rows;
+  int i;
+
+  start = clock_time();
+  for(i = 0; i < BENCHMARK_REPEAT; i++) {
+    result = db_query(&handle, query);
+    if(DB_ERROR(result)) {
+      printf("%s: query failed: %s\n", name, db_get_result_message(result));
+      return;
+    }
+
+    rows = 0;
+    while(db_processing(&handle)) {
+      result = db_process(&handle);
+      if(result == DB_GOT_ROW) {
+        rows++;
+      } else if(result == DB_FINISHED) {
+        break;
+      } else if(DB_ERROR(result)) {
+        printf("%s: processing failed: %s\n", name,
+               db_get_result_message(result));
+        break;
+      }
+    }
+    db_free(&handle);
+  }
+  elapsed = clock_time() - start;
+  scanned *= BENCHMARK_REPEAT;
+
+  if(elapsed == 0) {
+    elapsed = 1;
+  }
+  printf("%s: %lu rows scanned, %lu rows returned per query, %lu ms, %lu rows/s\n",
+         name, scanned, rows, (unsigned long)elapsed * 1000 / CLOCK_SECOND,
+         scanned * CLOCK_SECOND / elapsed);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(benchmark_process, ev, data)
+{
+  static unsigned i;
+
+  PROCESS_BEGIN();
+
+  db_init();
+  db_set_output_function(quiet_output);
+
+  db_query(NULL, "REMOVE RELATION readings;");
+  db_query(NULL, "REMOVE RELATION nodes;");
+  db_query(NULL, "REMOVE RELATION samples;");
+  db_query(NULL, "REMOVE RELATION sorted;");
+  db_query(NULL, "REMOVE RELATION events;");
+
+  db_query(NULL, "CREATE RELATION readings;");
+  db_query(NULL, "CREATE ATTRIBUTE id DOMAIN LONG IN readings;");
+  db_query(NULL, "CREATE ATTRIBUTE node DOMAIN INT IN readings;");
+  db_query(NULL, "CREATE ATTRIBUTE value DOMAIN INT IN readings;");
+  db_query(NULL, "CREATE INDEX readings.id TYPE INLINE;");
+
+  db_query(NULL, "CREATE RELATION nodes;");
+  db_query(NULL, "CREATE ATTRIBUTE node DOMAIN INT IN nodes;");
+  db_query(NULL, "CREATE ATTRIBUTE room DOMAIN INT IN nodes;");
+  db_query(NULL, "CREATE INDEX nodes.node TYPE INLINE;");
+
+  /* The join partners of readings: one without an index, one sorted
+     on id, and a small one. */
+  db_query(NULL, "CREATE RELATION samples;");
+  db_query(NULL, "CREATE ATTRIBUTE id DOMAIN LONG IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE quality DOMAIN INT IN samples;");
+
+  db_query(NULL, "CREATE RELATION sorted;");
+  db_query(NULL, "CREATE ATTRIBUTE id DOMAIN LONG IN sorted;");
+  db_query(NULL, "CREATE ATTRIBUTE quality DOMAIN INT IN sorted;");
+  db_query(NULL, "CREATE INDEX sorted.id TYPE INLINE;");
+
+  db_query(NULL, "CREATE RELATION events;");
+  db_query(NULL, "CREATE ATTRIBUTE id DOMAIN LONG IN events;");
+  db_query(NULL, "CREATE ATTRIBUTE kind DOMAIN INT IN events;");
+
+  printf("Inserting %u rows, scan block size %u bytes\n",
+         BENCHMARK_ROWS, DB_SCAN_BLOCK_SIZE);
+
+  for(i = 0; i < BENCHMARK_NODES; i++) {
+    db_query(NULL, "INSERT (%u, %u) INTO nodes;", i, 100 + i / 4);
+  }
+  for(i = 0; i < BENCHMARK_ROWS; i++) {
+    if(DB_ERROR(db_query(NULL, "INSERT (%u, %u, %u) INTO readings;",
+                         i, i % BENCHMARK_NODES, (i * 7) % 1000))) {
+      printf("Insertion failed at row %u\n", i);
+      break;
+    }
+    /* Insert the samples in a different order than the readings. */
+    db_query(NULL, "INSERT (%u, %u) INTO samples;",
+             (i * 7919UL) % BENCHMARK_ROWS, i % 100);
+    db_query(NULL, "INSERT (%u, %u) INTO sorted;", i, i % 100);
+  }
+  for(i = 0; i < BENCHMARK_NODES; i++) {
+    db_query(NULL, "INSERT (%u, %u) INTO events;",
+             i * (BENCHMARK_ROWS / BENCHMARK_NODES), i % 3);
+  }
+
+  run_query("select all", "SELECT id, value FROM readings;",
+            BENCHMARK_ROWS);
+  run_query("select where", "SELECT id, value FROM readings WHERE value < 10;",
+            BENCHMARK_ROWS);
+  run_query("select range",
+            "SELECT id, node, value FROM readings WHERE value > 100 AND value < 110;",
+            BENCHMARK_ROWS);
+  run_query("select count", "SELECT COUNT(id) FROM readings;",
+            BENCHMARK_ROWS);
+  run_query("group node",
+            "SELECT node, COUNT(value), MEAN(value) FROM readings GROUP BY node;",
+            BENCHMARK_ROWS);
+  run_query("group window",
+            "SELECT id, MIN(value), MAX(value) FROM readings GROUP BY id WINDOW 1000;",
+            BENCHMARK_ROWS);
+  run_query("join small", "JOIN readings, nodes ON node PROJECT id, room;",
+            BENCHMARK_ROWS + BENCHMARK_NODES);
+  run_query("join hash", "JOIN readings, samples ON id PROJECT value, quality;",
+            2 * BENCHMARK_ROWS);
+  run_query("join merge", "JOIN readings, sorted ON id PROJECT value, quality;",
+            2 * BENCHMARK_ROWS);
+  run_query("join index", "JOIN events, readings ON id PROJECT kind, value;",
+            BENCHMARK_NODES);
+
+  printf("Benchmark done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
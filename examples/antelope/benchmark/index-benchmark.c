@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *	Compares the Antelope index types on a relation keyed by a
+ *	monotonic attribute, such as a timestamp, and with a series
+ *	relation that skips blocks in range queries.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "antelope.h"
+#include "index.h"
+
+#ifndef BENCHMARK_ROWS
+#define BENCHMARK_ROWS		20000
+#endif
+
+/* The number of point and range queries run for each index. */
+#ifndef BENCHMARK_QUERIES
+#define BENCHMARK_QUERIES	100
+#endif
+
+/* The number of keys in each range query. */
+#ifndef BENCHMARK_RANGE
+#define BENCHMARK_RANGE		100
+#endif
+
+PROCESS(benchmark_process, "Antelope index benchmark");
+AUTOSTART_PROCESSES(&benchmark_process);
+
+struct setup {
+  char *relation;
+  char *index_type;
+  uint8_t series;
+  /* Insert the keys in a random order instead of in sequence. */
+  uint8_t shuffled;
+};
+
+/* Indexes that are created before the rows are inserted. */
+static const struct setup incremental[] = {
+  {"plain", NULL, 0, 0},
+  {"inl", "INLINE", 0, 0},
+  {"heap", "MAXHEAP", 0, 0},
+  {"tree", "BTREE", 0, 0},
+  {"rtree", "BTREE", 0, 1},
+  {"ts", NULL, 1, 0}
+};
+
+/* Indexes that are created over an existing relation. */
+static const struct setup loaded[] = {
+  {"heap2", "MAXHEAP", 0, 0},
+  {"tree2", "BTREE", 0, 0}
+};
+
+#define SETUPS(s) (sizeof(s) / sizeof(s[0]))
+
+/*---------------------------------------------------------------------------*/
+static int
+quiet_output(const char *format, ...)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_ms(clock_time_t start)
+{
+  return (unsigned long)(clock_time() - start) * 1000 / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+setup_name(const struct setup *setup)
+{
+  if(setup->series) {
+    return "series";
+  }
+  if(setup->shuffled) {
+    return "BTREE, random keys";
+  }
+  return setup->index_type != NULL ? setup->index_type : "none";
+}
+/*---------------------------------------------------------------------------*/
+static long
+tuple_file_size(const struct setup *setup)
+{
+  relation_t *rel;
+  long size;
+
+  rel = relation_load(setup->relation);
+  if(rel == NULL) {
+    return -1;
+  }
+  size = cfs_seek(rel->tuple_storage, 0, CFS_SEEK_END);
+  relation_release(rel);
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_relation(const struct setup *setup)
+{
+  db_query(NULL, "REMOVE RELATION %s;", setup->relation);
+  db_query(NULL, setup->series ? "CREATE RELATION %s TYPE SERIES;" :
+                                 "CREATE RELATION %s;", setup->relation);
+  db_query(NULL, "CREATE ATTRIBUTE time DOMAIN LONG IN %s;", setup->relation);
+  db_query(NULL, "CREATE ATTRIBUTE value DOMAIN INT IN %s;", setup->relation);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+insert_rows(const struct setup *setup)
+{
+  clock_time_t start;
+  db_result_t result;
+  unsigned i, key;
+
+  start = clock_time();
+  for(i = 0; i < BENCHMARK_ROWS; i++) {
+    /* 7919 is a prime, so the shuffled keys are a permutation of the
+       sequential ones. */
+    key = setup->shuffled ? ((unsigned long)i * 7919) % BENCHMARK_ROWS : i;
+    result = db_query(NULL, "INSERT (%u, %u) INTO %s;",
+                      key, (key * 7) % 1000, setup->relation);
+    if(DB_ERROR(result)) {
+      printf("%s: insertion failed at row %u: %s\n", setup->relation, i,
+             db_get_result_message(result));
+      break;
+    }
+  }
+  return elapsed_ms(start);
+}
+/*---------------------------------------------------------------------------*/
+static db_result_t
+create_index(const struct setup *setup)
+{
+  db_result_t result;
+
+  result = db_query(NULL, "CREATE INDEX %s.time TYPE %s;",
+                    setup->relation, setup->index_type);
+  if(DB_ERROR(result)) {
+    printf("%s: failed to create the index: %s\n", setup->index_type,
+           db_get_result_message(result));
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns DB_OK when the index is loaded, and DB_FINISHED while
+   the indexer is still loading it. */
+static db_result_t
+index_state(const struct setup *setup)
+{
+  relation_t *rel;
+  attribute_t *attr;
+  db_result_t result;
+
+  rel = relation_load(setup->relation);
+  if(rel == NULL) {
+    return DB_STORAGE_ERROR;
+  }
+  attr = relation_attribute_get(rel, "time");
+  if(attr == NULL || attr->index == NULL ||
+     (((index_t *)attr->index)->flags & INDEX_LOAD_ERROR)) {
+    result = DB_INDEX_ERROR;
+  } else if(index_exists(attr)) {
+    result = DB_OK;
+  } else {
+    result = DB_FINISHED;
+  }
+  relation_release(rel);
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_queries(const struct setup *setup, unsigned long range,
+            unsigned long *rows)
+{
+  static db_handle_t handle;
+  db_result_t result;
+  clock_time_t start;
+  unsigned long key;
+  int i;
+
+  *rows = 0;
+  start = clock_time();
+  for(i = 0; i < BENCHMARK_QUERIES; i++) {
+    key = ((unsigned long)i * 7919) % (BENCHMARK_ROWS - range);
+    if(range == 1) {
+      result = db_query(&handle,
+                        "SELECT time, value FROM %s WHERE time = %lu;",
+                        setup->relation, key);
+    } else {
+      result = db_query(&handle,
+                        "SELECT time, value FROM %s WHERE time >= %lu AND time < %lu;",
+                        setup->relation, key, key + range);
+    }
+    if(DB_ERROR(result)) {
+      printf("%s: query failed: %s\n", setup->relation,
+             db_get_result_message(result));
+      return 0;
+    }
+
+    while(db_processing(&handle)) {
+      result = db_process(&handle);
+      if(result == DB_GOT_ROW) {
+        (*rows)++;
+      } else if(result == DB_FINISHED) {
+        break;
+      } else if(DB_ERROR(result)) {
+        printf("%s: processing failed: %s\n", setup->relation,
+               db_get_result_message(result));
+        break;
+      }
+    }
+    db_free(&handle);
+  }
+
+  return elapsed_ms(start);
+}
+/*---------------------------------------------------------------------------*/
+static void
+report_queries(const struct setup *setup)
+{
+  unsigned long ms;
+  unsigned long rows;
+  const char *name;
+
+  name = setup_name(setup);
+
+  ms = run_queries(setup, 1, &rows);
+  printf("%s: %d point queries, %lu rows found, %lu ms, %lu us/query\n",
+         name, BENCHMARK_QUERIES, rows, ms,
+         ms * 1000 / BENCHMARK_QUERIES);
+
+  ms = run_queries(setup, BENCHMARK_RANGE, &rows);
+  printf("%s: %d range queries of %d keys, %lu rows found, %lu ms, %lu us/query\n",
+         name, BENCHMARK_QUERIES, BENCHMARK_RANGE, rows, ms,
+         ms * 1000 / BENCHMARK_QUERIES);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(benchmark_process, ev, data)
+{
+  static unsigned i;
+  static clock_time_t start;
+  static db_result_t result;
+  unsigned long ms;
+
+  PROCESS_BEGIN();
+
+  db_init();
+  db_set_output_function(quiet_output);
+
+  printf("Index benchmark with %u rows\n", BENCHMARK_ROWS);
+
+  for(i = 0; i < SETUPS(incremental); i++) {
+    create_relation(&incremental[i]);
+    if(incremental[i].index_type != NULL) {
+      create_index(&incremental[i]);
+    }
+    ms = insert_rows(&incremental[i]);
+    db_flush();
+    printf("%s: inserted %u rows in %lu ms, %ld bytes of rows\n",
+           setup_name(&incremental[i]), BENCHMARK_ROWS, ms,
+           tuple_file_size(&incremental[i]));
+  }
+
+  for(i = 0; i < SETUPS(loaded); i++) {
+    create_relation(&loaded[i]);
+    insert_rows(&loaded[i]);
+    start = clock_time();
+    if(DB_ERROR(create_index(&loaded[i]))) {
+      continue;
+    }
+    while((result = index_state(&loaded[i])) == DB_FINISHED) {
+      PROCESS_PAUSE();
+    }
+    if(DB_ERROR(result)) {
+      printf("%s: failed to load the index\n", loaded[i].index_type);
+      continue;
+    }
+    printf("%s: loaded an index over %u rows in %lu ms\n",
+           loaded[i].index_type, BENCHMARK_ROWS, elapsed_ms(start));
+  }
+
+  for(i = 0; i < SETUPS(incremental); i++) {
+    report_queries(&incremental[i]);
+  }
+  for(i = 0; i < SETUPS(loaded); i++) {
+    report_queries(&loaded[i]);
+  }
+
+  printf("Benchmark done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
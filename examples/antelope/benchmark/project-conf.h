@@ -0,0 +1,23 @@
+#undef DB_FEATURE_COFFEE
+#define DB_FEATURE_COFFEE	0
+
+/* Read rows in 4 kB blocks. Build with DEFINES=DB_SCAN_BLOCK_SIZE=<n>
+   to compare with other block sizes. */
+#ifndef DB_SCAN_BLOCK_SIZE
+#define DB_SCAN_BLOCK_SIZE	4096
+#endif
+
+/* Room for the relations and indexes of the index benchmark. */
+#define DB_RELATION_POOL_SIZE	9
+#define DB_INDEX_POOL_SIZE	7
+#define DB_ATTRIBUTE_POOL_SIZE	24
+#define DB_HEAP_INDEX_LIMIT	2
+#define DB_BTREE_INDEX_LIMIT	3
+
+/* A join table that holds a few thousand keys. Build with
+   DEFINES=DB_JOIN_TABLE_SIZE=<n> to compare with other sizes. */
+#ifndef DB_JOIN_TABLE_SIZE
+#define DB_JOIN_TABLE_SIZE	1024
+#endif
+#define DB_JOIN_BUCKETS		256
+#define DB_JOIN_PARTITIONS	32
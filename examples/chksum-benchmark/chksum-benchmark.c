@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *	Measures the throughput of the Internet checksum: the word-wise
+ *	accumulator in uip_chksum_add() against the byte pair loop it
+ *	replaced, and an RFC 1624 incremental update against a full
+ *	recomputation when only the pseudo-header addresses change, as
+ *	in the IP64 translator.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "lib/random.h"
+
+/* The number of bytes that are summed for each buffer length. */
+#ifndef BENCHMARK_BYTES
+#define BENCHMARK_BYTES		(64UL * 1024 * 1024)
+#endif
+
+#define MAX_LENGTH		1280
+
+PROCESS(benchmark_process, "Checksum benchmark");
+AUTOSTART_PROCESSES(&benchmark_process);
+
+static uint8_t buf[MAX_LENGTH];
+
+static const uint16_t lengths[] = {20, 40, 128, 512, MAX_LENGTH};
+
+/*---------------------------------------------------------------------------*/
+/* The byte pair loop that uIP used before uip_chksum_add(). */
+static uint16_t
+chksum_bytewise(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint16_t t;
+  const uint8_t *dataptr;
+  const uint8_t *last_byte;
+
+  dataptr = data;
+  last_byte = data + len - 1;
+
+  while(dataptr < last_byte) {
+    t = (dataptr[0] << 8) + dataptr[1];
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+    dataptr += 2;
+  }
+
+  if(dataptr == last_byte) {
+    t = (dataptr[0] << 8) + 0;
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+  }
+
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_us(clock_time_t start)
+{
+  return (unsigned long)(clock_time() - start) * 1000000UL / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+/* Converts a time for BENCHMARK_BYTES bytes into Mbytes per second. */
+static unsigned long
+throughput(unsigned long us)
+{
+  return us == 0 ? 0 : BENCHMARK_BYTES / us;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(benchmark_process, ev, data)
+{
+  static clock_time_t start;
+  unsigned long bytewise_time, wordwise_time, full_time, update_time;
+  unsigned long rounds, r;
+  volatile uint16_t sum;
+  uint16_t chksum, old_sum, new_sum;
+  uint8_t addrs[32];
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < MAX_LENGTH; i++) {
+    buf[i] = random_rand();
+  }
+
+  printf("%lu bytes per measurement, throughput in Mbytes/s\n",
+         BENCHMARK_BYTES);
+  printf("%6s %10s %10s\n", "length", "bytewise", "wordwise");
+
+  for(i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    rounds = BENCHMARK_BYTES / lengths[i];
+
+    if(chksum_bytewise(0, buf, lengths[i]) !=
+       uip_chksum_add(0, buf, lengths[i])) {
+      printf("checksum mismatch for length %u\n", lengths[i]);
+    }
+
+    start = clock_time();
+    for(r = 0; r < rounds; r++) {
+      sum = chksum_bytewise(r, buf, lengths[i]);
+    }
+    bytewise_time = elapsed_us(start);
+
+    start = clock_time();
+    for(r = 0; r < rounds; r++) {
+      sum = uip_chksum_add(r, buf, lengths[i]);
+    }
+    wordwise_time = elapsed_us(start);
+
+    printf("%6u %10lu %10lu\n", lengths[i],
+           throughput(bytewise_time), throughput(wordwise_time));
+  }
+
+  /* Replace the 32 bytes of IPv6 addresses in the pseudo-header of a
+     full-sized packet, either by summing the packet again or by
+     updating its checksum. */
+  rounds = BENCHMARK_BYTES / MAX_LENGTH;
+  chksum = uip_htons(~uip_chksum_add(0, buf, MAX_LENGTH));
+  memcpy(addrs, buf, sizeof(addrs));
+
+  start = clock_time();
+  for(r = 0; r < rounds; r++) {
+    addrs[15] = r;
+    sum = ~uip_chksum_add(uip_chksum_add(0, addrs, sizeof(addrs)),
+                          &buf[sizeof(addrs)], MAX_LENGTH - sizeof(addrs));
+  }
+  full_time = elapsed_us(start);
+
+  start = clock_time();
+  old_sum = uip_chksum_add(0, buf, sizeof(addrs));
+  for(r = 0; r < rounds; r++) {
+    addrs[15] = r;
+    new_sum = uip_chksum_add(0, addrs, sizeof(addrs));
+    sum = uip_chksum_update(chksum, old_sum, new_sum);
+  }
+  update_time = elapsed_us(start);
+
+  if(uip_ntohs(uip_chksum_update(chksum, old_sum, new_sum)) !=
+     (uint16_t)~uip_chksum_add(uip_chksum_add(0, addrs, sizeof(addrs)),
+                               &buf[sizeof(addrs)],
+                               MAX_LENGTH - sizeof(addrs))) {
+    printf("incremental update mismatch\n");
+  }
+
+  printf("%lu address translations of a %u byte packet, times in ns\n",
+         rounds, MAX_LENGTH);
+  printf("full %lu update %lu\n",
+         full_time * 1000 / rounds, update_time * 1000 / rounds);
+  (void)sum;
+
+  printf("Benchmark done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *	Compares the linked list library with the doubly linked list
+ *	library on the operations that timers, routes and packet
+ *	queues use: appending, moving an element to the end, removing
+ *	an element and getting the length of a list.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/dlist.h"
+
+/* The number of operations that are timed for each list length. */
+#ifndef BENCHMARK_OPERATIONS
+#define BENCHMARK_OPERATIONS	1000000UL
+#endif
+
+#define MAX_ELEMENTS		256
+
+PROCESS(benchmark_process, "List benchmark");
+AUTOSTART_PROCESSES(&benchmark_process);
+
+struct element {
+  struct element *next;
+  struct element *prev;
+  int value;
+};
+
+/* The lists share no elements, as both use the next pointer. */
+static struct element list_elements[MAX_ELEMENTS];
+static struct element dlist_elements[MAX_ELEMENTS];
+
+static const int lengths[] = {8, 32, 128, MAX_ELEMENTS};
+
+LIST(slist);
+DLIST(dlist);
+
+enum operation {
+  OP_APPEND,
+  OP_MOVE,
+  OP_REMOVE,
+  OP_LENGTH,
+  OP_COUNT
+};
+
+static const char *operation_names[] = {"append", "move", "remove", "length"};
+
+/*---------------------------------------------------------------------------*/
+static void
+fill(int n)
+{
+  int i;
+
+  list_init(slist);
+  dlist_init(dlist);
+  for(i = 0; i < n; i++) {
+    dlist_elements[i].next = dlist_elements[i].prev = NULL;
+    dlist_add(dlist, &dlist_elements[i]);
+    list_add(slist, &list_elements[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Run an operation with the linked list library, keeping the list at
+   length n. */
+static unsigned long
+run_list(enum operation op, int n)
+{
+  unsigned long i, sum;
+  struct element *e;
+
+  sum = 0;
+  for(i = 0; i < BENCHMARK_OPERATIONS; i++) {
+    e = &list_elements[i % n];
+    switch(op) {
+    case OP_APPEND:
+      /* Take the first element and append it, like a timer that is
+         set again when it expires. */
+      list_add(slist, list_pop(slist));
+      break;
+    case OP_MOVE:
+      list_add(slist, e);
+      break;
+    case OP_REMOVE:
+      list_remove(slist, e);
+      list_push(slist, e);
+      break;
+    case OP_LENGTH:
+      sum += list_length(slist);
+      break;
+    default:
+      break;
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_dlist(enum operation op, int n)
+{
+  unsigned long i, sum;
+  struct element *e;
+
+  sum = 0;
+  for(i = 0; i < BENCHMARK_OPERATIONS; i++) {
+    e = &dlist_elements[i % n];
+    switch(op) {
+    case OP_APPEND:
+      dlist_add(dlist, dlist_pop(dlist));
+      break;
+    case OP_MOVE:
+      dlist_add(dlist, e);
+      break;
+    case OP_REMOVE:
+      dlist_remove(dlist, e);
+      dlist_push(dlist, e);
+      break;
+    case OP_LENGTH:
+      sum += dlist_length(dlist);
+      break;
+    default:
+      break;
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_us(clock_time_t start)
+{
+  return (unsigned long)(clock_time() - start) * 1000000UL / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(benchmark_process, ev, data)
+{
+  static clock_time_t start;
+  unsigned long list_time, dlist_time;
+  volatile unsigned long sum;
+  int i, op, n;
+
+  PROCESS_BEGIN();
+
+  printf("%lu operations per measurement, times in ns per operation\n",
+         BENCHMARK_OPERATIONS);
+  printf("%-8s %6s %10s %10s\n", "op", "length", "list", "dlist");
+
+  for(op = 0; op < OP_COUNT; op++) {
+    for(i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+      n = lengths[i];
+
+      fill(n);
+      start = clock_time();
+      sum = run_list(op, n);
+      list_time = elapsed_us(start);
+
+      start = clock_time();
+      sum += run_dlist(op, n);
+      dlist_time = elapsed_us(start);
+
+      if(list_length(slist) != n || dlist_length(dlist) != n) {
+        printf("list length mismatch\n");
+      }
+
+      printf("%-8s %6d %10lu %10lu\n", operation_names[op], n,
+             list_time * 1000 / BENCHMARK_OPERATIONS,
+             dlist_time * 1000 / BENCHMARK_OPERATIONS);
+    }
+  }
+  (void)sum;
+
+  printf("Benchmark done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
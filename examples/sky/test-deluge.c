@@ -81,8 +81,12 @@ PROCESS_THREAD(deluge_test_process, ev, data)
     process_exit(NULL);
   }
 
-  if(cfs_seek(fd, FILE_SIZE, CFS_SEEK_SET) != FILE_SIZE) {
-    printf("failed to seek to the end\n");
+  /* The same text is written at the end of the file, so that the
+     receivers can tell when the whole file has arrived. */
+  if(cfs_seek(fd, FILE_SIZE - sizeof(buf), CFS_SEEK_SET) !=
+     FILE_SIZE - sizeof(buf) ||
+     cfs_write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+    printf("failed to write the end of the file\n");
   }
 
   deluge_disseminate("test", node_id == SINK_ID);
@@ -103,6 +107,12 @@ PROCESS_THREAD(deluge_test_process, ev, data)
 	} else {
 	  printf("File contents: %s\n", buf);
 	}
+	if(cfs_seek(fd, FILE_SIZE - sizeof(buf), CFS_SEEK_SET) ==
+	   FILE_SIZE - sizeof(buf) &&
+	   cfs_read(fd, buf, sizeof(buf)) > 0) {
+	  buf[sizeof(buf) - 1] = '\0';
+	  printf("File tail: %s\n", buf);
+	}
 	cfs_close(fd);
       }
     }
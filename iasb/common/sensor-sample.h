@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *		notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *		notice, this list of conditions and the following disclaimer in the
+ *		documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *		may be used to endorse or promote products derived from this software
+ *		without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.	IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Conversion of the sensor board readings to and from the
+ *         integer fields used by the sample-batch app.
+ */
+
+#ifndef SENSOR_SAMPLE_H_
+#define SENSOR_SAMPLE_H_
+
+#include "i2c_sensors_interface.h"
+
+/* Temperature in 1/100 C, luminosity in lux and acceleration in
+   1/100 g for each axis. */
+#define SENSOR_SAMPLE_FIELDS 5
+
+#define SENSOR_SAMPLE_SIGNED(sign, integral, fractional)		\
+  ((int16_t)((sign) ? -((integral) * 100 + (fractional)) :		\
+	     ((integral) * 100 + (fractional))))
+
+static inline void
+sensor_sample_pack(int16_t *fields, const temperature_t *temp,
+		   const luminosity_t *lumi, const acceleration_t *accel)
+{
+  fields[0] = SENSOR_SAMPLE_SIGNED(temp->sign, temp->integralDigit,
+				   temp->fractionalDigit);
+  fields[1] = (int16_t)*lumi;
+  fields[2] = SENSOR_SAMPLE_SIGNED(accel->acc_x_sign, accel->acc_x_integral,
+				   accel->acc_x_fractional);
+  fields[3] = SENSOR_SAMPLE_SIGNED(accel->acc_y_sign, accel->acc_y_integral,
+				   accel->acc_y_fractional);
+  fields[4] = SENSOR_SAMPLE_SIGNED(accel->acc_z_sign, accel->acc_z_integral,
+				   accel->acc_z_fractional);
+}
+
+static inline void
+sensor_sample_unpack(const int16_t *fields, temperature_t *temp,
+		     luminosity_t *lumi, acceleration_t *accel)
+{
+  int16_t v;
+
+  v = fields[0];
+  temp->sign = v < 0;
+  v = v < 0 ? -v : v;
+  temp->integralDigit = v / 100;
+  temp->fractionalDigit = v % 100;
+
+  *lumi = (luminosity_t)(uint16_t)fields[1];
+
+  v = fields[2];
+  accel->acc_x_sign = v < 0;
+  v = v < 0 ? -v : v;
+  accel->acc_x_integral = v / 100;
+  accel->acc_x_fractional = v % 100;
+
+  v = fields[3];
+  accel->acc_y_sign = v < 0;
+  v = v < 0 ? -v : v;
+  accel->acc_y_integral = v / 100;
+  accel->acc_y_fractional = v % 100;
+
+  v = fields[4];
+  accel->acc_z_sign = v < 0;
+  v = v < 0 ? -v : v;
+  accel->acc_z_integral = v / 100;
+  accel->acc_z_fractional = v % 100;
+}
+
+#endif /* SENSOR_SAMPLE_H_ */
@@ -4,6 +4,8 @@
 #include "twi_master.h"
 #include "io_access.h"
 #include "sensors.h"
+#include "sample-batch.h"
+#include "sensor-sample.h"
 #include <stdio.h>
 #include <util/delay.h>
 
@@ -14,8 +16,18 @@ struct unicast_message {
   acceleration_t accel;
 };
 
+/* Readings are sent in batches of SAMPLES_PER_BATCH, or after
+   BATCH_DEADLINE if fewer have been collected by then. */
+#ifndef SAMPLES_PER_BATCH
+#define SAMPLES_PER_BATCH 6
+#endif
+#ifndef BATCH_DEADLINE
+#define BATCH_DEADLINE (120 * CLOCK_SECOND)
+#endif
+
 MEMB(sinkaddress, linkaddr_t, 1);
 static linkaddr_t *sink_addr;
+static struct sample_batch batch;
 
 /* These hold the broadcast and unicast structures, respectively. */
 static struct broadcast_conn broadcast;
@@ -72,6 +84,23 @@ static const struct unicast_callbacks unicast_callbacks = {recv_uc};
 
 /*---------------------------------------------------------------------------*/
 
+/* This function is called by the sample batch when a frame is ready. */
+static void
+send_batch(struct sample_batch *b, const uint8_t *frame, int len)
+{
+  if(sink_addr == 0) {
+    return;
+  }
+  printf("Sending data!\n");
+  printf("BATCH %lu samples in %lu packets, %lu bytes\n",
+         b->stats.samples, b->stats.frames, b->stats.bytes);
+
+  packetbuf_copyfrom(frame, len);
+  unicast_send(&unicast, sink_addr);
+}
+
+/*---------------------------------------------------------------------------*/
+
 PROCESS_THREAD(broadcast_process, ev, data)
 {
 
@@ -112,11 +141,14 @@ PROCESS_THREAD(unicast_process, ev, data)
   led_set(LED_0, LED_ON);
 
   unicast_open(&unicast, 146, &unicast_callbacks);
+  sample_batch_init(&batch, SENSOR_SAMPLE_FIELDS, SAMPLES_PER_BATCH,
+                    BATCH_DEADLINE, send_batch);
 
   /* initiliaze memory block for holding the sink address */
   memb_init(&sinkaddress);
 
   static struct unicast_message msg;
+  static int16_t fields[SENSOR_SAMPLE_FIELDS];
   static struct etimer et;
   etimer_set(&et, CLOCK_SECOND * 17);
 
@@ -148,10 +180,8 @@ PROCESS_THREAD(unicast_process, ev, data)
       while(BMA150_GetAcceleration(&msg.accel));
       while(BMA150_PowerDown());
 
-      printf("Sending data!\n");
-
-      packetbuf_copyfrom(&msg, sizeof(msg));
-      unicast_send(&unicast, sink_addr);
+      sensor_sample_pack(fields, &msg.temp, &msg.lumi, &msg.accel);
+      sample_batch_add(&batch, fields);
     }
     etimer_reset(&et);
   }
@@ -2,6 +2,8 @@
 #include "net/rime/rime.h"
 #include "i2c_sensors_interface.h"
 #include "io_access.h"
+#include "sample-batch.h"
+#include "sensor-sample.h"
 #include <stdio.h>
 #include <util/delay.h>
 
@@ -69,14 +71,27 @@ static const struct broadcast_callbacks broadcast_call = {broadcast_recv};
 static void
 recv_uc(struct unicast_conn *c, const linkaddr_t *from)
 {
-  struct unicast_message *msg;
-
-  /* Grab the pointer to the incoming data. */
-  msg = packetbuf_dataptr();
+  static unsigned long samples, packets;
+  struct sample_batch_reader reader;
+  int16_t fields[SENSOR_SAMPLE_FIELDS];
+  struct unicast_message msg;
 
   printf("\n");
   printf("   DATA FROM   %d,%d   \n", from->u8[0], from->u8[1]);
-  print_results(&msg->temp, &msg->lumi, &msg->accel);
+
+  /* Each packet carries a batch of readings. */
+  if(sample_batch_reader_init(&reader, packetbuf_dataptr(),
+                              packetbuf_datalen(), SENSOR_SAMPLE_FIELDS) < 0) {
+    printf("   malformed batch\n");
+    return;
+  }
+  packets++;
+  while(sample_batch_read(&reader, fields)) {
+    samples++;
+    sensor_sample_unpack(fields, &msg.temp, &msg.lumi, &msg.accel);
+    print_results(&msg.temp, &msg.lumi, &msg.accel);
+  }
+  printf("   BATCH %lu samples in %lu packets\n", samples, packets);
 
 }
 static const struct unicast_callbacks unicast_callbacks = {recv_uc};
@@ -40,6 +40,8 @@
 #include "io_access.h"
 #include "i2c_sensors_interface.h"
 #include "twi_master.h"
+#include "sample-batch.h"
+#include "sensor-sample.h"
 #include <util/delay.h>
 #include <stdio.h>
 #include <string.h>
@@ -61,8 +63,18 @@
 #define SEND_TIME       SEND_INTERVAL
 #define MAX_PAYLOAD_LEN	30
 
+/* Readings are sent in batches of SAMPLES_PER_BATCH, or after
+   BATCH_DEADLINE if fewer have been collected by then. */
+#ifndef SAMPLES_PER_BATCH
+#define SAMPLES_PER_BATCH	6
+#endif
+#ifndef BATCH_DEADLINE
+#define BATCH_DEADLINE	(60 * CLOCK_SECOND)
+#endif
+
 static struct uip_udp_conn *client_conn;
 static uip_ipaddr_t server_ipaddr;
+static struct sample_batch batch;
 
 /* This is the structure of messages. */
 struct message {
@@ -94,6 +106,7 @@ send_packet(void *ptr)
 //	char buf[MAX_PAYLOAD_LEN];
 
 	static struct message msg;
+	int16_t fields[SENSOR_SAMPLE_FIELDS];
 
 	seq_id++;
 
@@ -118,14 +131,21 @@ send_packet(void *ptr)
     while(BMA150_GetAcceleration(&msg.accel));
     while(BMA150_PowerDown());
 
-//    char* message = (char *)msg;
-//    message[strlen(message)] =
+	PRINTF("DATA %d sampled\n", seq_id);
 
-	PRINTF("DATA %d send to ", seq_id);
+	sensor_sample_pack(fields, &msg.temp, &msg.lumi, &msg.accel);
+	sample_batch_add(&batch, fields);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_batch(struct sample_batch *b, const uint8_t *frame, int len)
+{
+	PRINTF("DATA batch of %u bytes send to ", len);
 	PRINT6ADDR(server_ipaddr.u8);
 	PRINTF("\n");
-//	sprintf(buf, "Hello %d from the client", seq_id);
-	uip_udp_packet_sendto(client_conn, &msg, sizeof(msg), &server_ipaddr, UIP_HTONS(UDP_SERVER_PORT));
+	PRINTF("BATCH %lu samples in %lu packets, %lu bytes\n",
+	       b->stats.samples, b->stats.frames, b->stats.bytes);
+	uip_udp_packet_sendto(client_conn, frame, len, &server_ipaddr, UIP_HTONS(UDP_SERVER_PORT));
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -214,6 +234,9 @@ PROCESS_THREAD(udp_client_process, ev, data)
 	}
 	udp_bind(client_conn, UIP_HTONS(UDP_CLIENT_PORT)); 
 
+	sample_batch_init(&batch, SENSOR_SAMPLE_FIELDS, SAMPLES_PER_BATCH,
+			  BATCH_DEADLINE, send_batch);
+
 	PRINTF("Created a connection with the server ");
 	PRINT6ADDR(&client_conn->ripaddr);
 	PRINTF(" local/remote port %u/%u\n",
@@ -38,6 +38,8 @@
 
 #include "io_access.h"
 #include "i2c_sensors_interface.h"
+#include "sample-batch.h"
+#include "sensor-sample.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -98,14 +100,27 @@ static void print_results(const temperature_t* temp, const luminosity_t* lumi, c
 static void
 tcpip_handler(void)
 {
-	struct message *msg;
+	static unsigned long samples, packets;
+	struct sample_batch_reader reader;
+	int16_t fields[SENSOR_SAMPLE_FIELDS];
+	struct message msg;
 
 	if(uip_newdata()) {
-		msg = uip_appdata;
 		PRINTF("   DATA received from ");
 		PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
 		PRINTF("\n");
-		print_results(&msg->temp, &msg->lumi, &msg->accel);
+		if(sample_batch_reader_init(&reader, uip_appdata, uip_datalen(),
+					    SENSOR_SAMPLE_FIELDS) < 0) {
+			PRINTF("   malformed batch\n");
+			return;
+		}
+		packets++;
+		while(sample_batch_read(&reader, fields)) {
+			samples++;
+			sensor_sample_unpack(fields, &msg.temp, &msg.lumi, &msg.accel);
+			print_results(&msg.temp, &msg.lumi, &msg.accel);
+		}
+		PRINTF("   BATCH %lu samples in %lu packets\n", samples, packets);
 		PRINTF("\n");
 	}
 }
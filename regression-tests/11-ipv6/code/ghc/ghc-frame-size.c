@@ -0,0 +1,369 @@
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ipv6/sicslowpan-ghc.h"
+#include "net/llsec/llsec.h"
+#include "net/rime/rime.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Sends typical RPL, ND and CoAP messages through 6LoWPAN and prints
+ * the size of the frames they take. The frames are captured below
+ * 6LoWPAN, fed back into it and checked to decompress to the packet
+ * that was sent. Build with DEFINES=GHC=1 to compress the ICMPv6 and
+ * UDP payloads with GHC, and with DEFINES=GHC=0 for the sizes
+ * without it.
+ */
+
+#define UIP_IP_BUF   ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_ICMP_BUF ((struct uip_icmp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+#define UIP_UDP_BUF  ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+
+#define MAX_FRAMES 4
+
+static uint8_t frames[MAX_FRAMES][PACKETBUF_SIZE];
+static uint16_t frame_len[MAX_FRAMES];
+static uint8_t nframes;
+static uint8_t capturing;
+
+static uint8_t sent_packet[UIP_BUFSIZE];
+static uint16_t sent_len;
+static uint8_t received, received_ok;
+
+static const uip_lladdr_t node_lladdr =
+  {{0x00, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01}};
+static const uip_lladdr_t neighbor_lladdr =
+  {{0x00, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02}};
+static const uint8_t context_prefix[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0};
+
+static const uint8_t dio[] = {
+  155, 1, 0, 0, 0x1e, 0xf0, 0x02, 0x00, 0x88, 0x00, 0x00, 0x00,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+  /* DAG configuration */
+  0x04, 0x0e, 0x00, 0x08, 0x0c, 0x00, 0x04, 0x00, 0x01, 0x00, 0x00, 0x1e, 0x00, 0x3c,
+  /* Prefix information */
+  0x08, 0x1e, 0x40, 0x40, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+};
+/* Offset of the prefix information option in dio */
+#define DIO_PIO_OFFSET 42
+#define DIO_PIO_LEN    32
+
+static const uint8_t dao[] = {
+  155, 2, 0, 0, 0x1e, 0x40, 0x00, 0x07,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+  /* Target */
+  0x05, 0x12, 0x00, 0x80, 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02,
+  /* Transit information */
+  0x06, 0x04, 0x00, 0x00, 0x00, 0x1e,
+};
+static const uint8_t dao_nonstoring[] = {
+  155, 2, 0, 0, 0x1e, 0x40, 0x00, 0x07,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+  /* Target */
+  0x05, 0x12, 0x00, 0x80, 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x03, 0, 0x03, 0x03, 0x03,
+  /* Transit information with the parent address */
+  0x06, 0x14, 0x00, 0x00, 0x00, 0x1e, 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02,
+};
+static const uint8_t dis[] = { 155, 0, 0, 0, 0, 0 };
+static const uint8_t ns[] = {
+  135, 0, 0, 0, 0, 0, 0, 0,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+  /* Source link-layer address */
+  1, 2, 0x00, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02, 0, 0, 0, 0, 0, 0,
+};
+static const uint8_t na[] = {
+  136, 0, 0, 0, 0x60, 0, 0, 0,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01,
+  /* Target link-layer address */
+  2, 2, 0x00, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01, 0, 0, 0, 0, 0, 0,
+};
+static const uint8_t ra[] = {
+  134, 0, 0, 0, 64, 0, 0x07, 0x08, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* Prefix information */
+  3, 4, 64, 0xc0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 0,
+  0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* Source link-layer address */
+  1, 2, 0x00, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01, 0, 0, 0, 0, 0, 0,
+  /* MTU */
+  5, 1, 0, 0, 0, 0, 0x05, 0xdc,
+  /* 6LoWPAN context */
+  34, 2, 64, 0x10, 0, 0, 0xff, 0xff, 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+};
+static const uint8_t echo[] = {
+  128, 0, 0, 0, 0x12, 0x34, 0, 1,
+  'h', 'e', 'l', 'l', 'o', ' ', 'h', 'e', 'l', 'l', 'o', ' ',
+  'h', 'e', 'l', 'l', 'o'
+};
+/* A CoAP resource directory registration */
+static const uint8_t coap[] = {
+  0x16, 0x33, 0x16, 0x33, 0, 0, 0, 0,
+  0x44, 0x02, 0x12, 0x34, 0xab, 0xcd, 0xef, 0x01,
+  0xb2, 'r', 'd', 0x47, 'e', 'p', '=', 'n', 'o', 'd', 'e', 0x28, 0x39, 0xff,
+  '<', '/', 's', 'e', 'n', 's', 'o', 'r', 's', '/', 't', 'e', 'm', 'p', '>',
+  ';', 'r', 't', '=', '"', 't', 'e', 'm', 'p', '"', ',',
+  '<', '/', 's', 'e', 'n', 's', 'o', 'r', 's', '/', 'h', 'u', 'm', '>',
+  ';', 'r', 't', '=', '"', 'h', 'u', 'm', '"'
+};
+/* A DIO with three prefix information options */
+static uint8_t big_dio[sizeof(dio) + 2 * DIO_PIO_LEN];
+
+struct message {
+  const char *name;
+  const char *src;
+  const char *dest;
+  uint8_t proto;
+  const uint8_t *payload;
+  uint16_t len;
+};
+
+static const struct message messages[] = {
+  { "RPL DIO", "fe80::212:7401:1:101", "ff02::1a",
+    UIP_PROTO_ICMP6, dio, sizeof(dio) },
+  { "RPL DAO storing", "fe80::212:7401:1:101", "fe80::212:7402:2:202",
+    UIP_PROTO_ICMP6, dao, sizeof(dao) },
+  { "RPL DAO non-storing", "2001:db8::212:7403:3:303", "2001:db8::212:7401:1:101",
+    UIP_PROTO_ICMP6, dao_nonstoring, sizeof(dao_nonstoring) },
+  { "RPL DIS", "fe80::212:7401:1:101", "ff02::1a",
+    UIP_PROTO_ICMP6, dis, sizeof(dis) },
+  { "ND NS", "2001:db8::212:7402:2:202", "2001:db8::212:7401:1:101",
+    UIP_PROTO_ICMP6, ns, sizeof(ns) },
+  { "ND NA", "2001:db8::212:7401:1:101", "2001:db8::212:7402:2:202",
+    UIP_PROTO_ICMP6, na, sizeof(na) },
+  { "ND RA", "fe80::212:7401:1:101", "ff02::1",
+    UIP_PROTO_ICMP6, ra, sizeof(ra) },
+  { "ICMPv6 echo", "2001:db8::212:7401:1:101", "2001:db8::212:7402:2:202",
+    UIP_PROTO_ICMP6, echo, sizeof(echo) },
+  { "CoAP RD POST", "2001:db8::212:7401:1:101", "2001:db8::1",
+    UIP_PROTO_UDP, coap, sizeof(coap) },
+  { "RPL DIO 3 prefixes", "fe80::212:7401:1:101", "ff02::1a",
+    UIP_PROTO_ICMP6, big_dio, sizeof(big_dio) },
+};
+/*---------------------------------------------------------------------------*/
+static void
+capture_bootstrap(llsec_on_bootstrapped_t on_bootstrapped)
+{
+  if(on_bootstrapped != NULL) {
+    on_bootstrapped();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+capture_send(mac_callback_t sent, void *ptr)
+{
+  if(capturing && nframes < MAX_FRAMES) {
+    memcpy(frames[nframes], packetbuf_dataptr(), packetbuf_datalen());
+    frame_len[nframes] = packetbuf_datalen();
+    nframes++;
+  }
+  mac_call_sent_callback(sent, ptr, MAC_TX_OK, 1);
+}
+/*---------------------------------------------------------------------------*/
+static int
+capture_on_frame_created(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+capture_input(void)
+{
+  NETSTACK_NETWORK.input();
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+capture_get_overhead(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const struct llsec_driver capture_llsec_driver = {
+  "capture",
+  capture_bootstrap,
+  capture_send,
+  capture_on_frame_created,
+  capture_input,
+  capture_get_overhead
+};
+/*---------------------------------------------------------------------------*/
+/* Called by 6LoWPAN with the decompressed packet in uip_buf */
+static void
+sniffer_input(void)
+{
+  received = 1;
+  received_ok = uip_len == sent_len &&
+    memcmp(UIP_IP_BUF, sent_packet, sent_len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_output(int mac_status)
+{
+}
+/*---------------------------------------------------------------------------*/
+RIME_SNIFFER(sniffer, sniffer_input, sniffer_output);
+/*---------------------------------------------------------------------------*/
+static void
+send_message(const struct message *m)
+{
+  const uip_lladdr_t *dest_lladdr;
+  uint8_t i;
+  int total;
+
+  memset(UIP_IP_BUF, 0, UIP_IPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->proto = m->proto;
+  UIP_IP_BUF->ttl = 255;
+  UIP_IP_BUF->len[0] = m->len >> 8;
+  UIP_IP_BUF->len[1] = m->len & 0xff;
+  uiplib_ip6addrconv(m->src, &UIP_IP_BUF->srcipaddr);
+  uiplib_ip6addrconv(m->dest, &UIP_IP_BUF->destipaddr);
+  memcpy(&uip_buf[UIP_LLIPH_LEN], m->payload, m->len);
+  uip_len = UIP_IPH_LEN + m->len;
+  if(m->proto == UIP_PROTO_ICMP6) {
+    UIP_ICMP_BUF->icmpchksum = 0;
+    UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+  } else {
+    UIP_UDP_BUF->udplen = UIP_HTONS(m->len);
+    UIP_UDP_BUF->udpchksum = 0;
+    UIP_UDP_BUF->udpchksum = ~uip_udpchksum();
+  }
+  memcpy(sent_packet, UIP_IP_BUF, uip_len);
+  sent_len = uip_len;
+
+  dest_lladdr = uip_is_addr_mcast(&UIP_IP_BUF->destipaddr) ?
+    NULL : &neighbor_lladdr;
+
+  nframes = 0;
+  capturing = 1;
+  tcpip_output(dest_lladdr);
+  capturing = 0;
+
+  /* Receive the frames as the neighbor would */
+  received = received_ok = 0;
+  total = 0;
+  for(i = 0; i < nframes; i++) {
+    total += frame_len[i];
+    packetbuf_clear();
+    packetbuf_copyfrom(frames[i], frame_len[i]);
+    packetbuf_set_addr(PACKETBUF_ADDR_SENDER, (linkaddr_t *)&node_lladdr);
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest_lladdr == NULL ?
+                       &linkaddr_null : (linkaddr_t *)dest_lladdr);
+    NETSTACK_LLSEC.input();
+  }
+
+  printf("Frames %s: %d bytes in %u frames, round trip %s\n",
+         m->name, total, nframes, received && received_ok ? "ok" : "FAILED");
+}
+/*---------------------------------------------------------------------------*/
+static int
+codec_fuzz(uint16_t rounds)
+{
+  static uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+  static uint8_t data[160], code[240], out[160];
+  uint16_t i, len, j;
+  int r, failures;
+
+  failures = 0;
+  for(i = 0; i < rounds; i++) {
+    len = random_rand() % sizeof(data);
+    for(j = 0; j < len; j++) {
+      switch(random_rand() % 3) {
+      case 0:
+        data[j] = 0;
+        break;
+      case 1:
+        data[j] = j > 8 ? data[j - 1 - random_rand() % 8] : random_rand();
+        break;
+      default:
+        data[j] = random_rand();
+        break;
+      }
+    }
+    for(j = 0; j < sizeof(dict); j++) {
+      dict[j] = random_rand() % 3;
+    }
+    r = sicslowpan_ghc_compress(dict, data, len, code, sizeof(code));
+    if(r < 0 ||
+       sicslowpan_ghc_uncompress(dict, code, r, out, sizeof(out)) != len ||
+       memcmp(data, out, len) != 0) {
+      failures++;
+    }
+  }
+  return failures;
+}
+/*---------------------------------------------------------------------------*/
+/* Copies of the payload length in the dictionary must be rejected,
+   copies of the bytes next to it must not. */
+static int
+codec_hole(void)
+{
+  /* Two bytes from dictionary offset 32, then from offset 30 */
+  static const uint8_t length_ref[] = { 0xa2, 0xc6 };
+  static const uint8_t before_ref[] = { 0xa3, 0xc0 };
+  static uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+  uint8_t out[2];
+  uint8_t j;
+  int failures;
+
+  for(j = 0; j < sizeof(dict); j++) {
+    dict[j] = j + 1;
+  }
+  failures = 0;
+  if(sicslowpan_ghc_uncompress(dict, length_ref, sizeof(length_ref),
+                               out, sizeof(out)) != -1) {
+    failures++;
+  }
+  if(sicslowpan_ghc_uncompress(dict, before_ref, sizeof(before_ref),
+                               out, sizeof(out)) != 2 ||
+     memcmp(out, dict + 30, 2) != 0) {
+    failures++;
+  }
+  return failures;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(ghc_frame_size_process, "GHC frame size");
+AUTOSTART_PROCESSES(&ghc_frame_size_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ghc_frame_size_process, ev, data)
+{
+  static struct etimer et;
+  static uint8_t i;
+
+  PROCESS_BEGIN();
+
+  /* The addresses in the messages are derived from these link-layer
+     addresses and from context 0. */
+  memcpy(&uip_lladdr, &node_lladdr, sizeof(uip_lladdr));
+  linkaddr_set_node_addr((linkaddr_t *)&node_lladdr);
+  sicslowpan_context_set(0, context_prefix, 64, 1,
+                         SICSLOWPAN_CONTEXT_INFINITE_LIFETIME);
+  rime_sniffer_add(&sniffer);
+
+  memcpy(big_dio, dio, sizeof(dio));
+  memcpy(big_dio + sizeof(dio), dio + DIO_PIO_OFFSET, DIO_PIO_LEN);
+  big_dio[sizeof(dio) + 16] = 0x20;
+  memcpy(big_dio + sizeof(dio) + DIO_PIO_LEN, dio + DIO_PIO_OFFSET,
+         DIO_PIO_LEN);
+  big_dio[sizeof(dio) + DIO_PIO_LEN + 19] = 0x01;
+
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+#if SICSLOWPAN_CONF_GHC
+  printf("GHC on\n");
+#else /* SICSLOWPAN_CONF_GHC */
+  printf("GHC off\n");
+#endif /* SICSLOWPAN_CONF_GHC */
+  for(i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+    send_message(&messages[i]);
+  }
+  printf("Codec fuzz failures %d\n", codec_fuzz(1000));
+  printf("Codec hole failures %d\n", codec_hole());
+  printf("DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,13 @@
+/* Frames are captured below 6LoWPAN instead of being sent */
+#undef NETSTACK_CONF_LLSEC
+#define NETSTACK_CONF_LLSEC capture_llsec_driver
+
+#undef SICSLOWPAN_CONF_FRAG
+#define SICSLOWPAN_CONF_FRAG 1
+
+#ifdef GHC
+#undef SICSLOWPAN_CONF_GHC
+#define SICSLOWPAN_CONF_GHC GHC
+#undef SICSLOWPAN_CONF_GHC_UDP
+#define SICSLOWPAN_CONF_GHC_UDP GHC
+#endif /* GHC */
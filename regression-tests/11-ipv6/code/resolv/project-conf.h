@@ -0,0 +1,2 @@
+#undef UIP_CONF_RESOLV_ENTRIES
+#define UIP_CONF_RESOLV_ENTRIES 6
@@ -0,0 +1,285 @@
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/ip/resolv.h"
+#include "net/ip/uip-nameserver.h"
+#include "net/ipv6/uip-ds6.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Resolves names against a DNS server stub that runs on the node
+ * itself. The stub takes the queries from the IPv6 output function
+ * and feeds its answers back to the stack as received packets. The
+ * test checks that concurrent queries for the same name are sent
+ * once, that record TTLs are decoded and expire, that NXDOMAIN ends a
+ * query and that a lost query is retried.
+ */
+
+#define UIP_IP_BUF  ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+#define DNS_DATA    (&uip_buf[UIP_LLIPH_LEN + UIP_UDPH_LEN])
+
+#define DNS_HEADER_LEN 12
+#define MAX_REPLIES    8
+#define MAX_REPLY_LEN  128
+
+struct stub_name {
+  const char *name;
+  /* Record TTL, or 0 for an NXDOMAIN answer */
+  uint32_t ttl;
+  /* Last byte of the address in the answer */
+  uint8_t addr;
+  /* Number of queries to drop before answering */
+  uint8_t drop;
+  uint8_t queries;
+};
+
+static struct stub_name stub_names[] = {
+  { "a.test", 300, 0x0a, 0, 0 },
+  { "b.test", 3, 0x0b, 0, 0 },
+  /* TTLs with the top bit set are taken as zero (RFC 2181) */
+  { "z.test", 0x80000005UL, 0x1a, 0, 0 },
+  { "nx.test", 0, 0, 0, 0 },
+  { "r.test", 60, 0x77, 1, 0 },
+};
+#define NUM_NAMES (sizeof(stub_names) / sizeof(stub_names[0]))
+
+static uint8_t replies[MAX_REPLIES][MAX_REPLY_LEN];
+static uint16_t reply_len[MAX_REPLIES];
+static uint8_t nreplies;
+static struct ctimer reply_timer;
+
+static uip_ipaddr_t server_addr;
+static const uip_lladdr_t server_lladdr =
+  {{0x00, 0x12, 0x74, 0x53, 0x00, 0x53, 0x53, 0x53}};
+
+static uint8_t failures;
+/*---------------------------------------------------------------------------*/
+static struct stub_name *
+stub_find(const uint8_t *qname, uint16_t len)
+{
+  char name[32];
+  uint16_t i, n;
+  uint8_t label;
+
+  /* Convert the labels to a lower case dotted name */
+  n = 0;
+  for(i = 0; i < len && qname[i] != 0; i += label + 1) {
+    label = qname[i];
+    if(i + label >= len || n + label + 1 >= sizeof(name)) {
+      return NULL;
+    }
+    if(n > 0) {
+      name[n++] = '.';
+    }
+    memcpy(&name[n], &qname[i + 1], label);
+    n += label;
+  }
+  for(i = 0; i < n; i++) {
+    if(name[i] >= 'A' && name[i] <= 'Z') {
+      name[i] += 'a' - 'A';
+    }
+  }
+  name[n] = 0;
+
+  for(i = 0; i < NUM_NAMES; i++) {
+    if(strcmp(name, stub_names[i].name) == 0) {
+      return &stub_names[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+deliver_replies(void *ptr)
+{
+  uint8_t i;
+
+  for(i = 0; i < nreplies; i++) {
+    memcpy(UIP_IP_BUF, replies[i], reply_len[i]);
+    uip_len = reply_len[i];
+    UIP_UDP_BUF->udpchksum = 0;
+    UIP_UDP_BUF->udpchksum = ~uip_udpchksum();
+    tcpip_input();
+  }
+  nreplies = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Takes the place of 6LoWPAN as the IPv6 output function */
+static uint8_t
+stub_output(const uip_lladdr_t *lladdr)
+{
+  struct uip_ip_hdr *ip;
+  struct uip_udp_hdr *udp;
+  struct stub_name *s;
+  uint8_t *reply, *dns, *p;
+  uint16_t qlen, len;
+
+  if(UIP_IP_BUF->proto != UIP_PROTO_UDP ||
+     UIP_UDP_BUF->destport != UIP_HTONS(53) ||
+     uip_len < UIP_IPUDPH_LEN + DNS_HEADER_LEN + 5 ||
+     nreplies == MAX_REPLIES) {
+    return 0;
+  }
+
+  /* The question: name, type and class */
+  dns = DNS_DATA;
+  qlen = uip_len - UIP_IPUDPH_LEN - DNS_HEADER_LEN;
+  s = stub_find(dns + DNS_HEADER_LEN, qlen);
+  if(s == NULL) {
+    printf("FAIL query for an unknown name\n");
+    failures++;
+    return 0;
+  }
+  s->queries++;
+  printf("Stub query %s #%u\n", s->name, s->queries);
+  if(s->queries <= s->drop) {
+    return 0;
+  }
+  if(UIP_IPUDPH_LEN + DNS_HEADER_LEN + qlen + 28 > MAX_REPLY_LEN) {
+    return 0;
+  }
+
+  reply = replies[nreplies];
+  ip = (struct uip_ip_hdr *)reply;
+  udp = (struct uip_udp_hdr *)&reply[UIP_IPH_LEN];
+  memcpy(reply, UIP_IP_BUF, UIP_IPUDPH_LEN);
+  uip_ipaddr_copy(&ip->srcipaddr, &UIP_IP_BUF->destipaddr);
+  uip_ipaddr_copy(&ip->destipaddr, &UIP_IP_BUF->srcipaddr);
+  udp->srcport = UIP_UDP_BUF->destport;
+  udp->destport = UIP_UDP_BUF->srcport;
+
+  p = &reply[UIP_IPUDPH_LEN];
+  memcpy(p, dns, DNS_HEADER_LEN + qlen);
+  /* Response, recursion desired and available, NXDOMAIN if no TTL */
+  p[2] = 0x81;
+  p[3] = s->ttl == 0 ? 0x83 : 0x80;
+  p[6] = 0;
+  p[7] = s->ttl == 0 ? 0 : 1;
+  p += DNS_HEADER_LEN + qlen;
+  if(s->ttl != 0) {
+    /* Name pointer to the question, type AAAA, class IN */
+    *p++ = 0xc0;
+    *p++ = DNS_HEADER_LEN;
+    *p++ = 0;
+    *p++ = 28;
+    *p++ = 0;
+    *p++ = 1;
+    *p++ = s->ttl >> 24;
+    *p++ = s->ttl >> 16;
+    *p++ = s->ttl >> 8;
+    *p++ = s->ttl;
+    *p++ = 0;
+    *p++ = 16;
+    memcpy(p, &server_addr, 15);
+    p[15] = s->addr;
+    p += 16;
+  }
+
+  len = p - reply;
+  ip->len[0] = (len - UIP_IPH_LEN) >> 8;
+  ip->len[1] = (len - UIP_IPH_LEN) & 0xff;
+  udp->udplen = UIP_HTONS(len - UIP_IPH_LEN);
+  reply_len[nreplies++] = len;
+
+  ctimer_set(&reply_timer, 1, deliver_replies, NULL);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(const char *name, resolv_status_t expected, uint8_t addr)
+{
+  uip_ipaddr_t *ipaddr;
+  resolv_status_t status;
+
+  status = resolv_lookup(name, &ipaddr);
+  if(status != expected ||
+     (status == RESOLV_STATUS_CACHED && ipaddr->u8[15] != addr)) {
+    printf("FAIL %s status %u, expected %u\n", name, status, expected);
+    failures++;
+  } else {
+    printf("Lookup %s status %u\n", name, status);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_queries(const char *name, uint8_t expected)
+{
+  uint8_t i;
+
+  for(i = 0; i < NUM_NAMES; i++) {
+    if(strcmp(stub_names[i].name, name) == 0 &&
+       stub_names[i].queries != expected) {
+      printf("FAIL %s was queried %u times, expected %u\n",
+             name, stub_names[i].queries, expected);
+      failures++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(resolv_test_process, "resolv test");
+AUTOSTART_PROCESSES(&resolv_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(resolv_test_process, ev, data)
+{
+  static struct etimer et;
+  static uint8_t found;
+
+  PROCESS_BEGIN();
+
+  /* There is no one to answer duplicate address detection */
+  uip_ds6_get_link_local(-1)->state = ADDR_PREFERRED;
+
+  uip_ip6addr(&server_addr, 0xfe80, 0, 0, 0, 0x212, 0x7453, 0x53, 0x5353);
+  uip_ds6_nbr_add(&server_addr, &server_lladdr, 0, NBR_REACHABLE);
+  uip_nameserver_update(&server_addr, UIP_NAMESERVER_INFINITE_LIFETIME);
+  tcpip_set_outputfunc(stub_output);
+
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  printf("Resolving\n");
+  resolv_query("a.test");
+  resolv_query("A.test");
+  resolv_query("b.test");
+  resolv_query("z.test");
+  resolv_query("nx.test");
+  resolv_query("r.test");
+  check("a.test", RESOLV_STATUS_RESOLVING, 0);
+
+  etimer_set(&et, 10 * CLOCK_SECOND);
+  found = 0;
+  while(found < NUM_NAMES) {
+    PROCESS_WAIT_EVENT();
+    if(ev == resolv_event_found) {
+      printf("Found %s\n", (char *)data);
+      found++;
+    } else if(ev == PROCESS_EVENT_TIMER && data == &et) {
+      printf("FAIL %u of %u names resolved\n", found, (unsigned)NUM_NAMES);
+      failures++;
+      break;
+    }
+  }
+
+  check("a.test", RESOLV_STATUS_CACHED, 0x0a);
+  check("b.test", RESOLV_STATUS_CACHED, 0x0b);
+  check("nx.test", RESOLV_STATUS_NOT_FOUND, 0);
+  check("r.test", RESOLV_STATUS_CACHED, 0x77);
+  check_queries("a.test", 1);
+  check_queries("nx.test", 1);
+  check_queries("r.test", 2);
+
+  /* Let the records with short TTLs expire */
+  etimer_set(&et, 5 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  check("a.test", RESOLV_STATUS_CACHED, 0x0a);
+  check("b.test", RESOLV_STATUS_EXPIRED, 0);
+  check("z.test", RESOLV_STATUS_EXPIRED, 0);
+
+  printf("%s\n", failures == 0 ? "TEST OK" : "TEST FAILED");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
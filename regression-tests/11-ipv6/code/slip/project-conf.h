@@ -0,0 +1,2 @@
+void slip_test_input(void);
+#define SLIP_CONF_TCPIP_INPUT slip_test_input
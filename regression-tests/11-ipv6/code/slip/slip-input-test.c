@@ -0,0 +1,127 @@
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "dev/slip.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Feeds SLIP frames to slip_input_byte() the way a UART interrupt
+ * handler does, and checks what the SLIP process passes on to the
+ * stack. Every byte of the largest frame must be escaped, so its
+ * encoding is twice its size, and all of it is in the receive buffer
+ * before the process gets to run.
+ */
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+#define MAX_FRAME_LEN (UIP_BUFSIZE - UIP_LLH_LEN)
+
+static uint8_t frame[MAX_FRAME_LEN];
+static uint16_t frame_len;
+static uint8_t received;
+static uint8_t failures;
+/*---------------------------------------------------------------------------*/
+#if CONTIKI_TARGET_NATIVE
+/* There is no serial line to write to */
+void
+slip_arch_writeb(unsigned char c)
+{
+}
+#endif /* CONTIKI_TARGET_NATIVE */
+/*---------------------------------------------------------------------------*/
+void
+slip_test_input(void)
+{
+  received++;
+  if(uip_len != frame_len ||
+     memcmp(&uip_buf[UIP_LLH_LEN], frame, frame_len) != 0) {
+    printf("FAIL received %u bytes, sent %u\n", uip_len, frame_len);
+    failures++;
+  } else {
+    printf("Received %u bytes\n", uip_len);
+  }
+  uip_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Sends the frame framed as slip_send() does. Returns the number of
+   bytes for which slip_input_byte() asked for a poll of the SLIP
+   process before the end of the frame. */
+static uint16_t
+send_frame(void)
+{
+  uint16_t i, polls;
+  uint8_t c;
+
+  slip_input_byte(SLIP_END);
+  polls = 0;
+  for(i = 0; i < frame_len; i++) {
+    c = frame[i];
+    if(c == SLIP_END || c == SLIP_ESC) {
+      polls += slip_input_byte(SLIP_ESC);
+      c = c == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC;
+    }
+    polls += slip_input_byte(c);
+  }
+  slip_input_byte(SLIP_END);
+  return polls;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(slip_input_test_process, "SLIP input test");
+AUTOSTART_PROCESSES(&slip_input_test_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(slip_input_test_process, ev, data)
+{
+  static struct etimer et;
+  uint16_t i, polls;
+
+  PROCESS_BEGIN();
+
+  process_start(&slip_process, NULL);
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  /* The largest frame, with every byte escaped */
+  for(i = 0; i < MAX_FRAME_LEN; i++) {
+    frame[i] = i & 1 ? SLIP_ESC : SLIP_END;
+  }
+  frame_len = MAX_FRAME_LEN;
+  printf("Sending %u escaped bytes\n", frame_len);
+  send_frame();
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  /* 'T' bytes in a frame that does not start with 'C' must not poll
+     the process */
+  memcpy(frame, "\x60\x00\x00\x00TTT\xc0\xdb", 9);
+  frame_len = 9;
+  polls = send_frame();
+  if(polls != 0) {
+    printf("FAIL %u polls inside the frame\n", polls);
+    failures++;
+  }
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  if(received != 2) {
+    printf("FAIL received %u frames, sent 2\n", received);
+    failures++;
+  }
+
+  /* The CLIENT hack still polls the process at its 'T' */
+  for(i = 0; i < 5; i++) {
+    slip_input_byte("CLIENT"[i]);
+  }
+  if(slip_input_byte('T') == 0) {
+    printf("FAIL CLIENT did not poll\n");
+    failures++;
+  }
+
+  printf("%s\n", failures == 0 ? "TEST OK" : "TEST FAILED");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/